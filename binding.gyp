@@ -10,14 +10,23 @@
         'sources': [ #Specify your source files here
             "src/pm.cc",
             "src/core/policymanager/PolicyManager.cpp",
+            "src/core/policymanager/RootPolicyManager.cpp",
             "src/core/policymanager/Condition.cpp",
             "src/core/policymanager/Globals.cpp",
             "src/core/policymanager/IPolicyBase.cpp",
             "src/core/policymanager/Policy.cpp",
             "src/core/policymanager/PolicySet.cpp",
+            "src/core/policymanager/DecisionCache.cpp",
+            "src/core/policymanager/EvaluationArena.cpp",
+            "src/core/policymanager/PolicyProgram.cpp",
+            "src/core/policymanager/PredicateTable.cpp",
+            "src/core/policymanager/ValueDictionary.cpp",
             "src/core/policymanager/Request.cpp",
+            "src/core/policymanager/RequestBuilder.cpp",
             "src/core/policymanager/Rule.cpp",
             "src/core/policymanager/Subject.cpp",
+            "src/core/policymanager/SubjectIndex.cpp",
+            "src/core/policymanager/ResourceIndex.cpp",
             "src/core/policymanager/AuthorizationsSet.cpp",
             "src/core/policymanager/DataHandlingPreferences.cpp",
             "src/core/policymanager/Obligation.cpp",
@@ -29,8 +38,10 @@
             "src/core/policymanager/PolicyDescriptor.cpp",
             "src/core/policymanager/PolicySetDescriptor.cpp",
             "src/core/common.cpp",
+            "src/core/matcher.cpp",
+            "src/core/mutex.cpp",
+            "src/core/threadpool.cpp",
             "contrib/xmltools/tinyxml.cpp",
-            "contrib/xmltools/slre.cpp",
             "contrib/xmltools/tinystr.cpp",
             "contrib/xmltools/tinyxmlparser.cpp",
             "contrib/xmltools/tinyxmlerror.cpp",
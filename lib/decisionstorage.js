@@ -78,17 +78,26 @@
 				peCoreSession[sessionIdInt] = new pe.policyEditor(decisionFileSession[sessionIdInt], pmCoreSession[sessionIdInt]);
 			}
 			var res = 5; // Undetermined
-			res = pmCorePermanent.enforceRequest(request);
+			//Marshal the request once for both stores
+			var nativeRequest = pmNativeLib.PolicyRequest ? new pmNativeLib.PolicyRequest(request) : request;
+			res = pmCorePermanent.enforceRequest(nativeRequest);
 			//console.log("Decision storage - checkDecision permanent returns "+res);
 			// res > 1 means no decision taken
 			if(res > 1) {
 				//console.log("Decision storage - checkDecision in session");
-				res = pmCoreSession[sessionIdInt].enforceRequest(request);
+				res = pmCoreSession[sessionIdInt].enforceRequest(nativeRequest);
 			}
 			return res;
 		}
 
 
+		// The decision files are parsed again off the JS thread: until then
+		// checkDecision answers with the decisions stored before
+		function decisionReloaded() {
+			//console.log("Decision storage - decisions reloaded");
+		}
+
+
 		this.addDecision = function(request, sessionId, decision, storage) {
 			//console.log("Decision storage - addDecision");
 			var sessionIdInt = sessionId;
@@ -104,7 +113,7 @@
 				//console.log("Decision storage - addDecision - permanent storage");
 				// storage == 0 is permanent storage
 				peCorePermanent.addRule(request, decision);
-				pmCorePermanent.reloadPolicy({});
+				pmCorePermanent.reloadPolicy({}, decisionReloaded);
 			}
 			else if (storage == 1) {
 				//console.log("Decision storage - addDecision - session storage");
@@ -114,7 +123,7 @@
 					return;
 				}
 				peCoreSession[sessionIdInt].addRule(request, decision);
-				pmCoreSession[sessionIdInt].reloadPolicy({});
+				pmCoreSession[sessionIdInt].reloadPolicy({}, decisionReloaded);
 			}
 			else {
 				console.log("Decision storage - wrong storage type");
@@ -62,15 +62,21 @@
         'http://webinos.org/subject/id/known': PzpAPI.getInstance().getTrustedList('pzh')
       }
 
+      // the policies are reloaded off the JS thread, requests keep being
+      // enforced with the previous subjects until then
+      var policyReloaded = function () {
+        console.log("Policy reloaded with the new PZ-Owner and known PZHs");
+      }
+
       var updateEnrollmentStatus = function () {
         self.genericURI['http://webinos.org/subject/id/PZ-Owner'] = getOwnerId();
         self.genericURI['http://webinos.org/subject/id/known'] = PzpAPI.getInstance().getTrustedList('pzh');
-        self.pmr.reloadPolicy(self.genericURI);
+        self.pmr.reloadPolicy(self.genericURI, policyReloaded);
       }
 
       var updateFriends = function () {
         self.genericURI['http://webinos.org/subject/id/known'] = PzpAPI.getInstance().getTrustedList('pzh');
-        self.pmr.reloadPolicy(self.genericURI);
+        self.pmr.reloadPolicy(self.genericURI, policyReloaded);
       }
     
       eventEmitter.on('updateEnrollmentStatus', updateEnrollmentStatus);
@@ -170,6 +176,17 @@
     result['effect'] = res;
     cb(result);
   }
+  // Effects of an array of requests, evaluated in one call as with
+  // noprompt: stored decisions are not looked up and nobody is prompted.
+  policyManager.prototype.enforceRequests = function(requests, cb) {
+    if (!this.pmr) {
+      console.log("Invalid policy file: requests denied")
+      cb(requests.map(function() { return 1; }));
+      return;
+    }
+    cb(this.pmr.enforceRequests(requests));
+  };
+
   policyManager.prototype.enforceRequest = function(request, sessionId, noprompt, cb) {
     if (!this.pmr) {
       console.log("Invalid policy file: request denied")
@@ -192,11 +209,14 @@
     }
   };
 
-  policyManager.prototype.reloadPolicy = function () {
+  // Without cb the edited policy is in use when the call returns, as
+  // callers that enforce right after editing expect. With cb it is
+  // reloaded off the JS thread and cb() called once it is in use.
+  policyManager.prototype.reloadPolicy = function (cb) {
     //TODO: at the moment validation of root policy file fails
 //    self.isAWellFormedPolicyFile(policyFile
 //      , function () {
-        this.pmr.reloadPolicy(self.genericURI);
+        this.pmr.reloadPolicy(self.genericURI, cb);
 //      }
 //      , function () {
 //        console.log("Policy file is not valid");
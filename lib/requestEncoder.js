@@ -0,0 +1,140 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *  
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *  
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * Copyright 2013 Telecom Italia SpA
+ * 
+ ******************************************************************************/
+
+// Binary encoding of a request for enforceRequestBuffer, so that the
+// native side reads one Buffer instead of walking the request object.
+// Layout (see src/core/policymanager/RequestBuilder.h): a version byte,
+// then for each value an attribute id byte, its length as LEB128 and its
+// bytes. A request with obligations cannot be encoded: encode returns null
+// and the caller is expected to use enforceRequest with the object.
+
+(function () {
+	"use strict";
+
+	var ENCODING_VERSION = 1;
+	var PURPOSE = 0xFF;
+	var PURPOSE_COUNT = 35;	// ontology_vector of AuthorizationsSet.h
+
+	// AttributeId values of src/core/policymanager/Globals.h
+	var attributeIds = {
+		resourceInfo: {
+			apiFeature: 19,
+			serviceId: 20,
+			deviceCap: 21,
+			paramFeature: 22
+		},
+		subjectInfo: {
+			userId: 0,
+			userKeyCn: 1,
+			userKeyFingerprint: 2,
+			userKeyRootCn: 3,
+			userKeyRootFingerprint: 4
+		},
+		widgetInfo: {
+			id: 5,
+			distributorKeyCn: 6,
+			distributorKeyFingerprint: 7,
+			distributorKeyRootCn: 8,
+			distributorKeyRootFingerprint: 9,
+			authorKeyCn: 10,
+			authorKeyFingerprint: 11,
+			authorKeyRootCn: 12,
+			authorKeyRootFingerprint: 13
+		},
+		deviceInfo: {
+			targetId: 14,
+			targetDomain: 15,
+			requestorId: 16,
+			requestorDomain: 17,
+			webinosEnabled: 18
+		},
+		environmentInfo: {
+			"profile": 25,
+			"timemin": 26,
+			"days-of-week": 27,
+			"days-of-month": 28
+		}
+	};
+
+	var lengthSize = function(length) {
+		var size = 1;
+		while (length >= 0x80) {
+			length = Math.floor(length / 0x80);
+			size++;
+		}
+		return size;
+	};
+
+	var writeRecord = function(buffer, offset, attr, value) {
+		var length = value.length;
+		buffer[offset++] = attr;
+		while (length >= 0x80) {
+			buffer[offset++] = (length & 0x7F) | 0x80;
+			length = Math.floor(length / 0x80);
+		}
+		buffer[offset++] = length;
+		// characters as the native side reads strings, one byte each
+		buffer.write(value, offset, value.length, "ascii");
+		return offset + value.length;
+	};
+
+	// Records of the request, in the order the native side reads them
+	var collect = function(request) {
+		var records = [];
+		for (var group in attributeIds) {
+			var info = request[group];
+			if (info === null || typeof info !== "object")
+				continue;
+			for (var property in attributeIds[group]) {
+				if (property in info)
+					records.push([attributeIds[group][property], String(info[property])]);
+			}
+		}
+		if ("purpose" in request) {
+			// a purpose that is not a full array denies every purpose
+			var purpose = "";
+			if (Array.isArray(request.purpose) && request.purpose.length === PURPOSE_COUNT) {
+				for (var i = 0; i < PURPOSE_COUNT; i++)
+					purpose += request.purpose[i] ? "\u0001" : "\u0000";
+			}
+			records.push([PURPOSE, purpose]);
+		}
+		return records;
+	};
+
+	var encode = function(request) {
+		if ("obligations" in request)
+			return null;
+
+		var records = collect(request);
+		var size = 1;
+		for (var i = 0; i < records.length; i++)
+			size += 1 + lengthSize(records[i][1].length) + records[i][1].length;
+
+		var buffer = new Buffer(size);
+		var offset = 0;
+		buffer[offset++] = ENCODING_VERSION;
+		for (var i = 0; i < records.length; i++)
+			offset = writeRecord(buffer, offset, records[i][0], records[i][1]);
+		return buffer;
+	};
+
+	exports.encode = encode;
+
+}());
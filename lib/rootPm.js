@@ -61,6 +61,8 @@
 
     var rootPm = function(rootPolicyFilename, info) {
         this.pmCore;
+        this.pmRoot;
+        this.pmRootApps;
         this.pmNativeLib;
         this.rootPolicy;
         this.includedPolicyFiles;
@@ -78,6 +80,7 @@
 
         loadIncludePolicy(this);
         loadPmCores(this);
+        loadPmRoot(this);
     };
 
 
@@ -147,54 +150,162 @@
     }
 
 
+    // The native root policy manager evaluates the whole root policy in a
+    // single call, with the pmCore instances below: files are parsed once
+    // and only the ones that passed the schema check are used. It is only
+    // used if every included file that exists passed it, otherwise
+    // evaluatePolicy is used instead. App files are set as they are loaded
+    // (see enforceRequest).
+    function loadPmRoot(pmInstance) {
+        pmInstance.pmRoot = null;
+        pmInstance.pmRootApps = {};
+        if(!pmInstance.pmNativeLib || !pmInstance.pmNativeLib.RootPolicyManagerInt) {
+            return;
+        }
+        for(var type in pmInstance.includedPolicyFiles) {
+            if(type != 'app' && existsSync(pmInstance.includedPolicyFiles[type]) && !pmInstance.pmCore[type]) {
+                return;
+            }
+        }
+        var pmRoot = new pmInstance.pmNativeLib.RootPolicyManagerInt(pmInstance.rootPolicyFile);
+        if(pmRoot.isValid()) {
+            for(var type in pmInstance.includedPolicyFiles) {
+                if(type != 'app' && pmInstance.pmCore[type]) {
+                    pmRoot.setPolicyManager(type, pmInstance.pmCore[type]);
+                }
+            }
+            pmInstance.pmRoot = pmRoot;
+        }
+    }
+
+
+    // pmCore of the app policy file of appId, loaded (and schema-checked)
+    // on first use; undefined if the file is missing or not valid
+    function loadAppPmCore(pmInstance, appId) {
+        if(!pmInstance.pmCore[appId]) {
+            var appFilename = appPolicyFilename(pmInstance, appId);
+            console.log('app filename is '+appFilename);
+            loadPmCore(pmInstance, appId, appFilename);
+        }
+        return pmInstance.pmCore[appId];
+    }
+
+
+    // app policy file of appId: the included "app" file name with _appId
+    // before its extension
+    function appPolicyFilename(pmInstance, appId) {
+        var parts = pmInstance.includedPolicyFiles['app'].split('.');
+        var appFilename = parts[0];
+        for(var i=1; i<parts.length-1; i++) {
+            appFilename += '.'+parts[i];
+        }
+        appFilename += '_'+appId+'.'+parts[parts.length-1];
+        return appFilename;
+    }
+
+
     function loadPmCore(pmInstance, type, filename) {
         console.log('loadPmCore - '+type+' - '+filename);
         //Check if policy file exists
         if(existsSync(filename)) {
-            var crypto, dataHash, data = fs.readFileSync(filename);
-            try { crypto = require("crypto"); } catch(e) { console.log ("Cannot load module 'crypto'"); }
-
-            if(crypto) {
-                dataHash = crypto.createHash("md5").update(data).digest("hex");
+            if (checkPolicyFile(filename)) {
+                pmInstance.pmCore[type] = new pmInstance.pmNativeLib.PolicyManagerInt(filename, pip);
+                var matchErrors = pmInstance.pmCore[type].getMatchErrors();
+                for (var i = 0; i < matchErrors.length; i++) {
+                    console.log('Policy match value never matches in ' + filename + ': ' + matchErrors[i]);
+                }
             }
+        }
+        else {
+            console.log('Policy file does not exist: '+filename);
+        }
+    }
 
-            xmlParser.parseString(data, function (err, jsonData) {
-                if (!err) {
 
-                    var checkNeeded = true;
-                    var policyWellFormatted = false;
+    // true if the existing policy file filename passes the schema check;
+    // the md5 of a file that passed is stored next to it, so that the
+    // check is not repeated until the file changes
+    function checkPolicyFile(filename) {
+        var crypto, dataHash, data = fs.readFileSync(filename);
+        var policyWellFormatted = false;
+        try { crypto = require("crypto"); } catch(e) { console.log ("Cannot load module 'crypto'"); }
 
-                    if (existsSync(filename + ".md5")) {
-                        if(fs.readFileSync(filename + ".md5") == dataHash) {
-                            checkNeeded = false;
-                            policyWellFormatted = true;
-                            console.log("Policy schema already checked");
-                        }
+        if(crypto) {
+            dataHash = crypto.createHash("md5").update(data).digest("hex");
+        }
+
+        xmlParser.parseString(data, function (err, jsonData) {
+            if (!err) {
+
+                var checkNeeded = true;
+
+                if (existsSync(filename + ".md5")) {
+                    if(fs.readFileSync(filename + ".md5") == dataHash) {
+                        checkNeeded = false;
+                        policyWellFormatted = true;
+                        console.log("Policy schema already checked");
                     }
-                    
-                    if (checkNeeded) {
-                        if(env.validate(jsonData, schema).errors.length === 0) {
-                            if (crypto) {
-                                fs.writeFileSync(filename + ".md5", dataHash);
-                            }
-                            policyWellFormatted = true;
-                            console.log("Policy has a valid schema");
-                        } else {
-                            policyWellFormatted = false;
-                            console.log('Policy file not valid: ' + filename);
+                }
+                
+                if (checkNeeded) {
+                    if(env.validate(jsonData, schema).errors.length === 0) {
+                        if (crypto) {
+                            fs.writeFileSync(filename + ".md5", dataHash);
                         }
+                        policyWellFormatted = true;
+                        console.log("Policy has a valid schema");
+                    } else {
+                        policyWellFormatted = false;
+                        console.log('Policy file not valid: ' + filename);
                     }
+                }
+            }
+        });
+        return policyWellFormatted;
+    }
 
-                    if (policyWellFormatted) {
-                        pmInstance.pmCore[type] = new pmInstance.pmNativeLib.PolicyManagerInt(filename, pip);
-                    }
+
+    // Reloads, off the JS thread, the pmCore instances of a root policy
+    // that did not change: every loaded file must still pass the schema
+    // check and no other included file may have started to. The instances
+    // are kept, so pmRoot still evaluates with them, and they keep serving
+    // requests with the previous policy until cb() is called. Returns
+    // false, without reloading anything, if the cores have to be rebuilt.
+    function reloadPmCoresAsync(pmInstance, previousRoot, previousFiles, cb) {
+        if(!pmInstance.pmCore || JSON.stringify(pmInstance.rootPolicy) != previousRoot ||
+                JSON.stringify(pmInstance.includedPolicyFiles) != previousFiles) {
+            return false;
+        }
+        for(var type in pmInstance.includedPolicyFiles) {
+            var filename = pmInstance.includedPolicyFiles[type];
+            if(type != 'app' && !pmInstance.pmCore[type] && existsSync(filename) && checkPolicyFile(filename)) {
+                return false;
+            }
+        }
+        var reloads = [];
+        for(var key in pmInstance.pmCore) {
+            // the keys that are not included files are app ids
+            var filename = (key != 'app' && pmInstance.includedPolicyFiles[key]) || appPolicyFilename(pmInstance, key);
+            if(!existsSync(filename) || !checkPolicyFile(filename)) {
+                return false;
+            }
+            reloads.push(pmInstance.pmCore[key]);
+        }
+        var pending = reloads.length;
+        if(pending == 0) {
+            process.nextTick(cb);
+        }
+        for(var i = 0; i < reloads.length; i++) {
+            reloads[i].reloadPolicy(pip, function() {
+                if(--pending == 0) {
+                    cb();
                 }
             });
         }
-        else {
-            console.log('Policy file does not exist: '+filename);
-        }
+        return true;
     }
+
+
     function testLoadIncludePolicy(pmInstance, mainPolicy) {
         console.log('loadIncludePolicy');
         pmInstance.includedPolicyFiles = {};
@@ -288,14 +399,16 @@
             return 1;
         }
         if(this.rootPolicy['policy-set']) {
-            var date = new Date();
-            if (!request["environmentInfo"]) {
-                request["environmentInfo"] = {};
+            setEnvironmentInfo(request, new Date());
+            if(this.pmRoot) {
+                setAppPmRoot(this, request);
+                res = this.pmRoot.enforceRequest(request);
+            }
+            else {
+                //Marshal the request once for all the included files
+                var nativeRequest = this.pmNativeLib.PolicyRequest ? new this.pmNativeLib.PolicyRequest(request) : request;
+                res = evaluatePolicy(this, this.rootPolicy['policy-set'], request, nativeRequest);
             }
-            request["environmentInfo"]["timemin"] = date.getHours()*60 + date.getMinutes();
-            request["environmentInfo"]["days-of-week"] = 1 << date.getDay(); //dayToDaysOfWeek(date.getDay());
-            request["environmentInfo"]["days-of-month"] = 1 << (date.getDate() - 1);
-            res = evaluatePolicy(this, this.rootPolicy['policy-set'], request);
         }
         //Monday   0000001
         //Tuesday  0000010
@@ -309,6 +422,59 @@
         return (res);
     };
 
+    // Effects of an array of requests, in a single native call when the
+    // root policy is evaluated natively (see loadPmRoot)
+    rootPm.prototype.enforceRequests = function(requests) {
+        if (policyGlobalVersionCounter != this.policyLocalVersionCounter){
+            console.log("Policy Enforcement: Detected version mismatch (Global = " + 
+                policyGlobalVersionCounter + " | Local = " + this.policyLocalVersionCounter+ ")" );
+
+            this.reloadPolicy();
+        }
+
+        var effects = [];
+        if(this.pmCore && this.rootPolicy['policy-set'] && this.pmRoot) {
+            var date = new Date();
+            for(var i = 0; i < requests.length; i++) {
+                setEnvironmentInfo(requests[i], date);
+                setAppPmRoot(this, requests[i]);
+            }
+            var res = this.pmRoot.enforceRequests(requests);
+            for(var i = 0; i < res.length; i++) {
+                effects.push(res[i]);
+            }
+        }
+        else {
+            for(var i = 0; i < requests.length; i++) {
+                effects.push(this.enforceRequest(requests[i]));
+            }
+        }
+        return effects;
+    };
+
+
+    function setEnvironmentInfo(request, date) {
+        if (!request["environmentInfo"]) {
+            request["environmentInfo"] = {};
+        }
+        request["environmentInfo"]["timemin"] = date.getHours()*60 + date.getMinutes();
+        request["environmentInfo"]["days-of-week"] = 1 << date.getDay(); //dayToDaysOfWeek(date.getDay());
+        request["environmentInfo"]["days-of-month"] = 1 << (date.getDate() - 1);
+    }
+
+
+    // sets on pmRoot the app policy of the application of request, if any
+    function setAppPmRoot(pmInstance, request) {
+        var appId = request.widgetInfo && request.widgetInfo.id;
+        if(appId && pmInstance.includedPolicyFiles['app'] && !pmInstance.pmRootApps[appId]) {
+            if(loadAppPmCore(pmInstance, appId)) {
+                pmInstance.pmRoot.setAppPolicyManager(appId, pmInstance.pmCore[appId]);
+                pmInstance.pmRootApps[appId] = true;
+            }
+        }
+    }
+
+
     function testPolicy(pmInstance, policy, request, path) {
         // Values returned by policy manager:
         // PERMIT = 0
@@ -400,7 +566,7 @@
         return(res);
     }
     
-    function evaluatePolicy(pmInstance, policy, request) {
+    function evaluatePolicy(pmInstance, policy, request, nativeRequest) {
         // Values returned by policy manager:
         // PERMIT = 0
         // DENY = 1
@@ -429,7 +595,7 @@
             //Evaluate policy-set
             if(policy['policy-set']) {
                 for(var j in policy['policy-set']) {
-                    resTmp = evaluatePolicy(pmInstance, policy['policy-set'][j], request);
+                    resTmp = evaluatePolicy(pmInstance, policy['policy-set'][j], request, nativeRequest);
                     res = LUTs[combAlg][res][resTmp];
                 }
             }
@@ -442,25 +608,15 @@
                         //If app id is specified then check app policy file
                         if(request.widgetInfo && request.widgetInfo.id) {
                             //If pmCore to handle app file is missing, then instance it
-                            if(!pmInstance.pmCore[request.widgetInfo.id]) {
-                                var parts = pmInstance.includedPolicyFiles['app'].split('.');
-                                var appFilename = parts[0];
-                                for(var i=1; i<parts.length-1; i++) {
-                                    appFilename += '.'+parts[i];
-                                }
-                                appFilename += '_'+request.widgetInfo.id+'.'+parts[parts.length-1];
-                                console.log('app filename is '+appFilename);
-                                loadPmCore(pmInstance, request.widgetInfo.id, appFilename);
-                            }
-                            if(pmInstance.pmCore[request.widgetInfo.id]) {
-                                resTmp = pmInstance.pmCore[request.widgetInfo.id].enforceRequest(request);
+                            if(loadAppPmCore(pmInstance, request.widgetInfo.id)) {
+                                resTmp = pmInstance.pmCore[request.widgetInfo.id].enforceRequest(nativeRequest);
                             }
                         }
                         //console.log('pm for app returned '+resTmp);
                     }
                     else {
                         if(pmInstance.pmCore[policy['extfile'][j]]) {
-                            resTmp = pmInstance.pmCore[policy['extfile'][j]].enforceRequest(request);
+                            resTmp = pmInstance.pmCore[policy['extfile'][j]].enforceRequest(nativeRequest);
                             //console.log('pm for '+policy['extfile'][j]+' returned '+resTmp);
                         }
                     }
@@ -482,12 +638,24 @@
         console.log("policyGlobalVersionCounter set to " + policyGlobalVersionCounter);
     };
 
-    rootPm.prototype.reloadPolicy = function (genericURI) {
+    // Without cb the new policies are in use when the call returns. With
+    // cb they are parsed off the JS thread if the root policy and the set
+    // of valid included files did not change (see reloadPmCoresAsync),
+    // otherwise rebuilt as without cb; cb() is called once they are in use.
+    rootPm.prototype.reloadPolicy = function (genericURI, cb) {
         if (genericURI){
             pip = genericURI;
         }
+        var previousRoot = JSON.stringify(this.rootPolicy);
+        var previousFiles = JSON.stringify(this.includedPolicyFiles);
         loadIncludePolicy(this);
-        loadPmCores(this);
+        if (!cb || !reloadPmCoresAsync(this, previousRoot, previousFiles, cb)) {
+            loadPmCores(this);
+            loadPmRoot(this);
+            if (cb) {
+                process.nextTick(cb);
+            }
+        }
         console.log("Policy version was " + this.policyLocalVersionCounter);
         this.policyLocalVersionCounter = policyGlobalVersionCounter;
         console.log("Policy updated version was " + this.policyLocalVersionCounter);
@@ -10,14 +10,23 @@
 		'sources': [ #Specify your source files here
 			"pm.cc",
 			"core/policymanager/PolicyManager.cpp",
+			"core/policymanager/RootPolicyManager.cpp",
 			"core/policymanager/Condition.cpp",
 			"core/policymanager/Globals.cpp",
 			"core/policymanager/IPolicyBase.cpp",
 			"core/policymanager/Policy.cpp",
 			"core/policymanager/PolicySet.cpp",
+			"core/policymanager/DecisionCache.cpp",
+			"core/policymanager/EvaluationArena.cpp",
+			"core/policymanager/PolicyProgram.cpp",
+			"core/policymanager/PredicateTable.cpp",
+			"core/policymanager/ValueDictionary.cpp",
 			"core/policymanager/Request.cpp",
+			"core/policymanager/RequestBuilder.cpp",
 			"core/policymanager/Rule.cpp",
 			"core/policymanager/Subject.cpp",
+			"core/policymanager/SubjectIndex.cpp",
+			"core/policymanager/ResourceIndex.cpp",
 			"core/policymanager/AuthorizationsSet.cpp",
 			"core/policymanager/DataHandlingPreferences.cpp",
 			"core/policymanager/Obligation.cpp",
@@ -26,8 +35,10 @@
 			"core/policymanager/ProvisionalActions.cpp",
 			"core/policymanager/TriggersSet.cpp",
 			"core/common.cpp",
+			"core/matcher.cpp",
+			"core/mutex.cpp",
+			"core/threadpool.cpp",
 			"../contrib/xmltools/tinyxml.cpp",
-			"../contrib/xmltools/slre.cpp",
 			"../contrib/xmltools/tinystr.cpp",
 			"../contrib/xmltools/tinyxmlparser.cpp",
 			"../contrib/xmltools/tinyxmlerror.cpp",
@@ -19,10 +19,10 @@
 
 #include <cstdio>
 #include <cstring>
+#include <cctype>
 #include <cassert>
 #include "common.h"
 #include "../debug.h"
-#include "../../contrib/xmltools/slre.h"
 
 
 using namespace std;
@@ -34,35 +34,70 @@ using namespace std;
  * -----------------------------------------------------------
  * BONDI specification refers to ECMAScript 3 regular expression, that
  * is perl-like stype, not POSIX-like such as (BRE,ERE).  
- * The chosen SLRE library (http://slre.sourceforge.net/) is a reduced
- * Perl-like style of regular expression, like the same ECMAScript is.
+ * Patterns are compiled by Matcher (matcher.h) into an automaton that
+ * matches in linear time, whatever the pattern.
  * */
 
-bool compare_regexp(const string& target,const string& expression) {
-    struct slre slre;
-    struct cap  captures[MAX_CAPTURES];
+size_t StringView::find(char c, size_t pos) const {
+    if (pos >= length)
+	return string::npos;
+    const char* p = (const char*) memchr(data + pos, c, length - pos);
+    return p ? p - data : string::npos;
+}
+
+size_t StringView::find_last_of(char c, size_t pos) const {
+    if (length == 0)
+	return string::npos;
+    for (size_t i = (pos < length) ? pos + 1 : length; i > 0; i--) {
+	if (data[i - 1] == c)
+	    return i - 1;
+    }
+    return string::npos;
+}
 
-    if (!slre_compile(&slre,expression.c_str())) {
-//	    printf("Error compiling RE: %s\n", slre.err_str);
+StringView StringView::substr(size_t pos, size_t n) const {
+    if (pos > length)
+	return StringView();
+    return StringView(data + pos, (n < length - pos) ? n : length - pos);
+}
+
+// characters of s before its first NUL
+static size_t text_length(const char* s, size_t len) {
+    const char* nul = (const char*) memchr(s, '\0', len);
+    return nul ? nul - s : len;
+}
+
+bool compare_regexp(const StringView& target,const string& expression) {
+    Matcher re;
+
+    if (!re.compile(expression)) {
+//	    printf("Error compiling RE: %s\n", re.getError().c_str());
     	return false;
     } 
-    else
-	if (!slre_match(&slre, target.c_str(),strlen(target.c_str()), captures)) { 
-//	    printf("Not matching!\n" ); 
-	    return false;
-	} 
-	else { 
-//	    printf("Capture: %.*s\n", captures[0].len, captures[0].ptr);
-	    return true;
-	}
-    return false;
+    return re.match(target.data, text_length(target.data, target.length));
 }
 bool compare_numbers(const string& str1, const string& str2, int mode){
+	return compare_numbers(str1.c_str(), str1.length(), str2, mode);
+}
+/* Digits of a value of len characters, NUL terminated in buf: what
+ * atoi and strtoul read of a number is far shorter than buf.
+ * */
+static const char* number_text(const char* s, size_t len, char* buf, size_t size) {
+    if (len >= size)
+	len = size - 1;
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    return buf;
+}
+
+// str1 is len1 long
+bool compare_numbers(const char* str1, size_t len1, const string& str2, int mode){
 	//TODO verify conversion string to int
-	//LOGD("STR1: %s", str1.c_str());
-	int num1 = atoi(str1.c_str());
+	//LOGD("STR1: %s", str1);
+	char buf[64];
+	int num1 = atoi(number_text(str1, len1, buf, sizeof(buf)));
 	int num2 = atoi(str2.c_str());
-	if((num1 == 0 && str1.length() > 1) ||
+	if((num1 == 0 && len1 > 1) ||
 		(num2 == 0 && str2.length() > 1)){
 		LOGD("[common.cpp]Wrong timemin format");
 		return false;
@@ -96,12 +131,16 @@ bool compare_numbers(const string& str1, const string& str2, int mode){
 	return false;
 }
 bool compare_in_set(const string& str1, const string& str2){
+	return compare_in_set(str1.c_str(), str1.length(), str2);
+}
+bool compare_in_set(const char* str1, size_t len1, const string& str2){
 	//TODO verify conversion string to int
-	unsigned long num1 = strtoul(str1.c_str(), NULL, 10);
+	char buf[64];
+	unsigned long num1 = strtoul(number_text(str1, len1, buf, sizeof(buf)), NULL, 10);
 	unsigned long num2 = strtoul(str2.c_str(), NULL, 10);
 	//LOGD("IN-SET NUM1: %lu", num1);
 	//LOGD("IN-SET NUM2: %lu", num2);
-	if( (num1 == 0 && str1.length() > 1) ||
+	if( (num1 == 0 && len1 > 1) ||
 			(num2 == 0 && str2.length() > 1)){
 			LOGD("[common.cpp]Wrong day format");
 			return false;
@@ -128,6 +167,120 @@ string glob2regexp (const string& glob) {
     return result;
 }
 
+// FNV-1a
+uint32_t match_hash(const char* s, size_t len) {
+    uint32_t h = 2166136261U;
+    for (size_t i = 0; i < len; i++) {
+	h ^= (unsigned char) s[i];
+	h *= 16777619U;
+    }
+    return h;
+}
+
+/* Reduce a compiled expression to a literal when it is one.
+ * Matching is unanchored, so leading and trailing ".*" (glob "*") do not
+ * change the result; what is left must be plain characters, escaped
+ * punctuation or "." wildcards, with an optional "^" and "$".
+ * */
+static void classify_literal(match_expr& expr, const string& re) {
+    size_t b = 0, e = strlen(re.c_str());
+    bool head = false, tail = false, any = false;
+
+    expr.kind = MATCH_PATTERN;
+    if (b < e && re[b] == '^') {
+	head = true;
+	b++;
+    }
+    if (e > b && re[e - 1] == '$' && (e - 1 == b || re[e - 2] != '\\')) {
+	tail = true;
+	e--;
+    }
+    while (!head && e - b >= 2 && re[b] == '.' && re[b + 1] == '*') {
+	b += 2;
+	any = true;
+    }
+    while (!tail && e - b >= 2 && re[e - 2] == '.' && re[e - 1] == '*'
+	    && (e - 2 == b || re[e - 3] != '\\'))
+	e -= 2;
+
+    string literal, wildcards;
+    for (size_t i = b; i < e; i++) {
+	char c = re[i];
+	if (c == '\\') {
+	    if (i + 1 >= e || isalnum((unsigned char) re[i + 1]))
+		return;
+	    literal += re[++i];
+	    wildcards += '\0';
+	} else if (strchr("|^$*+?()[", c) != NULL) {
+	    return;
+	} else {
+	    literal += c;
+	    wildcards += (c == '.') ? '\1' : '\0';
+	}
+    }
+    if (wildcards.find('\1') == string::npos)
+	wildcards.clear();
+
+    if (head && tail)
+	expr.kind = MATCH_EXACT;
+    else if (head)
+	expr.kind = MATCH_PREFIX;
+    else if (tail && !(any && literal.empty()))
+	expr.kind = MATCH_SUFFIX;
+    else
+	expr.kind = MATCH_SUBSTRING;
+    expr.literal = literal;
+    expr.wildcards = wildcards;
+    expr.hash = match_hash(literal.data(), literal.size());
+}
+
+void compile_match_expr(match_expr& expr, const string& value, const int mode) {
+    expr.mode = mode;
+    expr.value = value;
+    expr.compiled = false;
+    expr.kind = MATCH_PATTERN;
+    expr.hash = 0;
+    expr.id = VALUE_UNRESOLVED;
+    if (mode == STRCMP_NORMAL) {
+	expr.kind = MATCH_EXACT;
+	expr.literal = value;
+	expr.hash = match_hash(value.data(), value.size());
+    }
+    else if (mode == STRCMP_REGEXP || mode == STRCMP_GLOBBING) {
+	string re = (mode == STRCMP_REGEXP) ? value : glob2regexp(value);
+	expr.compiled = expr.re.compile(re);
+	if (expr.compiled)
+	    classify_literal(expr, re);
+	else
+	    LOGD("[common.cpp] cannot compile match value %s: %s", value.c_str(), expr.re.getError().c_str());
+    }
+}
+
+/* Literal that every value matched by expr contains, false if there is
+ * none: the value of a plain comparison, or for a compiled expression
+ * that is not a general pattern the longest run of its literal without
+ * "." wildcards.
+ * */
+bool match_literal(const match_expr& expr, string& literal) {
+    if (expr.mode == STRCMP_NORMAL)
+	literal = expr.value;
+    else if ((expr.mode == STRCMP_REGEXP || expr.mode == STRCMP_GLOBBING)
+	    && expr.compiled && expr.kind != MATCH_PATTERN) {
+	size_t best = 0, length = expr.wildcards.empty() ? expr.literal.size() : 0;
+	for (size_t i = 0, run = 0; i < expr.wildcards.size(); i++) {
+	    run = (expr.wildcards[i] == '\1') ? 0 : run + 1;
+	    if (run > length) {
+		best = i + 1 - run;
+		length = run;
+	    }
+	}
+	literal = expr.literal.substr(best, length);
+    }
+    else
+	return false;
+    return !literal.empty();
+}
+
 bool compare_globbing (const string& target,const string& expression) {
     // TODO: implementation
    
@@ -160,6 +313,140 @@ bool equals(const string& s1, const string& s2, const int mode) {
     }
 }
 
+/* Target string of a comparison; its hash is computed at most once,
+ * however many literals it is compared with.
+ * */
+typedef struct {
+    const char*	data;
+    size_t	len;		// up to the first NUL, as the matcher sees it
+    uint32_t	hash;
+    bool	hashed;
+    unsigned int	id;	// interned value, VALUE_UNRESOLVED if not looked up
+} match_target;
+
+static void init_target(match_target& t, const char* s, size_t len, unsigned int id) {
+    t.data = s;
+    t.len = text_length(s, len);
+    t.hashed = false;
+    t.id = id;
+}
+
+static bool compare_literal(const char* s, const match_expr& expr) {
+    if (expr.wildcards.empty())
+	return memcmp(s, expr.literal.data(), expr.literal.size()) == 0;
+    for (size_t i = 0; i < expr.literal.size(); i++) {
+	if (!expr.wildcards[i] && s[i] != expr.literal[i])
+	    return false;
+    }
+    return true;
+}
+
+static bool equals_literal(match_target& t, const match_expr& expr) {
+    if (t.id != VALUE_UNRESOLVED && expr.id != VALUE_UNRESOLVED)
+	return t.id == expr.id;
+    if (t.len != expr.literal.size())
+	return false;
+    if (!expr.wildcards.empty())
+	return compare_literal(t.data, expr);
+    if (!t.hashed) {
+	t.hash = match_hash(t.data, t.len);
+	t.hashed = true;
+    }
+    return t.hash == expr.hash && compare_literal(t.data, expr);
+}
+
+// literal somewhere in t, which is longer
+static bool find_literal(const match_target& t, const match_expr& expr) {
+    size_t m = expr.literal.size();
+    const char* end = t.data + t.len - m;
+
+    if (m == 0)
+	return true;
+    for (const char* p = t.data; p <= end; p++) {
+	p = (const char*) memchr(p, expr.literal[0], end - p + 1);
+	if (p == NULL)
+	    return false;
+	if (memcmp(p, expr.literal.data(), m) == 0)
+	    return true;
+    }
+    return false;
+}
+
+// s is the whole value, len long; t stops at its first NUL
+static bool equals(match_target& t, const char* s, size_t len, const match_expr& expr) {
+    size_t m = expr.literal.size();
+
+    if (expr.mode == STRCMP_NORMAL) {
+	if (t.len != len)
+	    return len == expr.value.size() && memcmp(s, expr.value.data(), len) == 0;
+	return equals_literal(t, expr);
+    }
+    switch (expr.mode)
+    {
+	case STRCMP_GREATER_THAN:
+	case STRCMP_GREATER_EQUAL_THAN:
+	case STRCMP_LESS_THAN:
+	case STRCMP_LESS_EQUAL_THAN:
+	    return compare_numbers(s, len, expr.value, expr.mode);
+	case STRCMP_IN_SET:
+	    return compare_in_set(s, len, expr.value);
+	case STRCMP_REGEXP:
+	case STRCMP_GLOBBING:
+	    break;
+	default:
+	    assert(false);
+    }
+    if (!expr.compiled)
+	return false;
+
+    switch (expr.kind)
+    {
+	case MATCH_EXACT:
+	    return equals_literal(t, expr);
+	case MATCH_PREFIX:
+	    return t.len >= m && compare_literal(t.data, expr);
+	case MATCH_SUFFIX:
+	    // the matcher never starts a match at the end of the target
+	    return m > 0 && t.len >= m && compare_literal(t.data + t.len - m, expr);
+	case MATCH_SUBSTRING:
+	    if (t.len == 0 || t.len < m)
+		return false;
+	    if (t.len == m)
+		return equals_literal(t, expr);
+	    if (expr.wildcards.empty())
+		return find_literal(t, expr);
+	    // wildcards in a longer string: let the automaton search
+	default:
+	    return expr.re.match(t.data, t.len);
+    }
+}
+
+bool equals(const string& s, const match_expr& expr, unsigned int id) {
+    return equals(s.c_str(), s.size(), expr, id);
+}
+
+bool equals(const char* s, size_t len, const match_expr& expr, unsigned int id) {
+    match_target t;
+
+    init_target(t, s, len, id);
+    return equals(t, s, len, expr);
+}
+
+bool equals_any(const string& s, const vector<match_expr>& exprs, unsigned int id) {
+    return equals_any(s.c_str(), s.size(), exprs, id);
+}
+
+bool equals_any(const char* s, size_t len, const vector<match_expr>& exprs, unsigned int id) {
+    match_target t;
+
+    init_target(t, s, len, id);
+    for (vector<match_expr>::const_iterator it = exprs.begin(); it != exprs.end(); it++) {
+	if (equals(t, s, len, *it))
+	    return true;
+    }
+    return false;
+}
+
 bool contains(const strings& container, const strings& contained) {
   for(strings::const_iterator it=contained.begin(); it!=contained.end(); it++) {
     if(!contains(container, *it)) return false;
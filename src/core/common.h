@@ -19,7 +19,7 @@
 
 #ifndef COMMON_HEADER_DEFINED
 #define	COMMON_HEADER_DEFINED
-#include "../../contrib/xmltools/slre.h"
+#include "matcher.h"
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -29,6 +29,27 @@
 using namespace std;
 
 typedef vector<string> strings;
+
+/* Characters of a string stored elsewhere, not necessarily NUL terminated.
+ * find, find_last_of and substr behave as those of string, but substr
+ * gives an empty view past the end instead of throwing.
+ * */
+class StringView
+	{
+
+public:
+	const char*	data;
+	size_t		length;
+
+	StringView() : data(""), length(0) {}
+	StringView(const char* d, size_t n) : data(d), length(n) {}
+	StringView(const string& s) : data(s.data()), length(s.size()) {}
+
+	size_t find(char c, size_t pos = 0) const;
+	size_t find_last_of(char c, size_t pos = string::npos) const;
+	StringView substr(size_t pos, size_t n = string::npos) const;
+	string str() const { return string(data, length); }
+	};
 const int STRCMP_NORMAL = 0;
 const int STRCMP_REGEXP = 1;
 const int STRCMP_GLOBBING = 2;
@@ -37,15 +58,60 @@ const int STRCMP_GREATER_EQUAL_THAN = 4;
 const int STRCMP_LESS_THAN = 5;
 const int STRCMP_LESS_EQUAL_THAN = 6;
 const int STRCMP_IN_SET = 7;
-const int MAX_CAPTURES = 4;
+
+// shape of a match value, see compile_match_expr
+const int MATCH_PATTERN = 0;		// general pattern, matched by the automaton
+const int MATCH_EXACT = 1;			// whole string equal to literal
+const int MATCH_PREFIX = 2;			// string starts with literal
+const int MATCH_SUFFIX = 3;			// string ends with literal
+const int MATCH_SUBSTRING = 4;		// string contains literal
+
+// ids of interned values, see ValueDictionary
+const unsigned int VALUE_UNRESOLVED = 0;	// not looked up
+const unsigned int VALUE_UNKNOWN = 1;		// looked up, not a policy literal
+
+/* Policy match value compiled once at policy load time.
+ * For regexp and glob modes the expression is compiled to a Matcher;
+ * a compile failure is kept in "compiled" so that the value simply
+ * never matches instead of being recompiled on every request.
+ * Values that are plain strings (possibly anchored, possibly with "."
+ * wildcards, as most glob values are) are also reduced to a literal that
+ * is compared directly, with its hash to short-cut whole-string equality.
+ * Literals without wildcards also get the id of their value in the
+ * policy's ValueDictionary, so that a request value resolved against the
+ * same dictionary is compared by id.
+ * */
+typedef struct {
+	int				mode;
+	string			value;
+	bool			compiled;
+	Matcher			re;
+	int				kind;
+	string			literal;
+	string			wildcards;	// '.' positions in literal, empty if none
+	uint32_t		hash;		// hash of literal
+	unsigned int	id;			// interned literal, VALUE_UNRESOLVED if none
+} match_expr;
 
 string glob2regexp (const string& glob);
 
-bool compare_regexp(const string& target,const string& expression);
+uint32_t match_hash(const char* s, size_t len);
+void compile_match_expr(match_expr& expr, const string& value, const int mode);
+bool match_literal(const match_expr& expr, string& literal);
+
+bool compare_regexp(const StringView& target,const string& expression);
 bool compare_globbing (const string& target,const string& expression);
 bool compare_numbers(const string& str1, const string& str2, int mode);
+bool compare_numbers(const char* str1, size_t len1, const string& str2, int mode);
 bool compare_in_set(const string& str1, const string& str2);
+bool compare_in_set(const char* str1, size_t len1, const string& str2);
 bool equals(const string& s1, const string& s2, const int mode=STRCMP_NORMAL);
+bool equals(const string& s, const match_expr& expr, unsigned int id=VALUE_UNRESOLVED);
+bool equals_any(const string& s, const vector<match_expr>& exprs, unsigned int id=VALUE_UNRESOLVED);
+// as above, for a value of len characters stored elsewhere; the value ends
+// at its first NUL, if any, as a string does when matched
+bool equals(const char* s, size_t len, const match_expr& expr, unsigned int id=VALUE_UNRESOLVED);
+bool equals_any(const char* s, size_t len, const vector<match_expr>& exprs, unsigned int id=VALUE_UNRESOLVED);
 
 inline bool contains(const strings& ss, const string& s) { return (find(ss.begin(), ss.end(), s)!=ss.end()); }
 bool contains(const strings& container, const strings& contained);
@@ -0,0 +1,553 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#include <bitset>
+#include <cctype>
+#include <cstring>
+#include "matcher.h"
+
+/*
+ * NFA construction
+ * -----------------------------------------------------------
+ * Classic Thompson construction: every consuming state matches one byte
+ * from a character class, the other states are epsilon moves (split,
+ * jump), zero-width assertions (^, $) and the final match state.
+ * A fragment keeps the list of its dangling exits, encoded as
+ * state * 2 + (0 for out, 1 for out1), to be patched by the next fragment.
+ * */
+
+enum NfaOp {NFA_CHAR, NFA_SPLIT, NFA_JUMP, NFA_BOL, NFA_EOL, NFA_MATCH};
+
+typedef bitset<256> CharClass;
+
+typedef struct {
+	int		op;
+	int		out;
+	int		out1;
+	int		cls;		// index in NfaBuilder::classes for NFA_CHAR
+} NfaState;
+
+typedef struct {
+	int			start;
+	vector<int>	exits;
+} NfaFrag;
+
+class NfaBuilder
+	{
+
+private:
+	const char*		p;
+
+	int addState(int op, int out, int out1, int cls);
+	void patch(const vector<int>& exits, int target);
+	void single(NfaFrag& f, int op, int cls);
+	void concat(NfaFrag& a, NfaFrag& b);
+	bool parseAlt(NfaFrag& f);
+	bool parseConcat(NfaFrag& f);
+	bool parseRepeat(NfaFrag& f);
+	bool parseAtom(NfaFrag& f);
+	bool parseClass(NfaFrag& f);
+	bool parseEscape(CharClass& cls, bool& isClass, unsigned char& ch);
+
+public:
+	vector<NfaState>	states;
+	vector<CharClass>	classes;
+	int					start;
+	string				error;
+
+	bool build(const string& pattern);
+	};
+
+int NfaBuilder::addState(int op, int out, int out1, int cls) {
+	NfaState s;
+	s.op = op;
+	s.out = out;
+	s.out1 = out1;
+	s.cls = cls;
+	states.push_back(s);
+	return states.size() - 1;
+}
+
+void NfaBuilder::patch(const vector<int>& exits, int target) {
+	for (unsigned int i = 0; i < exits.size(); i++) {
+		if (exits[i] & 1)
+			states[exits[i] >> 1].out1 = target;
+		else
+			states[exits[i] >> 1].out = target;
+	}
+}
+
+void NfaBuilder::single(NfaFrag& f, int op, int cls) {
+	f.start = addState(op, -1, -1, cls);
+	f.exits.assign(1, f.start * 2);
+}
+
+void NfaBuilder::concat(NfaFrag& a, NfaFrag& b) {
+	patch(a.exits, b.start);
+	a.exits.swap(b.exits);
+}
+
+bool NfaBuilder::build(const string& pattern) {
+	NfaFrag f;
+
+	p = pattern.c_str();
+	if (!parseAlt(f))
+		return false;
+	if (*p != '\0') {
+		error = "Unbalanced brackets";
+		return false;
+	}
+	patch(f.exits, addState(NFA_MATCH, -1, -1, -1));
+	start = f.start;
+	return true;
+}
+
+bool NfaBuilder::parseAlt(NfaFrag& f) {
+	if (!parseConcat(f))
+		return false;
+	while (*p == '|') {
+		NfaFrag b;
+		p++;
+		if (!parseConcat(b))
+			return false;
+		f.start = addState(NFA_SPLIT, f.start, b.start, -1);
+		f.exits.insert(f.exits.end(), b.exits.begin(), b.exits.end());
+	}
+	return true;
+}
+
+bool NfaBuilder::parseConcat(NfaFrag& f) {
+	bool empty = true;
+
+	while (*p != '\0' && *p != '|' && *p != ')') {
+		NfaFrag b;
+		if (!parseRepeat(b))
+			return false;
+		if (empty)
+			f = b;
+		else
+			concat(f, b);
+		empty = false;
+	}
+	if (empty)
+		single(f, NFA_JUMP, -1);
+	return true;
+}
+
+bool NfaBuilder::parseRepeat(NfaFrag& f) {
+	if (!parseAtom(f))
+		return false;
+
+	while (*p == '*' || *p == '+' || *p == '?') {
+		char q = *p++;
+		// lazy quantifiers accept the same strings
+		if (*p == '?')
+			p++;
+		int s = addState(NFA_SPLIT, f.start, -1, -1);
+		switch (q) {
+		case '*':
+			patch(f.exits, s);
+			f.start = s;
+			f.exits.assign(1, s * 2 + 1);
+			break;
+		case '+':
+			patch(f.exits, s);
+			f.exits.assign(1, s * 2 + 1);
+			break;
+		default:
+			f.start = s;
+			f.exits.push_back(s * 2 + 1);
+			break;
+		}
+	}
+	return true;
+}
+
+bool NfaBuilder::parseAtom(NfaFrag& f) {
+	CharClass cls;
+	bool isClass;
+	unsigned char ch;
+
+	switch (*p) {
+	case '(':
+		p++;
+		if (p[0] == '?' && p[1] == ':')
+			p += 2;
+		if (!parseAlt(f))
+			return false;
+		if (*p != ')') {
+			error = "No closing bracket";
+			return false;
+		}
+		p++;
+		return true;
+	case '[':
+		p++;
+		return parseClass(f);
+	case '^':
+		p++;
+		single(f, NFA_BOL, -1);
+		return true;
+	case '$':
+		p++;
+		single(f, NFA_EOL, -1);
+		return true;
+	case '.':
+		p++;
+		cls.set();
+		break;
+	case '\\':
+		p++;
+		if (!parseEscape(cls, isClass, ch))
+			return false;
+		if (!isClass)
+			cls.set(ch);
+		break;
+	default:
+		cls.set((unsigned char) *p++);
+		break;
+	}
+	classes.push_back(cls);
+	single(f, NFA_CHAR, classes.size() - 1);
+	return true;
+}
+
+bool NfaBuilder::parseClass(NfaFrag& f) {
+	CharClass cls, item;
+	bool negate = false, isClass;
+	unsigned char lo, hi;
+
+	if (*p == '^') {
+		negate = true;
+		p++;
+	}
+	while (*p != ']') {
+		if (*p == '\0') {
+			error = "No closing ']' bracket";
+			return false;
+		}
+		isClass = false;
+		if (*p == '\\') {
+			p++;
+			if (!parseEscape(item, isClass, lo))
+				return false;
+		} else
+			lo = (unsigned char) *p++;
+		if (isClass) {
+			cls |= item;
+			continue;
+		}
+		if (p[0] != '-' || p[1] == ']' || p[1] == '\0') {
+			cls.set(lo);
+			continue;
+		}
+		// range
+		p++;
+		if (*p == '\\') {
+			p++;
+			item.reset();
+			if (!parseEscape(item, isClass, hi))
+				return false;
+			if (isClass) {
+				// "[a-\d]": not a range, the '-' is literal
+				cls.set(lo);
+				cls.set('-');
+				cls |= item;
+				continue;
+			}
+		} else
+			hi = (unsigned char) *p++;
+		if (lo > hi) {
+			// "[a-\\]": slre had no ranges, keep the three characters
+			cls.set(lo);
+			cls.set('-');
+			cls.set(hi);
+			continue;
+		}
+		for (unsigned int c = lo; c <= hi; c++)
+			cls.set(c);
+	}
+	p++;
+	if (negate)
+		cls.flip();
+	classes.push_back(cls);
+	single(f, NFA_CHAR, classes.size() - 1);
+	return true;
+}
+
+static int hexValue(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+bool NfaBuilder::parseEscape(CharClass& cls, bool& isClass, unsigned char& ch) {
+	char e = *p;
+
+	// a trailing backslash is taken literally
+	if (e == '\0') {
+		isClass = false;
+		ch = '\\';
+		return true;
+	}
+	p++;
+	isClass = true;
+	cls.reset();
+	switch (e) {
+	case 'd':
+	case 'D':
+		for (int c = 0; c < 256; c++)
+			if (isdigit(c))
+				cls.set(c);
+		break;
+	case 's':
+	case 'S':
+		for (int c = 0; c < 256; c++)
+			if (isspace(c))
+				cls.set(c);
+		break;
+	case 'w':
+	case 'W':
+		for (int c = 0; c < 256; c++)
+			if (c < 128 && (isalnum(c) || c == '_'))
+				cls.set(c);
+		break;
+	default:
+		isClass = false;
+		break;
+	}
+	if (isClass) {
+		if (isupper(e))
+			cls.flip();
+		return true;
+	}
+
+	switch (e) {
+	case 'n':	ch = '\n';	break;
+	case 'r':	ch = '\r';	break;
+	case 't':	ch = '\t';	break;
+	case 'f':	ch = '\f';	break;
+	case 'v':	ch = '\v';	break;
+	case '0':	ch = 0;		break;
+	case 'x':
+		if (hexValue(p[0]) >= 0 && hexValue(p[1]) >= 0) {
+			ch = (unsigned char) (hexValue(p[0]) * 16 + hexValue(p[1]));
+			p += 2;
+		} else
+			ch = 'x';
+		break;
+	default:	ch = (unsigned char) e;	break;
+	}
+	return true;
+}
+
+/*
+ * Epsilon closure of a state: consuming states reached (as bits) and
+ * whether the match state is reached, given whether ^ and $ hold at the
+ * current offset.
+ */
+static bool closure(const NfaBuilder& nfa, const vector<int>& bit, int from,
+		bool bol, bool eol, uint64_t* set) {
+	vector<char> visited(nfa.states.size(), 0);
+	vector<int> stack(1, from);
+	bool accept = false;
+
+	while (!stack.empty()) {
+		int s = stack.back();
+		stack.pop_back();
+		if (s < 0 || visited[s])
+			continue;
+		visited[s] = 1;
+		const NfaState& st = nfa.states[s];
+		switch (st.op) {
+		case NFA_CHAR:
+			if (set)
+				set[bit[s] / 64] |= (uint64_t) 1 << (bit[s] % 64);
+			break;
+		case NFA_SPLIT:
+			stack.push_back(st.out1);
+			stack.push_back(st.out);
+			break;
+		case NFA_JUMP:
+			stack.push_back(st.out);
+			break;
+		case NFA_BOL:
+			if (bol)
+				stack.push_back(st.out);
+			break;
+		case NFA_EOL:
+			if (eol)
+				stack.push_back(st.out);
+			break;
+		case NFA_MATCH:
+			accept = true;
+			break;
+		}
+	}
+	return accept;
+}
+
+static inline unsigned int lowestBit(uint64_t x) {
+#ifdef __GNUC__
+	return __builtin_ctzll(x);
+#else
+	unsigned int n = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+Matcher::Matcher() :
+		words(0), valid(false), anchored(false), restartable(false),
+		startFirstAccept(false), startFirstAcceptEnd(false), startNextAccept(false) {
+}
+
+Matcher::~Matcher() {
+}
+
+bool Matcher::compile(const string& pattern) {
+	NfaBuilder nfa;
+	vector<int> bit;
+	unsigned int count = 0;
+
+	valid = false;
+	error.clear();
+	if (!nfa.build(pattern)) {
+		error = nfa.error;
+		return false;
+	}
+
+	// number the consuming states
+	bit.assign(nfa.states.size(), -1);
+	for (unsigned int s = 0; s < nfa.states.size(); s++) {
+		if (nfa.states[s].op == NFA_CHAR)
+			bit[s] = count++;
+	}
+	words = (count + 63) / 64;
+	if (words == 0)
+		words = 1;
+
+	charMask.assign(256 * words, 0);
+	follow.assign(count * words, 0);
+	acceptMask.assign(words, 0);
+	acceptEndMask.assign(words, 0);
+	startFirst.assign(words, 0);
+	startNext.assign(words, 0);
+
+	for (unsigned int s = 0; s < nfa.states.size(); s++) {
+		if (bit[s] < 0)
+			continue;
+		const NfaState& st = nfa.states[s];
+		uint64_t mask = (uint64_t) 1 << (bit[s] % 64);
+		unsigned int w = bit[s] / 64;
+
+		for (unsigned int c = 0; c < 256; c++) {
+			if (nfa.classes[st.cls].test(c))
+				charMask[c * words + w] |= mask;
+		}
+		// after a byte is consumed the offset is never 0
+		if (closure(nfa, bit, st.out, false, false, &follow[bit[s] * words]))
+			acceptMask[w] |= mask;
+		if (closure(nfa, bit, st.out, false, true, NULL))
+			acceptEndMask[w] |= mask;
+	}
+
+	startFirstAccept = closure(nfa, bit, nfa.start, true, false, &startFirst[0]);
+	startFirstAcceptEnd = closure(nfa, bit, nfa.start, true, true, NULL);
+	startNextAccept = closure(nfa, bit, nfa.start, false, false, &startNext[0]);
+
+	restartable = startNextAccept;
+	for (unsigned int w = 0; w < words; w++)
+		restartable = restartable || startNext[w] != 0;
+	anchored = !pattern.empty() && pattern[0] == '^';
+	valid = true;
+	return true;
+}
+
+bool Matcher::match(const char* target, int len) const {
+	uint64_t stackbuf[2 * MATCHER_STACK_WORDS];
+	vector<uint64_t> heapbuf;
+	uint64_t *cur, *next, *tmp;
+
+	if (!valid)
+		return false;
+	if (words > MATCHER_STACK_WORDS) {
+		heapbuf.resize(2 * words);
+		cur = &heapbuf[0];
+	} else
+		cur = stackbuf;
+	next = cur + words;
+	memset(cur, 0, words * sizeof(uint64_t));
+
+	for (int ofs = 0;; ofs++) {
+		// a match may start at any offset before the end of the target;
+		// at the end only if the target is empty and the pattern anchored
+		if (ofs < len || (ofs == 0 && anchored)) {
+			const uint64_t* start = (ofs == 0) ? &startFirst[0] : &startNext[0];
+			bool accept = (ofs > 0) ? startNextAccept :
+					(ofs == len) ? startFirstAcceptEnd : startFirstAccept;
+			if (accept)
+				return true;
+			for (unsigned int w = 0; w < words; w++)
+				cur[w] |= start[w];
+		}
+		if (ofs == len)
+			return false;
+
+		const uint64_t* mask = &charMask[(unsigned char) target[ofs] * words];
+		const uint64_t* accepting = (ofs + 1 == len) ? &acceptEndMask[0] : &acceptMask[0];
+		bool alive = false;
+
+		memset(next, 0, words * sizeof(uint64_t));
+		for (unsigned int w = 0; w < words; w++) {
+			uint64_t bits = cur[w] & mask[w];
+			if (bits & accepting[w])
+				return true;
+			while (bits) {
+				const uint64_t* row = &follow[(w * 64 + lowestBit(bits)) * words];
+				for (unsigned int v = 0; v < words; v++)
+					next[v] |= row[v];
+				bits &= bits - 1;
+			}
+		}
+		tmp = cur;
+		cur = next;
+		next = tmp;
+
+		for (unsigned int w = 0; !alive && w < words; w++)
+			alive = cur[w] != 0;
+		if (!alive && !restartable)
+			return false;
+	}
+}
+
+bool Matcher::isValid() const {
+	return valid;
+}
+
+const string& Matcher::getError() const {
+	return error;
+}
@@ -0,0 +1,86 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#ifndef MATCHER_H_
+#define MATCHER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// state sets up to this many 64-bit words are matched without heap allocation
+const unsigned int MATCHER_STACK_WORDS = 8;
+
+/* Regular expression matcher for policy match values
+ * -----------------------------------------------------------
+ * BONDI specification refers to ECMAScript 3 regular expressions.
+ * Supported subset: literals, ".", "[...]" and "[^...]" with ranges,
+ * "^", "$", "|", "(...)", "(?:...)", "*", "+", "?" (and their lazy
+ * forms), the escapes \d \D \s \S \w \W \n \r \t \f \v \0 \xHH; any other
+ * escaped character is taken literally, as is a quantifier with nothing
+ * to repeat.
+ *
+ * The pattern is compiled into a Thompson NFA whose epsilon closures are
+ * precomputed, so matching is a bit-parallel walk over the input: each
+ * byte costs one pass over the active state set, whatever the pattern.
+ * There is no backtracking and no limit on the pattern size.
+ *
+ * As with the previous slre based matcher, match() searches for the
+ * pattern anywhere in the target, and an empty target only matches a
+ * pattern anchored with a leading "^".
+ *
+ * Malformed patterns slre accepted still compile: a trailing "\" is a
+ * literal backslash, and a range out of order such as "[a-\\]" stands
+ * for its two ends and "-" (slre had no ranges). Unbalanced brackets and
+ * an unclosed "[" fail to compile, "[.\" included (slre read past its
+ * end); a value that does not compile matches nothing, and the policy
+ * manager lists it in getMatchErrors().
+ * */
+class Matcher
+	{
+
+private:
+	unsigned int		words;				// 64-bit words in a state set
+	bool				valid;
+	bool				anchored;			// pattern starts with "^"
+	bool				restartable;		// a match can start after offset 0
+	vector<uint64_t>	charMask;			// [256][words] states consuming each byte
+	vector<uint64_t>	follow;				// [states][words] states reached after consuming
+	vector<uint64_t>	acceptMask;			// states whose consumption reaches the end of the pattern
+	vector<uint64_t>	acceptEndMask;		// as acceptMask, when the consumed byte is the last one
+	vector<uint64_t>	startFirst;			// states reachable at offset 0
+	vector<uint64_t>	startNext;			// states reachable at later offsets
+	bool				startFirstAccept;
+	bool				startFirstAcceptEnd;
+	bool				startNextAccept;
+	string				error;
+
+public:
+	Matcher();
+	virtual ~Matcher();
+
+	bool compile(const string& pattern);
+	bool match(const char* target, int len) const;
+	bool isValid() const;
+	const string& getError() const;
+	};
+
+#endif /* MATCHER_H_ */
@@ -0,0 +1,105 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#include "mutex.h"
+
+#ifdef _WIN32
+
+Mutex::Mutex() {
+	InitializeCriticalSection(&section);
+}
+
+Mutex::~Mutex() {
+	DeleteCriticalSection(&section);
+}
+
+void Mutex::lock() {
+	EnterCriticalSection(&section);
+}
+
+void Mutex::unlock() {
+	LeaveCriticalSection(&section);
+}
+
+ConditionVariable::ConditionVariable() {
+	InitializeConditionVariable(&condition);
+}
+
+ConditionVariable::~ConditionVariable() {
+}
+
+void ConditionVariable::wait(Mutex& m) {
+	SleepConditionVariableCS(&condition, &m.section, INFINITE);
+}
+
+void ConditionVariable::signal() {
+	WakeConditionVariable(&condition);
+}
+
+void ConditionVariable::broadcast() {
+	WakeAllConditionVariable(&condition);
+}
+
+#else
+
+Mutex::Mutex() {
+	pthread_mutex_init(&mutex, NULL);
+}
+
+Mutex::~Mutex() {
+	pthread_mutex_destroy(&mutex);
+}
+
+void Mutex::lock() {
+	pthread_mutex_lock(&mutex);
+}
+
+void Mutex::unlock() {
+	pthread_mutex_unlock(&mutex);
+}
+
+ConditionVariable::ConditionVariable() {
+	pthread_cond_init(&condition, NULL);
+}
+
+ConditionVariable::~ConditionVariable() {
+	pthread_cond_destroy(&condition);
+}
+
+void ConditionVariable::wait(Mutex& m) {
+	pthread_cond_wait(&condition, &m.mutex);
+}
+
+void ConditionVariable::signal() {
+	pthread_cond_signal(&condition);
+}
+
+void ConditionVariable::broadcast() {
+	pthread_cond_broadcast(&condition);
+}
+
+#endif
+
+MutexLock::MutexLock(Mutex& m) : mutex(m) {
+	mutex.lock();
+}
+
+MutexLock::~MutexLock() {
+	mutex.unlock();
+}
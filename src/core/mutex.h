@@ -0,0 +1,94 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#ifndef MUTEX_H_
+#define MUTEX_H_
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/* Non-recursive mutual exclusion lock over the platform primitive
+ * (pthreads, or a critical section on Windows), for the few pieces of
+ * shared mutable state the policy manager has.
+ * */
+class Mutex
+	{
+
+private:
+#ifdef _WIN32
+	CRITICAL_SECTION	section;
+#else
+	pthread_mutex_t		mutex;
+#endif
+
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+
+	friend class ConditionVariable;
+
+public:
+	Mutex();
+	virtual ~Mutex();
+
+	void lock();
+	void unlock();
+	};
+
+// holds a Mutex for the lifetime of a scope
+class MutexLock
+	{
+
+private:
+	Mutex&	mutex;
+
+	MutexLock(const MutexLock&);
+	MutexLock& operator=(const MutexLock&);
+
+public:
+	MutexLock(Mutex&);
+	virtual ~MutexLock();
+	};
+
+// condition variable, waited on with its Mutex held
+class ConditionVariable
+	{
+
+private:
+#ifdef _WIN32
+	CONDITION_VARIABLE	condition;
+#else
+	pthread_cond_t		condition;
+#endif
+
+	ConditionVariable(const ConditionVariable&);
+	ConditionVariable& operator=(const ConditionVariable&);
+
+public:
+	ConditionVariable();
+	virtual ~ConditionVariable();
+
+	void wait(Mutex&);
+	void signal();
+	void broadcast();
+	};
+
+#endif /* MUTEX_H_ */
@@ -47,17 +47,26 @@ AuthorizationsSet::AuthorizationsSet(TiXmlElement* authorizationsset){
 	else{
 		LOGD("AuthorizationsSet constructor, AuthzUseForPurpose not found");
 	}
+
+	// purposes are compared once here rather than on every evaluation
+	authorized.resize(arraysize(ontology_vector), false);
+	for (unsigned int i = 0; i < arraysize(ontology_vector); i++) {
+		for (unsigned int j = 0; j < authzuseforpurpose.size(); j++) {
+			if (ontology_vector[i].compare(authzuseforpurpose[j]) == 0) {
+				authorized[i] = true;
+				break;
+			}
+		}
+	}
 }
 
 AuthorizationsSet::~AuthorizationsSet(){
 }
 
-bool AuthorizationsSet::evaluate(Request * req){
+bool AuthorizationsSet::evaluate(const Request * req){
 	LOGD("Evaluating AuthorizationsSet");
 
-	vector<bool> purpose_satisfied(arraysize(ontology_vector), false);
-	vector<bool> purpose = req->getPurposeAttrs();
-	unsigned int i = 0;
+	const vector<bool>& purpose = req->getPurposeAttrs();
 
 	// invalid purposes vector
 	if (purpose.size() != arraysize(ontology_vector)) {
@@ -65,32 +74,12 @@ bool AuthorizationsSet::evaluate(Request * req){
 		return false;
 	}
 
-	for(vector<bool>::const_iterator it = purpose.begin(); it!= purpose.end(); it++){
-		// Purpose requested
-		if (*it == true){
-			purpose_satisfied[i] = false;
-			LOGD("AuthorizationsSet: purpose %d is true", i);
-			for(unsigned int j=0; j<authzuseforpurpose.size(); j++){
-				LOGD("AuthorizationsSet: checking authzuseforpurpose %d, %s", j, authzuseforpurpose[j].c_str());
-				if (ontology_vector[i].compare(authzuseforpurpose[j]) == 0){
-					// Purpose requested and satisfied
-					purpose_satisfied[i] = true;
-					break;
-				}
-			}
-		}
-		// Purpose not requested
-		else {
-			LOGD("AuthorizationsSet: purpose %d is false", i);
-			purpose_satisfied[i] = true;
-		}
-		i++;
-	}
-
-	for (i=0; i < arraysize(ontology_vector); i++){
-		if (purpose_satisfied[i] == false)
-			// A purpose is not satisfied
+	for (unsigned int i = 0; i < purpose.size(); i++) {
+		// Purpose requested and not authorized
+		if (purpose[i] && !authorized[i]) {
+			LOGD("AuthorizationsSet: purpose %d is not satisfied", i);
 			return false;
+		}
 	}
 	// All purposes are satisfied
 	return true;
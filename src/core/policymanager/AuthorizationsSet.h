@@ -82,12 +82,13 @@ class AuthorizationsSet{
 	
 private:
 	vector<string>	authzuseforpurpose;
+	vector<bool>	authorized;		// by index in ontology_vector
 
 public:
 	AuthorizationsSet(TiXmlElement*);
 	virtual ~AuthorizationsSet();
 
-	bool evaluate(Request *);
+	bool evaluate(const Request *);
 };
 
 #endif /* AUTHORIZATIONSSET_H_ */
@@ -61,6 +61,9 @@ Condition::Condition(TiXmlElement* condition){
 					tmp_info->equal_func = (child->Attribute("func")!=NULL) ? child->Attribute("func") : "glob";	
 					tmp_info->value = tmp.substr(pos, nextPos-pos);
 					tmp_info->mod_func = (dot_pos != (int)string::npos) ? attr.substr(dot_pos+1) : "";
+					tmp_info->predicate = PREDICATE_NONE;
+					tmp_info->matchers.resize(1);
+					compile_match_expr(tmp_info->matchers[0], tmp_info->value, string2strcmp_mode(tmp_info->equal_func));
 					
 //					LOGD("Adding %s",tmp_info->value.data());
 					
@@ -80,6 +83,106 @@ Condition::Condition(TiXmlElement* condition){
 		}
 	}
 //	LOGD("[Condition] : there are %d match elements",num_match);
+	resolveAttrs();
+}
+
+void Condition::resolveAttrs(){
+	map<string,vector<match_info_str*> >::iterator it;
+	hasFeatures = (it = resource_attrs.find(API_FEATURE)) != resource_attrs.end();
+	if(hasFeatures)
+		features = it->second;
+	for(it = resource_attrs.begin(); it != resource_attrs.end(); it++){
+		if(it->first != API_FEATURE){
+			attribute_match m;
+			m.attr = string2attribute(it->first);
+			m.name = it->first;
+			m.matches = it->second;
+			capabilities.push_back(m);
+		}
+	}
+	roaming = (it = environment_attrs.find("roaming")) != environment_attrs.end() ? it->second.at(0) : NULL;
+	if((it = environment_attrs.find("bearer-type")) != environment_attrs.end())
+		bearers = it->second;
+	if((it = environment_attrs.find("profile")) != environment_attrs.end())
+		profiles = it->second;
+	if((it = environment_attrs.find("timemin")) != environment_attrs.end())
+		timemins = it->second;
+	daysofweek = (it = environment_attrs.find("days-of-week")) != environment_attrs.end() ? it->second.at(0) : NULL;
+	daysofmonth = (it = environment_attrs.find("days-of-month")) != environment_attrs.end() ? it->second.at(0) : NULL;
+}
+
+static void internMatches(map<string, vector<match_info_str*> >& attrs, ValueDictionary& dictionary){
+	for(map<string,vector<match_info_str*> >::iterator it = attrs.begin(); it != attrs.end(); it++){
+		for(unsigned int j = 0; j < it->second.size(); j++){
+			// values reduced by a function are never resolved
+			if(it->second[j]->mod_func == "")
+				dictionary.intern(it->second[j]->matchers[0]);
+		}
+	}
+}
+
+void Condition::intern(ValueDictionary& dictionary){
+	internMatches(resource_attrs, dictionary);
+	internMatches(environment_attrs, dictionary);
+	for(unsigned int i = 0; i < conditions.size(); i++)
+		conditions[i]->intern(dictionary);
+}
+
+static void internPredicate(match_info_str* m, int scope, int attr, const string& name,
+		PredicateTable& predicates, vector<PredicateMask>& mask){
+	m->predicate = predicates.add(scope, attr, name, m);
+	PredicateTable::appendMask(mask, m->predicate);
+}
+
+static void internPredicates(const vector<match_info_str*>& matches, int scope, int attr, const string& name,
+		PredicateTable& predicates, vector<PredicateMask>& mask){
+	for(unsigned int j = 0; j < matches.size(); j++)
+		internPredicate(matches[j], scope, attr, name, predicates, mask);
+}
+
+static void internEnvironment(const vector<match_info_str*>& matches, AttributeId attr,
+		PredicateTable& predicates, vector<PredicateMask>& mask){
+	internPredicates(matches, PREDICATE_ENVIRONMENT, attr, attribute2string(attr), predicates, mask);
+}
+
+void Condition::intern(PredicateTable& predicates){
+	internPredicates(features, PREDICATE_FEATURE, ATTR_API_FEATURE, API_FEATURE, predicates, mask);
+	for(unsigned int k = 0; k < capabilities.size(); k++)
+		internPredicates(capabilities[k].matches, PREDICATE_CAPABILITY, capabilities[k].attr, capabilities[k].name, predicates, mask);
+	internEnvironment(timemins, ATTR_TIMEMIN, predicates, mask);
+	if(daysofweek != NULL)
+		internEnvironment(vector<match_info_str*>(1, daysofweek), ATTR_DAYS_OF_WEEK, predicates, mask);
+	if(daysofmonth != NULL)
+		internEnvironment(vector<match_info_str*>(1, daysofmonth), ATTR_DAYS_OF_MONTH, predicates, mask);
+	if(roaming != NULL)
+		internEnvironment(vector<match_info_str*>(1, roaming), ATTR_ROAMING, predicates, mask);
+	internEnvironment(bearers, ATTR_BEARER_TYPE, predicates, mask);
+	internEnvironment(profiles, ATTR_PROFILE, predicates, mask);
+	for(unsigned int i = 0; i < conditions.size(); i++)
+		conditions[i]->intern(predicates);
+}
+
+void Condition::collectReferences(AttributeReferences& refs){
+	if(!capabilities.empty())
+		refs.capabilities = true;
+	for(map<string,vector<match_info_str*> >::iterator it = environment_attrs.begin(); it != environment_attrs.end(); it++){
+		AttributeId attr = string2attribute(it->first);
+		if(attr != ATTR_UNKNOWN)
+			refs.environment[attr] = true;
+	}
+	for(unsigned int j = 0; j < timemins.size(); j++){
+		const match_expr& expr = timemins[j]->matchers[0];
+		if(expr.mode < STRCMP_GREATER_THAN || expr.mode > STRCMP_LESS_EQUAL_THAN){
+			refs.timeExact = true;
+			continue;
+		}
+		// a bound compare_numbers rejects never matches, whatever the request
+		int bound = atoi(expr.value.c_str());
+		if(bound != 0 || expr.value.length() <= 1)
+			refs.timeThresholds.push_back(bound);
+	}
+	for(unsigned int i = 0; i < conditions.size(); i++)
+		conditions[i]->collectReferences(refs);
 }
 
 Condition::~Condition()
@@ -87,7 +190,7 @@ Condition::~Condition()
 	// TODO Auto-generated destructor stub
 	}
 
-ConditionResponse Condition::evaluate(Request * req){
+ConditionResponse Condition::evaluate(const Request * req, PredicateMemo* memo){
 	LOGD("[COND EVALUATE] combine : %d size : %lu",combine,conditions.size());
 	ConditionResponse tmpCR;
 	bool anyUndetermined = false;
@@ -96,7 +199,7 @@ ConditionResponse Condition::evaluate(Request * req){
 	{
 		for (unsigned int i=0; i<conditions.size(); i++)
 		{
-			tmpCR = conditions[i]->evaluate(req);
+			tmpCR = conditions[i]->evaluate(req, memo);
 			LOGD("[SUB-COND EVAL AND] %d ",tmpCR);
 				
 			if (tmpCR == NO_MATCH)
@@ -105,7 +208,7 @@ ConditionResponse Condition::evaluate(Request * req){
 				anyUndetermined = true;
 		}
 		
-		tmpCR = evaluateFeatures(req);
+		tmpCR = evaluateFeatures(req, memo);
 		LOGD("[FEAT EVAL AND] %d, anyundeterm : %d",tmpCR,anyUndetermined);
 		if (tmpCR == NO_MATCH)
 			return NO_MATCH;
@@ -113,7 +216,7 @@ ConditionResponse Condition::evaluate(Request * req){
 			anyUndetermined = true;
 		
 		
-		tmpCR = evaluateCapabilities(req);
+		tmpCR = evaluateCapabilities(req, memo);
 		LOGD("[CAP EVAL AND]  %d, anyundeterm : %d",tmpCR,anyUndetermined);
 		if (tmpCR == NO_MATCH)
 			return NO_MATCH;
@@ -137,7 +240,7 @@ ConditionResponse Condition::evaluate(Request * req){
 		LOGD("Condition.evaluate() - 04");
 		for (unsigned int i=0; i<conditions.size(); i++)
 		{
-			tmpCR = conditions[i]->evaluate(req);
+			tmpCR = conditions[i]->evaluate(req, memo);
 			LOGD("[COND EVAL OR] %d", tmpCR);
 			if (tmpCR == MATCH)
 				return MATCH;
@@ -145,14 +248,14 @@ ConditionResponse Condition::evaluate(Request * req){
 				anyUndetermined = true;
 		}
 		LOGD("Condition.evaluate() - 043");
-		tmpCR = evaluateFeatures(req);
+		tmpCR = evaluateFeatures(req, memo);
 		LOGD("Condition.evaluate() - 044");
 		LOGD("[FEAT EVAL OR] %d", tmpCR);
 		if (tmpCR == MATCH)
 			return MATCH;
 		else if (tmpCR == NOT_DETERMINED)
 			anyUndetermined = true;
-		tmpCR = evaluateCapabilities(req);
+		tmpCR = evaluateCapabilities(req, memo);
 		LOGD("[CAP EVAL OR] %d",tmpCR);
 		if (tmpCR == MATCH)
 			return MATCH;
@@ -175,68 +278,97 @@ ConditionResponse Condition::evaluate(Request * req){
 	return NOT_DETERMINED;	
 }
 
-ConditionResponse Condition::evaluateEnvironment(Request* req){	
-	vector<match_info_str*> my_environment_params;
-	map<string, string> requestEnvironment_attrs = req->getEnvironmentAttrs();
-	
-	map<string,vector<match_info_str*> >::iterator it;
-	match_info_str * my_roaming = (it = environment_attrs.find("roaming"))!=environment_attrs.end() 
-		? it->second.at(0) 
-		: NULL;
-	
-	vector<match_info_str *> my_bearer_vet = (it = environment_attrs.find("bearer-type"))!=environment_attrs.end() 
-		? it->second 
-		: vector<match_info_str*>();
-	
-	vector<match_info_str *> my_profile_vet = (it = environment_attrs.find("profile"))!=environment_attrs.end() 
-		? it->second 
-		: vector<match_info_str*>();
-	vector<match_info_str * > my_time_vet = (it = environment_attrs.find("timemin")) != environment_attrs.end()
-		? it->second : vector<match_info_str*>();
-	match_info_str * my_daysofweek = (it = environment_attrs.find("days-of-week"))!=environment_attrs.end()
-				? it->second.at(0)
-				: NULL;
-	match_info_str * my_daysofmonth = (it = environment_attrs.find("days-of-month"))!=environment_attrs.end()
-					? it->second.at(0)
-					: NULL;
+/* As above, from the results of all the predicates of the policy. A
+ * match element is NO_MATCH when its attribute is in the request and no
+ * value matches, NOT_DETERMINED when the attribute is missing; an AND
+ * condition is then NO_MATCH if any of its elements or sub-conditions is,
+ * an OR condition MATCH if any is, and either is NOT_DETERMINED if any is
+ * rather than giving the opposite answer.
+ * */
+ConditionResponse Condition::evaluate(const PredicateVector& results) const{
+	bool anyUndetermined = false;
+	for(unsigned int i = 0; i < mask.size(); i++){
+		unsigned int w = mask[i].word;
+		if(combine == AND && (results.determined[w] & ~results.matched[w] & mask[i].bits) != 0)
+			return NO_MATCH;
+		if(combine == OR && (results.matched[w] & mask[i].bits) != 0)
+			return MATCH;
+		if((~results.determined[w] & mask[i].bits) != 0)
+			anyUndetermined = true;
+	}
+	for(unsigned int i = 0; i < conditions.size(); i++){
+		ConditionResponse cr = conditions[i]->evaluate(results);
+		if(combine == AND && cr == NO_MATCH)
+			return NO_MATCH;
+		if(combine == OR && cr == MATCH)
+			return MATCH;
+		if(cr == NOT_DETERMINED)
+			anyUndetermined = true;
+	}
+	if(anyUndetermined)
+		return NOT_DETERMINED;
+	return (combine == AND) ? MATCH : NO_MATCH;
+}
 
+/* CONDITION_ANY if the condition MATCHes exactly when one of predicates
+ * (its match elements) matches, and is otherwise NOT_DETERMINED when one
+ * of them is: an OR of match elements, or a single one. CONDITION_ALWAYS
+ * if it always MATCHes (an AND of nothing), CONDITION_OTHER for the rest,
+ * which evaluate(const PredicateVector&) has to decide.
+ * */
+int Condition::shape(vector<unsigned int>& predicates) const{
+	unsigned int count = 0;
+	if(!conditions.empty())
+		return CONDITION_OTHER;
+	for(unsigned int i = 0; i < mask.size(); i++){
+		for(unsigned int b = 0; b < 32; b++){
+			if(mask[i].bits & (1U << b)){
+				predicates.push_back(mask[i].word * 32 + b);
+				count++;
+			}
+		}
+	}
+	if(combine == OR || count == 1)
+		return CONDITION_ANY;
+	return (count == 0) ? CONDITION_ALWAYS : CONDITION_OTHER;
+}
+
+ConditionResponse Condition::evaluateEnvironment(const Request* req){	
 	if(combine == OR){
 		LOGD("[ENVIRONMENT] dentro OR");
-		if(!my_time_vet.empty()){
-			string req_timemin = requestEnvironment_attrs["timemin"];
-			for(unsigned int j = 0; j < my_time_vet.size(); j++){
-				if(equals(req_timemin, my_time_vet[j]->value, string2strcmp_mode(my_time_vet[j]->equal_func))){
+		if(!timemins.empty()){
+			const request_env* req_timemin = req->getEnvironmentAttr(ATTR_TIMEMIN);
+			for(unsigned int j = 0; j < timemins.size(); j++){
+				if(matchEnvironment(timemins[j], req_timemin)){
 					return MATCH;
 				}
 			}
 		}
-		if(my_daysofweek != NULL){
-			string req_daysofweek = requestEnvironment_attrs["days-of-week"];
-			if(equals(req_daysofweek, my_daysofweek->value, string2strcmp_mode("in-set")))
+		if(daysofweek != NULL){
+			if(matchDays(daysofweek, req->getEnvironmentAttr(ATTR_DAYS_OF_WEEK)))
 							return MATCH;
 		}
-		if(my_daysofmonth != NULL){
-					string req_daysofmonth = requestEnvironment_attrs["days-of-month"];
-					if(equals(req_daysofmonth, my_daysofmonth->value, string2strcmp_mode("in-set")))
+		if(daysofmonth != NULL){
+					if(matchDays(daysofmonth, req->getEnvironmentAttr(ATTR_DAYS_OF_MONTH)))
 									return MATCH;
 		}
-		if(my_roaming != NULL){
-			string req_roaming = requestEnvironment_attrs["roaming"];
-			LOGD("[ENVIRONMENT] req_roaming : %s",req_roaming.data());
-			if(equals(req_roaming, my_roaming->value, string2strcmp_mode(my_roaming->equal_func)))
+		if(roaming != NULL){
+			const request_env* req_roaming = req->getEnvironmentAttr(ATTR_ROAMING);
+			LOGD("[ENVIRONMENT] req_roaming : %s",environmentValue(req_roaming));
+			if(matchEnvironment(roaming, req_roaming))
 				return MATCH;
 		}
 		else
 			LOGD("[ENVIRONMENT] my_roaming null");
 		
-		string req_bearer = requestEnvironment_attrs["bearer-type"];
-		for(unsigned int j=0; j<my_bearer_vet.size(); j++){
-			if(equals(req_bearer, my_bearer_vet[j]->value, string2strcmp_mode(my_bearer_vet[j]->equal_func)))
+		const request_env* req_bearer = req->getEnvironmentAttr(ATTR_BEARER_TYPE);
+		for(unsigned int j=0; j<bearers.size(); j++){
+			if(matchEnvironment(bearers[j], req_bearer))
 				return MATCH;
 		}
-		string req_profile = requestEnvironment_attrs["profile"];
-		for(unsigned int j=0; j<my_profile_vet.size(); j++){
-			if(equals(req_profile, my_profile_vet[j]->value, string2strcmp_mode(my_profile_vet[j]->equal_func)))
+		const request_env* req_profile = req->getEnvironmentAttr(ATTR_PROFILE);
+		for(unsigned int j=0; j<profiles.size(); j++){
+			if(matchEnvironment(profiles[j], req_profile))
 				return MATCH;
 		}
 		return NO_MATCH;
@@ -245,83 +377,72 @@ ConditionResponse Condition::evaluateEnvironment(Request* req){
 		// find any No Match
 		LOGD("[ENVIRONMENT] dentro AND");
 
-		if(!my_time_vet.empty()){
-					string req_timemin = requestEnvironment_attrs["timemin"];
-					LOGD("timemin: %s", req_timemin.c_str());
-					for(unsigned int j = 0; j < my_time_vet.size(); j++){
-						LOGD("EQUAL FUNC: %s", my_time_vet[j]->equal_func.c_str());
-						if(!equals(req_timemin, my_time_vet[j]->value, string2strcmp_mode(my_time_vet[j]->equal_func))){
+		if(!timemins.empty()){
+					const request_env* req_timemin = req->getEnvironmentAttr(ATTR_TIMEMIN);
+					LOGD("timemin: %s", environmentValue(req_timemin));
+					for(unsigned int j = 0; j < timemins.size(); j++){
+						LOGD("EQUAL FUNC: %s", timemins[j]->equal_func.c_str());
+						if(!matchEnvironment(timemins[j], req_timemin)){
 							return NO_MATCH;
 						}
 					}
 		}
-		if(my_daysofweek != NULL){
-					string req_daysofweek = requestEnvironment_attrs["days-of-week"];
-					if(!equals(req_daysofweek, my_daysofweek->value, string2strcmp_mode("in-set")))
+		if(daysofweek != NULL){
+					if(!matchDays(daysofweek, req->getEnvironmentAttr(ATTR_DAYS_OF_WEEK)))
 									return NO_MATCH;
 				}
-		if(my_daysofmonth != NULL){
-							string req_daysofmonth = requestEnvironment_attrs["days-of-month"];
-							if(!equals(req_daysofmonth, my_daysofmonth->value, string2strcmp_mode("in-set")))
+		if(daysofmonth != NULL){
+							if(!matchDays(daysofmonth, req->getEnvironmentAttr(ATTR_DAYS_OF_MONTH)))
 									return NO_MATCH;
 		}
-		if(my_roaming != NULL){
-			string req_roaming = requestEnvironment_attrs["roaming"];
-			LOGD("[ENVIRONMENT] compare : %s with %s",req_roaming.data(),my_roaming->value.data());
-			if(!equals(req_roaming, my_roaming->value, string2strcmp_mode(my_roaming->equal_func)))
+		if(roaming != NULL){
+			const request_env* req_roaming = req->getEnvironmentAttr(ATTR_ROAMING);
+			LOGD("[ENVIRONMENT] compare : %s with %s",environmentValue(req_roaming),roaming->value.data());
+			if(!matchEnvironment(roaming, req_roaming))
 				return NO_MATCH;
 		}
 		else
 			LOGD("[ENVIRONMENT] my_roaming null");
 		
-		string req_bearer = requestEnvironment_attrs["bearer-type"];
-		for(unsigned int j=0; j<my_bearer_vet.size(); j++){
-			if(!equals(req_bearer, my_bearer_vet[j]->value, string2strcmp_mode(my_bearer_vet[j]->equal_func)))
+		const request_env* req_bearer = req->getEnvironmentAttr(ATTR_BEARER_TYPE);
+		for(unsigned int j=0; j<bearers.size(); j++){
+			if(!matchEnvironment(bearers[j], req_bearer))
 				return NO_MATCH;
 		}
-		string req_profile = requestEnvironment_attrs["profile"];
-		for(unsigned int j=0; j<my_profile_vet.size(); j++){
-			if(!equals(req_profile, my_profile_vet[j]->value, string2strcmp_mode(my_profile_vet[j]->equal_func)))
+		const request_env* req_profile = req->getEnvironmentAttr(ATTR_PROFILE);
+		for(unsigned int j=0; j<profiles.size(); j++){
+			if(!matchEnvironment(profiles[j], req_profile))
 				return NO_MATCH;
 		}
 		return MATCH;
 	}
 }
 
-ConditionResponse Condition::evaluateFeatures(Request* req){
+/* Whether any api-feature value matches info, looked up in memo if it
+ * has the result. */
+static bool matchFeature(const match_info_str* info, const request_attr& req_features, PredicateMemo* memo){
+	int known = memo ? memo->get(info->predicate) : -1;
+	if(known >= 0)
+		return known == 1;
+	bool found = matchAnyValue(info, req_features);
+	if(memo)
+		memo->set(info->predicate, found);
+	return found;
+}
+
+ConditionResponse Condition::evaluateFeatures(const Request* req, PredicateMemo* memo){
 	LOGD("[COND EVALUATE FEAT] 1 : %lu",resource_attrs.size());
-	map<string,vector<match_info_str*> >::iterator it;
-	vector<match_info_str*> my_features = (it = resource_attrs.find(API_FEATURE))!=resource_attrs.end() 
-			? it->second 
-			: vector<match_info_str*>();
-	
-	map<string, vector<string>* > requestResource_attrs = req->getResourceAttrs();
-	map<string, vector<string>* >::iterator rraIT = requestResource_attrs.find(API_FEATURE);
-	vector<string>* req_features = (rraIT != requestResource_attrs.end())
-			? rraIT->second
-			: NULL;
+	const request_attr* req_features = req->getResourceAttr(ATTR_API_FEATURE);
 	
 	bool found;	
-	bool anyUndetermined = resource_attrs.find(API_FEATURE)!= resource_attrs.end() 
-			&& requestResource_attrs.find(API_FEATURE) == requestResource_attrs.end();	
+	bool anyUndetermined = hasFeatures && req_features == NULL;
 
 	LOGD("Condition.evaluateFeatures - 03");
 	if(combine == AND){
 		LOGD("Condition.evaluateFeatures - 04");
 		// find any No Match
-		for(unsigned int j=0; req_features && j<my_features.size(); j++){
-			found = false;
-			for(unsigned int i=0; i<req_features->size(); i++){
-				string mod_function = my_features[j]->mod_func;
-				string s = (mod_function != "") 
-							? modFunction(mod_function, req_features->at(i))
-							: req_features->at(i);
-				if(equals(s,my_features[j]->value, string2strcmp_mode(my_features[j]->equal_func)))
-				{
-					found = true;
-					break;
-				}
-			}
+		for(unsigned int j=0; req_features && j<features.size(); j++){
+			found = matchFeature(features[j], *req_features, memo);
 			if (found == false)
 				return NO_MATCH;
 		}
@@ -333,15 +454,9 @@ ConditionResponse Condition::evaluateFeatures(Request* req){
 	else if(combine == OR){
 		LOGD("Condition.evaluateFeatures - 05");
 		// find any Match
-		for(unsigned int j=0; req_features && j<my_features.size(); j++){
-			for(unsigned int i=0; i<req_features->size(); i++){
-				string mod_function = my_features[j]->mod_func;
-				string s = (mod_function != "") 
-							? modFunction(mod_function, req_features->at(i))
-							: req_features->at(i);
-				if(equals(s,my_features[j]->value, string2strcmp_mode(my_features[j]->equal_func)))
-					return MATCH;
-			}
+		for(unsigned int j=0; req_features && j<features.size(); j++){
+			if(matchFeature(features[j], *req_features, memo))
+				return MATCH;
 		}
 		if (anyUndetermined)
 			return NOT_DETERMINED;
@@ -353,96 +468,105 @@ ConditionResponse Condition::evaluateFeatures(Request* req){
 	return NOT_DETERMINED;
 }
 
-ConditionResponse Condition::evaluateCapabilities(Request* req){
-	LOGD("condition: device-cap size %lu",req->getResourceAttrs()["device-cap"]->size());
-	vector<match_info_str*> my_capabilities_params;
-	vector<string>* req_capabilities_params = new vector<string>();
-	map<string, vector<string>* > requestResource_attrs = req->getResourceAttrs();
-	bool anyUndetermined = false;
-	bool found;
-	
-	for(map<string, vector<match_info_str*> >::iterator it = resource_attrs.begin(); it!= resource_attrs.end(); it++)
-	{
-		if (it->first != API_FEATURE)
+// adds the literal every value matched by info contains, see match_literal
+static bool matchLiteral(const match_info_str* info, vector<string>& out){
+	string literal;
+	if(!match_literal(info->matchers[0], literal))
+		return false;
+	out.push_back(literal);
+	return true;
+}
 
-		{
-			if(requestResource_attrs.find(it->first) == requestResource_attrs.end())
-			{
-				LOGD("Capabilities %s undetermined ",it->first.data());		
-				anyUndetermined = true;
+/* Literals one of which the request must contain for the condition not to
+ * give NO_MATCH, false if there are none: in an api-feature value for
+ * those added to features, in any other resource value for those added to
+ * capabilities (see matchAnyCapability). Only device-cap matches give
+ * capabilities, so this holds for requests that have both api-feature and
+ * device-cap attributes. An AND condition needs one of its matches, an OR
+ * condition without environment matches all of them.
+ * */
+bool Condition::resourceLiterals(vector<string>& featureLiterals, vector<string>& capabilityLiterals) const{
+	vector<string> f, c;
+	if(combine == AND){
+		for(unsigned int j = 0; j < features.size(); j++){
+			if(matchLiteral(features[j], featureLiterals))
+				return true;
+		}
+		for(unsigned int k = 0; k < capabilities.size(); k++){
+			for(unsigned int j = 0; capabilities[k].attr == ATTR_DEVICE_CAP && j < capabilities[k].matches.size(); j++){
+				if(matchLiteral(capabilities[k].matches[j], capabilityLiterals))
+					return true;
 			}
-			else
-			{
-				LOGD("Capabilities %s determined ",it->first.data());	
-				my_capabilities_params.insert(my_capabilities_params.end(), it->second.begin(), it->second.end());
+		}
+		unsigned int i = 0;
+		while(i < conditions.size() && !conditions[i]->resourceLiterals(f, c))
+			i++;
+		if(i == conditions.size())
+			return false;
+	}
+	else{
+		if(!timemins.empty() || daysofweek != NULL || daysofmonth != NULL || roaming != NULL
+				|| !bearers.empty() || !profiles.empty())
+			return false;
+		for(unsigned int j = 0; j < features.size(); j++){
+			if(!matchLiteral(features[j], f))
+				return false;
+		}
+		for(unsigned int k = 0; k < capabilities.size(); k++){
+			if(capabilities[k].attr != ATTR_DEVICE_CAP)
+				return false;
+			for(unsigned int j = 0; j < capabilities[k].matches.size(); j++){
+				if(!matchLiteral(capabilities[k].matches[j], c))
+					return false;
 			}
 		}
+		for(unsigned int i = 0; i < conditions.size(); i++){
+			if(!conditions[i]->resourceLiterals(f, c))
+				return false;
+		}
 	}
-	LOGD("[ANY CAP] %d", anyUndetermined);
+	featureLiterals.insert(featureLiterals.end(), f.begin(), f.end());
+	capabilityLiterals.insert(capabilityLiterals.end(), c.begin(), c.end());
+	return true;
+}
 
-	for(map<string, vector<string>* >::iterator itr = requestResource_attrs.begin(); itr!= requestResource_attrs.end(); itr++)
+ConditionResponse Condition::evaluateCapabilities(const Request* req, PredicateMemo* memo){
+	LOGD("condition: device-cap size %lu",req->getResourceAttr(ATTR_DEVICE_CAP) ? (unsigned long) req->getResourceAttr(ATTR_DEVICE_CAP)->count : 0);
+	const request_attr* req_attrs = req->getResources();
+	bool anyUndetermined = false;
+	
+	for(unsigned int k = 0; k < capabilities.size(); k++)
 	{
-		if (itr->first != API_FEATURE)
+		const request_attr* req_attr = (capabilities[k].attr != ATTR_UNKNOWN)
+			? req->getResourceAttr(capabilities[k].attr)
+			: req->getResourceAttr(capabilities[k].name);
+		if(req_attr == NULL)
 		{
-//			LOGD("REQ Capabilities %s", itr->first.data());
-//			LOGD("REQ Capabilities size %d", itr->second->size());
-			req_capabilities_params->insert(req_capabilities_params->end(), itr->second->begin(), itr->second->end());
+			LOGD("Capabilities %s undetermined ",capabilities[k].name.data());		
+			anyUndetermined = true;
+			continue;
 		}
-	}
-	
-	if(combine == AND){
-		// find any No Match
-		LOGD("my_capabilities_params.size() %lu",my_capabilities_params.size());
-		for(unsigned int j=0; j<my_capabilities_params.size(); j++){
-			found = false;
-			LOGD("req_capabilities_params->size() %lu",req_capabilities_params->size());
-			for(unsigned int i=0; i<req_capabilities_params->size(); i++){
-				string mod_function = my_capabilities_params[j]->mod_func;
-				string s = (mod_function != "") 
-							? modFunction(mod_function, req_capabilities_params->at(i))
-							: req_capabilities_params->at(i);
-				
-				LOGD("compare %s with %s",s.data(),my_capabilities_params[j]->value.data());
-				if(equals(s.data(),my_capabilities_params[j]->value.data(), string2strcmp_mode(my_capabilities_params[j]->equal_func)))
-//				if(equals(req_capabilities_params->at(i).data(),my_capabilities_params[j]->value.data(), string2strcmp_mode(my_capabilities_params[j]->equal_func)))
-				{
-					LOGD("They are equals");
-					found = true;
-					break;
-				}
-				else
-					LOGD("They are not equals");
-			}
-			if (found == false)
+		LOGD("Capabilities %s determined ",capabilities[k].name.data());	
+		const vector<match_info_str*>& matches = capabilities[k].matches;
+		for(unsigned int j=0; j<matches.size(); j++){
+			int known = memo ? memo->get(matches[j]->predicate) : -1;
+			bool found = (known >= 0) ? known == 1 : matchAnyCapability(matches[j], req_attrs);
+			if(memo && known < 0)
+				memo->set(matches[j]->predicate, found);
+			if(combine == AND && !found)
 				return NO_MATCH;
+			if(combine == OR && found)
+				return MATCH;
 		}
-		if (anyUndetermined)
-			return NOT_DETERMINED;
-		else
-			return MATCH;
-	}
-	else if(combine == OR){
-	// find any Match
-		for(unsigned int j=0; j<my_capabilities_params.size(); j++){
-			for(unsigned int i=0; i<req_capabilities_params->size(); i++){
-				string mod_function = my_capabilities_params[j]->mod_func;
-				string s = (mod_function != "") 
-							? modFunction(mod_function, req_capabilities_params->at(i))
-							: req_capabilities_params->at(i);
-				
-				LOGD("Compare %s with %s",s.data(),my_capabilities_params[j]->value.data());
-//				LOGD("Compare %s with %s",req_capabilities_params->at(i).data(),my_capabilities_params[j]->value.data());
-				if(equals(s.data(),my_capabilities_params[j]->value.data(), string2strcmp_mode(my_capabilities_params[j]->equal_func))){
-//				if(equals(req_capabilities_params->at(i),my_capabilities_params[j]->value, string2strcmp_mode(my_capabilities_params[j]->equal_func)))
-					return MATCH;
-				}
-			}
-		}
-		if (anyUndetermined)
-			return NOT_DETERMINED;
-		else
-			return NO_MATCH;
 	}
+	LOGD("[ANY CAP] %d", anyUndetermined);
+	
+	if (anyUndetermined)
+		return NOT_DETERMINED;
+	if(combine == AND)
+		return MATCH;
+	if(combine == OR)
+		return NO_MATCH;
 	// TODO: is that right? What should happen if policy invalid?
 	return NOT_DETERMINED;
 }
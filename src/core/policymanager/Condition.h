@@ -30,6 +30,9 @@ using namespace std;
 
 
 
+// what a condition tests, see Condition::shape
+enum ConditionShape {CONDITION_ALWAYS, CONDITION_ANY, CONDITION_OTHER};
+
 class Condition
 	{
 	
@@ -40,14 +43,34 @@ private:
 	map<string, vector<match_info_str*> >	subject_attrs;
 	map<string, vector<match_info_str*> >	environment_attrs;
 	
-	ConditionResponse evaluateFeatures(Request*);
-	ConditionResponse evaluateCapabilities(Request*);
-	ConditionResponse evaluateEnvironment(Request*);
+	// match elements resolved by attribute at load time
+	bool									hasFeatures;
+	vector<match_info_str*>					features;
+	vector<attribute_match>					capabilities;
+	match_info_str*							roaming;
+	vector<match_info_str*>					bearers;
+	vector<match_info_str*>					profiles;
+	vector<match_info_str*>					timemins;
+	match_info_str*							daysofweek;
+	match_info_str*							daysofmonth;
+	// predicates of the match elements above, see intern(PredicateTable&)
+	vector<PredicateMask>					mask;
+	
+	void resolveAttrs();
+	ConditionResponse evaluateFeatures(const Request*, PredicateMemo*);
+	ConditionResponse evaluateCapabilities(const Request*, PredicateMemo*);
+	ConditionResponse evaluateEnvironment(const Request*);
 	
 public:
 	Condition(TiXmlElement*);
 	virtual ~Condition();
-	ConditionResponse evaluate(Request *);
+	ConditionResponse evaluate(const Request *, PredicateMemo* memo = NULL);
+	ConditionResponse evaluate(const PredicateVector&) const;
+	int shape(vector<unsigned int>&) const;
+	void intern(ValueDictionary&);
+	void intern(PredicateTable&);
+	void collectReferences(AttributeReferences&);
+	bool resourceLiterals(vector<string>&, vector<string>&) const;
 	
 	};
 
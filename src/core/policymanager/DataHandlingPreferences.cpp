@@ -58,7 +58,7 @@ string DataHandlingPreferences::GetId(){
 	return policyId;
 }
 
-bool DataHandlingPreferences::evaluate(Request * req){
+bool DataHandlingPreferences::evaluate(const Request * req){
 	LOGD("Evalutaing %s DHPref", policyId.c_str());
 	if (authorizationsset != NULL) {
 		LOGD("AuthorizationsSet found");
@@ -41,7 +41,7 @@ public:
 	virtual ~DataHandlingPreferences();
 
 	string GetId();
-	bool evaluate(Request *);
+	bool evaluate(const Request *);
 };
 
 typedef map<string, DataHandlingPreferences*> DHPrefs;
@@ -0,0 +1,241 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#include "DecisionCache.h"
+#include "TriggersSet.h"
+#include <climits>
+#include <cstdlib>
+
+/*
+ * Two 64-bit lanes fed with every byte, mixed together at the end.
+ * Strings and lists are length-prefixed so that the encoding of a request
+ * is unambiguous.
+ */
+typedef struct {
+	uint64_t	h1;
+	uint64_t	h2;
+} fingerprint;
+
+static void hashBytes(fingerprint& f, const char* data, size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		unsigned char c = data[i];
+		f.h1 = (f.h1 ^ c) * 1099511628211ULL;
+		f.h2 = (f.h2 + c) * 0x9E3779B97F4A7C15ULL;
+		f.h2 ^= f.h2 >> 29;
+	}
+}
+
+static void hashInt(fingerprint& f, long value) {
+	char buf[sizeof(long)];
+	for (unsigned int i = 0; i < sizeof(long); i++)
+		buf[i] = (char) (value >> (8 * i));
+	hashBytes(f, buf, sizeof(long));
+}
+
+static void hashString(fingerprint& f, const char* s, size_t len) {
+	hashInt(f, len);
+	hashBytes(f, s, len);
+}
+
+static void hashString(fingerprint& f, const string& s) {
+	hashString(f, s.data(), s.size());
+}
+
+static void hashAttr(fingerprint& f, const request_attr* attr) {
+	if (attr == NULL) {
+		hashInt(f, -1);
+		return;
+	}
+	hashInt(f, attr->count);
+	for (unsigned int i = 0; i < attr->count; i++)
+		hashString(f, attr->values[i].data, attr->values[i].length);
+}
+
+static void hashMap(fingerprint& f, const map<string, string>& m) {
+	hashInt(f, m.size());
+	for (map<string, string>::const_iterator it = m.begin(); it != m.end(); it++) {
+		hashString(f, it->first);
+		hashString(f, it->second);
+	}
+}
+
+static uint64_t mix(uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+DecisionCache::DecisionCache() :
+		references(NULL), generation(0), hits(0), misses(0) {
+}
+
+DecisionCache::~DecisionCache() {
+}
+
+// start caching decisions of a newly loaded policy
+void DecisionCache::reset(const AttributeReferences* refs, unsigned int gen) {
+	MutexLock locked(lock);
+	references = refs;
+	generation = gen;
+	if (entries.empty()) {
+		entries.resize(DECISION_CACHE_SIZE);
+		for (unsigned int i = 0; i < entries.size(); i++)
+			entries[i].used = false;
+	}
+}
+
+void DecisionCache::makeKey(const Request* req, bool withPath, DecisionKey& key) const {
+	fingerprint f;
+	f.h1 = 14695981039346656037ULL;
+	f.h2 = 0x2545F4914F6CDD1DULL;
+
+	hashInt(f, withPath);
+	for (unsigned int i = 0; i < ATTR_COUNT; i++) {
+		if (references->subjects[i])
+			hashAttr(f, req->getSubjectAttr(i));
+	}
+	for (unsigned int i = 0; i < references->otherSubjects.size(); i++)
+		hashAttr(f, req->getSubjectAttr(references->otherSubjects[i]));
+
+	// api-feature is always looked at, other resources only by capability
+	// matches, which pool all of them
+	const request_attr* resources = req->getResources();
+	hashInt(f, resources == NULL);
+	hashAttr(f, req->getResourceAttr(ATTR_API_FEATURE));
+	if (references->capabilities) {
+		for (const request_attr* a = resources; a != NULL; a = a->next) {
+			if (a->attr == ATTR_API_FEATURE)
+				continue;
+			hashString(f, a->name, strlen(a->name));
+			hashAttr(f, a);
+		}
+	}
+
+	key.timed = references->environment[ATTR_TIMEMIN] && !references->timeExact;
+	key.timeValid = false;
+	key.timemin = 0;
+	for (unsigned int i = ATTR_ROAMING; i < ATTR_COUNT; i++) {
+		if (!references->environment[i] || (i == ATTR_TIMEMIN && key.timed))
+			continue;
+		const request_env* env = req->getEnvironmentAttr(i);
+		hashString(f, env->value ? env->value : "", env->length);
+	}
+	if (key.timed) {
+		const request_env* env = req->getEnvironmentAttr(ATTR_TIMEMIN);
+		key.timemin = atoi(env->value ? env->value : "");
+		key.timeValid = key.timemin != 0 || env->length <= 1;
+	}
+
+	// data handling preferences look at purposes and obligations
+	const vector<bool>& purpose = req->getPurposeAttrs();
+	hashInt(f, purpose.size());
+	for (unsigned int i = 0; i < purpose.size(); i++)
+		hashInt(f, purpose[i]);
+	// a TriggerAtTime may be checked against the current time
+	key.cacheable = true;
+	const obligations& obl = req->getObligationsAttrs();
+	hashInt(f, obl.size());
+	for (unsigned int i = 0; i < obl.size(); i++) {
+		hashMap(f, obl[i].action);
+		hashInt(f, obl[i].triggers.size());
+		for (unsigned int j = 0; j < obl[i].triggers.size(); j++) {
+			hashMap(f, obl[i].triggers[j]);
+			if (mapValue(obl[i].triggers[j], triggerIdTag) == triggerAtTimeTag)
+				key.cacheable = false;
+		}
+	}
+
+	key.h1 = mix(f.h1 ^ (f.h2 >> 32));
+	key.h2 = mix(f.h2 ^ f.h1);
+}
+
+bool DecisionCache::lookup(const DecisionKey& key, Effect& effect,
+		pair<string, bool>& dhpref, string* path) {
+	MutexLock locked(lock);
+	const DecisionEntry& entry = entries[key.h1 % entries.size()];
+
+	if (!key.cacheable || !entry.used || entry.generation != generation
+			|| entry.h1 != key.h1 || entry.h2 != key.h2) {
+		misses++;
+		return false;
+	}
+	if (key.timed && (entry.timeValid != key.timeValid
+			|| (key.timeValid && (key.timemin < entry.validFrom || key.timemin > entry.validUntil)))) {
+		misses++;
+		return false;
+	}
+	hits++;
+	effect = entry.effect;
+	dhpref = entry.dhpref;
+	if (path)
+		*path = entry.path;
+	return true;
+}
+
+void DecisionCache::store(const DecisionKey& key, Effect effect,
+		const pair<string, bool>& dhpref, const string* path) {
+	if (!key.cacheable)
+		return;
+	MutexLock locked(lock);
+	DecisionEntry& entry = entries[key.h1 % entries.size()];
+
+	entry.used = true;
+	entry.generation = generation;
+	entry.h1 = key.h1;
+	entry.h2 = key.h2;
+	entry.effect = effect;
+	entry.dhpref = dhpref;
+	if (path)
+		entry.path = *path;
+	else
+		entry.path.clear();
+
+	// the decision holds while timemin stays on the same side of every bound
+	entry.timeValid = key.timeValid;
+	entry.validFrom = INT_MIN;
+	entry.validUntil = INT_MAX;
+	if (key.timed && key.timeValid) {
+		const vector<int>& bounds = references->timeThresholds;
+		for (unsigned int i = 0; i < bounds.size(); i++) {
+			if (bounds[i] < key.timemin)
+				entry.validFrom = bounds[i] + 1;
+			else if (bounds[i] == key.timemin) {
+				entry.validFrom = entry.validUntil = key.timemin;
+				break;
+			}
+			else {
+				entry.validUntil = bounds[i] - 1;
+				break;
+			}
+		}
+	}
+}
+
+unsigned long DecisionCache::getHits() {
+	MutexLock locked(lock);
+	return hits;
+}
+
+unsigned long DecisionCache::getMisses() {
+	MutexLock locked(lock);
+	return misses;
+}
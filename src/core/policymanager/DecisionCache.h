@@ -0,0 +1,92 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#ifndef DECISIONCACHE_H_
+#define DECISIONCACHE_H_
+
+#include "Globals.h"
+#include "Request.h"
+#include "../mutex.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+// entries of the direct-mapped decision cache
+const unsigned int DECISION_CACHE_SIZE = 1024;
+
+/*
+ * Fingerprint of a request: a 128-bit hash of the attributes the policy
+ * references, in canonical order. A timemin only compared with numeric
+ * bounds is left out of the hash and checked against the validity
+ * horizon of the entry instead, so that a decision stays cached until
+ * the clock crosses one of the bounds.
+ */
+typedef struct {
+	uint64_t		h1;
+	uint64_t		h2;
+	bool			cacheable;		// false if the decision depends on the clock
+	bool			timed;			// timemin checked against the horizon
+	bool			timeValid;		// timemin is a number compare_numbers accepts
+	int				timemin;
+} DecisionKey;
+
+typedef struct {
+	bool				used;
+	unsigned int		generation;
+	uint64_t			h1;
+	uint64_t			h2;
+	bool				timeValid;
+	int					validFrom;		// timemin horizon, inclusive
+	int					validUntil;
+	Effect				effect;
+	pair<string, bool>	dhpref;
+	string				path;
+} DecisionEntry;
+
+/*
+ * Decisions of PolicyManager::checkRequest, keyed by request fingerprint.
+ * Entries are tagged with the generation of the policy they were computed
+ * with; moving to a new generation invalidates all of them at once.
+ * Lookups and stores may come from several threads.
+ */
+class DecisionCache
+	{
+
+private:
+	const AttributeReferences*	references;
+	vector<DecisionEntry>		entries;
+	Mutex						lock;
+	unsigned int				generation;
+	unsigned long				hits;
+	unsigned long				misses;
+
+public:
+	DecisionCache();
+	virtual ~DecisionCache();
+
+	void reset(const AttributeReferences*, unsigned int);
+	void makeKey(const Request*, bool, DecisionKey&) const;
+	bool lookup(const DecisionKey&, Effect&, pair<string, bool>&, string*);
+	void store(const DecisionKey&, Effect, const pair<string, bool>&, const string*);
+	unsigned long getHits();
+	unsigned long getMisses();
+	};
+
+#endif /* DECISIONCACHE_H_ */
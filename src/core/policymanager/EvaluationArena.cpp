@@ -0,0 +1,119 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+#include "EvaluationArena.h"
+#include <cstdlib>
+#include <new>
+
+// allocations are aligned for any scalar type
+static const size_t ARENA_ALIGN = sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*);
+
+EvaluationArena::EvaluationArena() {
+	init();
+}
+
+EvaluationArena::EvaluationArena(const EvaluationArena&) {
+	init();
+}
+
+EvaluationArena& EvaluationArena::operator=(const EvaluationArena&) {
+	return *this;
+}
+
+EvaluationArena::~EvaluationArena() {
+	for (size_t i = 1; i < chunks.size(); i++)
+		free(chunks[i].data);
+}
+
+void EvaluationArena::init() {
+	Chunk c;
+	c.data = first;
+	c.size = sizeof(first);
+	chunks.push_back(c);
+	chunk = 0;
+	offset = 0;
+	used = 0;
+	peak = 0;
+}
+
+void* EvaluationArena::allocate(size_t size) {
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+	while (offset + size > chunks[chunk].size) {
+		used += chunks[chunk].size - offset;
+		offset = 0;
+		chunk++;
+		if (chunk == chunks.size()) {
+			// each chunk at least doubles what the arena holds
+			Chunk c;
+			c.size = 2 * getCapacity();
+			if (c.size < size)
+				c.size = size;
+			c.data = (char*) malloc(c.size);
+			if (c.data == NULL) {
+				chunk--;
+				throw bad_alloc();
+			}
+			chunks.push_back(c);
+		}
+	}
+	void* result = chunks[chunk].data + offset;
+	offset += size;
+	used += size;
+	if (used > peak)
+		peak = used;
+	return result;
+}
+
+ArenaMark EvaluationArena::mark() const {
+	ArenaMark m;
+	m.chunk = chunk;
+	m.offset = offset;
+	m.used = used;
+	return m;
+}
+
+// everything allocated after the mark is gone
+void EvaluationArena::rewind(const ArenaMark& m) {
+	chunk = m.chunk;
+	offset = m.offset;
+	used = m.used;
+}
+
+void EvaluationArena::reset() {
+	chunk = 0;
+	offset = 0;
+	used = 0;
+}
+
+size_t EvaluationArena::getUsed() const {
+	return used;
+}
+
+// most bytes ever in use at once
+size_t EvaluationArena::getPeak() const {
+	return peak;
+}
+
+size_t EvaluationArena::getCapacity() const {
+	size_t total = 0;
+	for (size_t i = 0; i < chunks.size(); i++)
+		total += chunks[i].size;
+	return total;
+}
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+#ifndef EVALUATIONARENA_H_
+#define EVALUATIONARENA_H_
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+// bytes an arena holds before it needs the heap
+const unsigned int EVALUATION_INLINE_BYTES = 4096;
+
+// position of an arena, see EvaluationArena::rewind
+typedef struct {
+	size_t	chunk;
+	size_t	offset;
+	size_t	used;
+} ArenaMark;
+
+/*
+ * Bump allocator for what one evaluation builds and throws away: path
+ * descriptors and, for the calls that reuse a context, the request itself.
+ * Memory is never given back one object at a time; rewinding to a mark
+ * (or resetting) takes the same time whatever was allocated, and the
+ * chunks stay for the next evaluation on the same context. Destructors
+ * are not run, so only objects that own nothing outside the arena go in.
+ */
+class EvaluationArena
+	{
+
+private:
+	typedef struct {
+		char*	data;
+		size_t	size;
+	} Chunk;
+
+	char			first[EVALUATION_INLINE_BYTES];
+	vector<Chunk>	chunks;			// chunks[0] is first, the others are on the heap
+	size_t			chunk;			// chunk being filled
+	size_t			offset;
+	size_t			used;			// bytes taken since the reset, chunk tails included
+	size_t			peak;
+
+	void init();
+
+public:
+	EvaluationArena();
+	// an arena is never shared: copies start empty
+	EvaluationArena(const EvaluationArena&);
+	EvaluationArena& operator=(const EvaluationArena&);
+	virtual ~EvaluationArena();
+
+	void* allocate(size_t);
+	ArenaMark mark() const;
+	void rewind(const ArenaMark&);
+	void reset();
+	size_t getUsed() const;
+	size_t getPeak() const;
+	size_t getCapacity() const;
+	};
+
+// objects placed with new (arena) T(...)
+inline void* operator new(size_t size, EvaluationArena& arena) {
+	return arena.allocate(size);
+}
+
+// only called if a constructor throws; the memory goes back with the arena
+inline void operator delete(void*, EvaluationArena&) {
+}
+
+#endif /* EVALUATIONARENA_H_ */
@@ -18,61 +18,139 @@
  ******************************************************************************/
 
 #include "Globals.h"
+#include <cstring>
 
+CombiningAlgorithm string2algorithm(const string& alg){
+	if(alg == deny_overrides_algorithm)
+		return DENY_OVERRIDES;
+	if(alg == permit_overrides_algorithm)
+		return PERMIT_OVERRIDES;
+	if(alg == first_applicable_algorithm)
+		return FIRST_APPLICABLE;
+	if(alg == first_matching_target_algorithm)
+		return FIRST_MATCHING_TARGET;
+	return UNKNOWN_ALGORITHM;
+}
+
+typedef struct {
+	const char*		name;
+	AttributeId		attr;
+} attribute_name;
 
-string modFunction(const string& func, const string& val){
+// sorted by name for binary search
+static const attribute_name attribute_names[] = {
+	{"api-feature", ATTR_API_FEATURE},
+	{"author-key-cn", ATTR_AUTHOR_KEY_CN},
+	{"author-key-fingerprint", ATTR_AUTHOR_KEY_FINGERPRINT},
+	{"author-key-root-cn", ATTR_AUTHOR_KEY_ROOT_CN},
+	{"author-key-root-fingerprint", ATTR_AUTHOR_KEY_ROOT_FINGERPRINT},
+	{"bearer-type", ATTR_BEARER_TYPE},
+	{"days-of-month", ATTR_DAYS_OF_MONTH},
+	{"days-of-week", ATTR_DAYS_OF_WEEK},
+	{"device-cap", ATTR_DEVICE_CAP},
+	{"distributor-key-cn", ATTR_DISTRIBUTOR_KEY_CN},
+	{"distributor-key-fingerprint", ATTR_DISTRIBUTOR_KEY_FINGERPRINT},
+	{"distributor-key-root-cn", ATTR_DISTRIBUTOR_KEY_ROOT_CN},
+	{"distributor-key-root-fingerprint", ATTR_DISTRIBUTOR_KEY_ROOT_FINGERPRINT},
+	{"id", ATTR_ID},
+	{"param:feature", ATTR_PARAM_FEATURE},
+	{"profile", ATTR_PROFILE},
+	{"requestor-domain", ATTR_REQUESTOR_DOMAIN},
+	{"requestor-id", ATTR_REQUESTOR_ID},
+	{"roaming", ATTR_ROAMING},
+	{"service-id", ATTR_SERVICE_ID},
+	{"target-domain", ATTR_TARGET_DOMAIN},
+	{"target-id", ATTR_TARGET_ID},
+	{"timemin", ATTR_TIMEMIN},
+	{"user-id", ATTR_USER_ID},
+	{"user-key-cn", ATTR_USER_KEY_CN},
+	{"user-key-fingerprint", ATTR_USER_KEY_FINGERPRINT},
+	{"user-key-root-cn", ATTR_USER_KEY_ROOT_CN},
+	{"user-key-root-fingerprint", ATTR_USER_KEY_ROOT_FINGERPRINT},
+	{"webinos-enabled", ATTR_WEBINOS_ENABLED}
+};
+
+AttributeId string2attribute(const string& name){
+	int low = 0;
+	int high = ATTR_COUNT - 1;
+	while(low <= high){
+		int mid = (low + high) / 2;
+		int cmp = strcmp(name.c_str(), attribute_names[mid].name);
+		if(cmp == 0)
+			return (name.size() == strlen(attribute_names[mid].name)) ? attribute_names[mid].attr : ATTR_UNKNOWN;
+		if(cmp < 0)
+			high = mid - 1;
+		else
+			low = mid + 1;
+	}
+	return ATTR_UNKNOWN;
+}
+
+const char* attribute2string(AttributeId attr){
+	for(unsigned int i = 0; i < ATTR_COUNT; i++){
+		if(attribute_names[i].attr == attr)
+			return attribute_names[i].name;
+	}
+	return "";
+}
+
+// the part of val that func selects, a view of the same characters
+StringView modFunction(const string& func, const StringView& val){
 	// func = {scheme, host, authority, scheme-authority, path}
-	unsigned int pos = val.find(":");
-	unsigned int pos1 = val.find_last_of("/",pos+2);
-	unsigned int pos2 = val.find("/",pos1+1);
+	unsigned int pos = val.find(':');
+	unsigned int pos1 = val.find_last_of('/',pos+2);
+	unsigned int pos2 = val.find('/',pos1+1);
 	
 	if(func == "scheme"){
 		if(pos != string::npos)
 			return val.substr(0,pos);
 	}
 	else if(func == "authority" || func == "host"){	
-		string authority = val.substr(pos1+1, pos2-pos1-1);
+		StringView authority = val.substr(pos1+1, pos2-pos1-1);
 		if(func == "authority")
 			return authority;
 		else{
-			unsigned int pos_at = authority.find("@")+1;
-			unsigned int pos3 = authority.find(":");
+			unsigned int pos_at = authority.find('@')+1;
+			unsigned int pos3 = authority.find(':');
 			if(pos_at == string::npos)
 				pos_at = 0;
 			if(pos3 == string::npos)
-				pos3 = authority.length();
+				pos3 = authority.length;
 			return authority.substr(pos_at, pos3-pos_at);
 		}
 	}
 	else if(func == "scheme-authority"){
 		if(pos2-pos1 == 1)
-			return "";
+			return StringView();
 		return val.substr(0, pos2);
 	}
 	else if(func == "path"){
-		unsigned int pos4 = val.find("?");
+		unsigned int pos4 = val.find('?');
 		if(pos4 == string::npos)
-			pos4 = val.length();
+			pos4 = val.length;
 		return val.substr(pos2, pos4-pos2);
 	}
-	return "";
+	return StringView();
+}
+
+// m[key] without inserting key, "" if it is missing
+const string& mapValue(const map<string, string>& m, const string& key){
+	static const string empty;
+	map<string, string>::const_iterator it = m.find(key);
+	return (it != m.end()) ? it->second : empty;
 }
 
-vector<string> split(const string& str, const char& ch) {
-    string next;
-    vector<string> result;
+// non-empty fields of str, views of its characters
+vector<StringView> split(const StringView& str, const char& ch) {
+    vector<StringView> result;
+    size_t start = 0;
 
-    for (string::const_iterator it = str.begin(); it != str.end(); it++) {
-        if (*it == ch) {
-            if (!next.empty()) {
-                result.push_back(next);
-                next.clear();
-            }
-        } else {
-            next += *it;
+    for (size_t i = 0; i <= str.length; i++) {
+        if (i == str.length || str.data[i] == ch) {
+            if (i > start)
+                result.push_back(str.substr(start, i - start));
+            start = i + 1;
         }
     }
-    if (!next.empty())
-         result.push_back(next);
     return result;
 }
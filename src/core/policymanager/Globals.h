@@ -22,6 +22,8 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include "../../core/common.h"
 using namespace std;
 
 enum PolicyType {POLICY_SET, POLICY};
@@ -30,6 +32,25 @@ enum Action {ALLOW_THIS_TIME, DENY_THIS_TIME, ALLOW_THIS_SESSION, DENY_THIS_SESS
 enum Combine {AND, OR};
 enum ConditionResponse {NOT_DETERMINED=-1, NO_MATCH=0, MATCH=1};
 enum EvalResponse {WGINFO_ERR, REF_ERR, POLICY_ERR, EVAL_OK};
+enum CombiningAlgorithm {DENY_OVERRIDES, PERMIT_OVERRIDES, FIRST_APPLICABLE, FIRST_MATCHING_TARGET, UNKNOWN_ALGORITHM};
+
+// well-known attribute names, resolved once to index request and policy slots
+enum AttributeId {
+	// subject
+	ATTR_USER_ID, ATTR_USER_KEY_CN, ATTR_USER_KEY_FINGERPRINT, ATTR_USER_KEY_ROOT_CN,
+	ATTR_USER_KEY_ROOT_FINGERPRINT, ATTR_ID, ATTR_DISTRIBUTOR_KEY_CN,
+	ATTR_DISTRIBUTOR_KEY_FINGERPRINT, ATTR_DISTRIBUTOR_KEY_ROOT_CN,
+	ATTR_DISTRIBUTOR_KEY_ROOT_FINGERPRINT, ATTR_AUTHOR_KEY_CN, ATTR_AUTHOR_KEY_FINGERPRINT,
+	ATTR_AUTHOR_KEY_ROOT_CN, ATTR_AUTHOR_KEY_ROOT_FINGERPRINT, ATTR_TARGET_ID,
+	ATTR_TARGET_DOMAIN, ATTR_REQUESTOR_ID, ATTR_REQUESTOR_DOMAIN, ATTR_WEBINOS_ENABLED,
+	// resource
+	ATTR_API_FEATURE, ATTR_SERVICE_ID, ATTR_DEVICE_CAP, ATTR_PARAM_FEATURE,
+	// environment
+	ATTR_ROAMING, ATTR_BEARER_TYPE, ATTR_PROFILE, ATTR_TIMEMIN, ATTR_DAYS_OF_WEEK,
+	ATTR_DAYS_OF_MONTH,
+	ATTR_COUNT,
+	ATTR_UNKNOWN = ATTR_COUNT
+};
 
 #define first_matching_target_algorithm 	"first-matching-target"
 #define deny_overrides_algorithm			"deny-overrides"
@@ -39,7 +60,11 @@ enum EvalResponse {WGINFO_ERR, REF_ERR, POLICY_ERR, EVAL_OK};
 #define API_FEATURE			"api-feature"
 #define DEVICE_CAPABILITY 		"device-cap"
 
-string modFunction(const string& func, const string& val);
-vector<string> split(const string& str, const char& ch);
+CombiningAlgorithm string2algorithm(const string& alg);
+AttributeId string2attribute(const string& name);
+const char* attribute2string(AttributeId attr);
+StringView modFunction(const string& func, const StringView& val);
+const string& mapValue(const map<string, string>& m, const string& key);
+vector<StringView> split(const StringView& str, const char& ch);
 
 #endif /* GLOBALS_H_ */
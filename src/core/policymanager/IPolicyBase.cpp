@@ -42,16 +42,6 @@ IPolicyBase::~IPolicyBase()
 	// TODO Auto-generated destructor stub
 	}
 
-bool IPolicyBase::matchSubject(Request*){
-	return false;
-}
-
-Effect IPolicyBase::evaluate(Request*, pair<string, bool>*){
-	return DENY;
-}
-Effect IPolicyBase::evaluate(Request*, pair<string, bool>*, IPolicyBaseDescriptor*&){
-	return DENY;
-}
 PolicyType IPolicyBase::get_iType(){
 	return POLICY_SET;
 }
@@ -43,9 +43,6 @@ public:
 	IPolicyBase(IPolicyBase*);
 	virtual ~IPolicyBase();
 	
-	virtual bool matchSubject(Request* req);
-	virtual Effect evaluate(Request* req, pair<string, bool>*);
-	virtual Effect evaluate(Request* req, pair<string, bool>*, IPolicyBaseDescriptor*&);
 	virtual PolicyType get_iType();
 	
 protected:
@@ -5,25 +5,34 @@
  *      Author: valerio
  */
 #include "IPolicyBaseDescriptor.h"
-IPolicyBaseDescriptor::IPolicyBaseDescriptor() {
-	id = "";
-	position = 0;
-	type = POLICY;
-}
-IPolicyBaseDescriptor::IPolicyBaseDescriptor(string id) {
+#include <stdio.h>
+IPolicyBaseDescriptor::IPolicyBaseDescriptor(const string* id, const string* combine) {
 	this->id = id;
+	this->combine = combine;
 	position = 0;
+	effect = INAPPLICABLE;
 	type = POLICY;
+	next = NULL;
 }
 IPolicyBaseDescriptor::~IPolicyBaseDescriptor() {
 
 }
 string IPolicyBaseDescriptor::toJSONString() {
-	return "HERE";
+	string result;
+	appendJSON(result);
+	return result;
+}
+void IPolicyBaseDescriptor::appendJSON(string& out) {
+	out.append("HERE");
 }
 string IPolicyBaseDescriptor::numberToString(int number) {
 	ostringstream ss;
 	ss << number;
 	return ss.str();
 }
+void IPolicyBaseDescriptor::appendNumber(string& out, int number) {
+	char buf[16];
+	snprintf(buf, sizeof(buf), "%d", number);
+	out.append(buf);
+}
 
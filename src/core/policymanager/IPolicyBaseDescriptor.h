@@ -8,19 +8,29 @@
 #ifndef IPOLICYBASEDESCRIPTOR_H_
 #define IPOLICYBASEDESCRIPTOR_H_
 #include "Globals.h"
+#include "EvaluationArena.h"
 #include <sstream>
+
+/*
+ * Descriptors are built in the EvaluationArena of the evaluation and are
+ * never deleted: they only point to strings of the PolicyProgram and to
+ * other descriptors of the same arena.
+ */
 class IPolicyBaseDescriptor{
 public:
-	string id;
+	const string* id;
 	int position;
     int effect;
 	PolicyType type;
-	string combine;
-	IPolicyBaseDescriptor();
-	IPolicyBaseDescriptor(string id);
+	const string* combine;
+	IPolicyBaseDescriptor* next;	// next child of the same parent
+	IPolicyBaseDescriptor(const string* id, const string* combine);
 	virtual ~IPolicyBaseDescriptor();
-	virtual string toJSONString();
+	string toJSONString();
+	// appends the JSON description to out, which keeps its capacity
+	virtual void appendJSON(string& out);
 	static string numberToString(int number);
+	static void appendNumber(string& out, int number);
 };
 
 
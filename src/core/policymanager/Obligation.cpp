@@ -54,18 +54,18 @@ Obligation::~Obligation(){
 		delete triggersset;
 }
 
-bool Obligation::evaluate(Request * req){
+bool Obligation::evaluate(const Request * req){
 
 	if (action.empty() == true)
 		return true;
 	else {
-		obligations ob = req->getObligationsAttrs();
-		for (obligations::iterator oit=ob.begin(); oit!=ob.end(); oit++){
+		const obligations& ob = req->getObligationsAttrs();
+		for (obligations::const_iterator oit=ob.begin(); oit!=ob.end(); oit++){
 			// ActionDeletePersonalData, ActionAnonymizePersonalData and ActionSecureLog evaluation
 			// subset of ActionLog evaluation (exact match only)
-			if (action[actionIdTag] == actionDeleteTag || action[actionIdTag] == actionAnonymizeTag || 
-					action[actionIdTag] == actionLogTag || action[actionIdTag] == actionSecureLogTag) {
-				if ((*oit).action[actionIdTag].compare(action[actionIdTag]) == 0){
+			if (mapValue(action, actionIdTag) == actionDeleteTag || mapValue(action, actionIdTag) == actionAnonymizeTag || 
+					mapValue(action, actionIdTag) == actionLogTag || mapValue(action, actionIdTag) == actionSecureLogTag) {
+				if (mapValue((*oit).action, actionIdTag).compare(mapValue(action, actionIdTag)) == 0){
 					if (triggersset->evaluate((*oit).triggers) == true)
 						return true;
 				}
@@ -73,16 +73,16 @@ bool Obligation::evaluate(Request * req){
 			// ActionNotifyDataSubject evaluation
 			else {
 				// ActionNotifyDataSubject parameters are the same
-				if ((*oit).action[actionIdTag].compare(actionNotifyTag) == 0 && 
-						(*oit).action[mediaTag].compare(action[mediaTag]) == 0 &&
-						 (*oit).action[addressTag].compare(action[addressTag]) == 0){
+				if (mapValue((*oit).action, actionIdTag).compare(actionNotifyTag) == 0 && 
+						mapValue((*oit).action, mediaTag).compare(mapValue(action, mediaTag)) == 0 &&
+						 mapValue((*oit).action, addressTag).compare(mapValue(action, addressTag)) == 0){
 					if (triggersset->evaluate((*oit).triggers) == true)
 						return true;
 				}
 			}
 			// subset of ActionLog evaluation (ActionLog is satisfied by ActionSecureLog too)
-			if ((*oit).action[actionIdTag].compare(actionSecureLogTag) == 0 &&
-					action[actionIdTag].compare(actionLogTag) == 0){
+			if (mapValue((*oit).action, actionIdTag).compare(actionSecureLogTag) == 0 &&
+					mapValue(action, actionIdTag).compare(actionLogTag) == 0){
 				if (triggersset->evaluate((*oit).triggers) == true)
 					return true;
 			}
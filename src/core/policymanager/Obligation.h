@@ -44,7 +44,7 @@ public:
 	Obligation(TiXmlElement*);
 	virtual ~Obligation();
 
-	bool evaluate(Request *);
+	bool evaluate(const Request *);
 };
 
 #endif /* OBLIGATION_H_ */
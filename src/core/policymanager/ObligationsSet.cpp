@@ -36,7 +36,7 @@ ObligationsSet::~ObligationsSet(){
 	}
 }
 
-bool ObligationsSet::evaluate(Request * req){
+bool ObligationsSet::evaluate(const Request * req){
 
 	for(unsigned int i = 0; i<obligation.size(); i++){
 		LOGD("ObligationsSet: evalutaing obligation %d", i);
@@ -35,7 +35,7 @@ public:
 	ObligationsSet(TiXmlElement*);
 	virtual ~ObligationsSet();
 
-	bool evaluate(Request *);
+	bool evaluate(const Request *);
 };
 
 #endif /* OBLIGATIONSSET_H_ */
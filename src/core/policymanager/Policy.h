@@ -27,8 +27,6 @@
 #include "../../debug.h"
 #include "DataHandlingPreferences.h"
 #include "ProvisionalActions.h"
-#include "PolicyDescriptor.h"
-#include "IPolicyBaseDescriptor.h"
 
 class Policy : public IPolicyBase
 	{
@@ -39,16 +37,13 @@ private:
 	vector<Rule*>		rules;
 	DHPrefs*			datahandlingpreferences;
 	vector<ProvisionalActions*>		provisionalactions;
-	void selectDHPref(Request*, pair<string, bool>*);
 	
+	friend class PolicyProgram;
 	
 public:
 	Policy(TiXmlElement*, DHPrefs*, map<string, vector<string>*> *);
 	virtual ~Policy();
 	
-	bool matchSubject(Request*);
-	Effect evaluate(Request*, pair<string, bool>*);
-	Effect evaluate(Request*, pair<string, bool>*, IPolicyBaseDescriptor*&);
 	PolicyType get_iType();
 //	static string modFunction(const string&, const string&);
 	
@@ -8,80 +8,80 @@
 #include "../../debug.h"
 #include <stdio.h>
 
-PolicyDescriptor::PolicyDescriptor() {
-	this->type = POLICY;
-}
-PolicyDescriptor::PolicyDescriptor(string id) {
-	this->id = id;
+PolicyDescriptor::PolicyDescriptor(const string* id, const string* combine)
+	: IPolicyBaseDescriptor(id, combine) {
 	this->type = POLICY;
+	rules = NULL;
+	lastRule = NULL;
+	effects = 0;
 }
 PolicyDescriptor::~PolicyDescriptor() {
-	/*
-	 for(map<Effect, vector<pair<string, int>* >* >::iterator itmap = rules.begin(); itmap != rules.end(); itmap++){
-	 for(vector<pair<string, int>* >::iterator itvec = itmap->second->begin(); itmap->second->end(); itvec++){
-	 delete (*itvec);
-	 }
-	 delete  *itmap;
-	 }
-	 delete rules;
-	 */
 }
-void PolicyDescriptor::addRule(int effect, string id, int position) {
-	vector<pair<string, int> > effectRules;
-	if (rules.find(effect) == rules.end()) {
-		pair<int, vector<pair<string, int> > > effectRules;
-		effectRules.first = effect;
-		rules.insert(effectRules);
-	}
-	pair<string, int> value;
-	value.first = id;
-	value.second = position;
-	rules[effect].push_back(value);
+void PolicyDescriptor::addRule(EvaluationArena& arena, int effect, const string* id, int position) {
+	RuleDescriptor* rule = new (arena) RuleDescriptor;
+	rule->effect = effect;
+	rule->id = id;
+	rule->position = position;
+	rule->next = NULL;
+	if (lastRule == NULL)
+		rules = rule;
+	else
+		lastRule->next = rule;
+	lastRule = rule;
+	effects |= 1u << effect;
 	LOGD("[PolicyDescriptor] Added Rule with effect: %d, id: %s, position: %d",
-			effect, id.c_str(), position);
+			effect, id->c_str(), position);
 }
-string PolicyDescriptor::toJSONString() {
-	string result = "";
-	LOGD("[PolicyDescriptor] ID = %s, POSITION = %d", id.c_str(), position);
+// rules are listed by effect, in the order added within an effect
+void PolicyDescriptor::appendJSON(string& result) {
+	LOGD("[PolicyDescriptor] ID = %s, POSITION = %d", id->c_str(), position);
 
 	result.append("{");
 
 	result.append(" \"type\":\"policy\", ");
-	result.append(" \"id\":\"" + id + "\", ");
-	result.append(" \"combine\":\"" + combine + "\",");
-	result.append(" \"effect\":\"" + IPolicyBaseDescriptor::numberToString(effect) + "\",");
+	result.append(" \"id\":\"").append(*id).append("\", ");
+	result.append(" \"combine\":\"").append(*combine).append("\",");
+	result.append(" \"effect\":\"");
+	appendNumber(result, effect);
+	result.append("\",");
 
-	result.append(" \"position\":\"" + IPolicyBaseDescriptor::numberToString(position) + "\"" );
-	if (!rules.empty()) {
+	result.append(" \"position\":\"");
+	appendNumber(result, position);
+	result.append("\"");
+	if (rules != NULL) {
 		result.append(", ");
 		result.append(" \"rules\":");
 		result.append("{");
-		for (map<int, vector<pair<string, int> > >::iterator itmap =
-				rules.begin(); itmap != rules.end(); ) {
-			LOGD("[PolicyDescriptor] Effect = %d", itmap->first);
-			result.append(" \""+ IPolicyBaseDescriptor::numberToString(itmap->first)+"\": [");
-			for (vector<pair<string, int> >::iterator itvec =
-					itmap->second.begin(); itvec != itmap->second.end();
-					) {
+		unsigned int left = effects;
+		for (int e = 0; left != 0; e++) {
+			if ((left & (1u << e)) == 0)
+				continue;
+			left &= ~(1u << e);
+			LOGD("[PolicyDescriptor] Effect = %d", e);
+			result.append(" \"");
+			appendNumber(result, e);
+			result.append("\": [");
+			bool first = true;
+			for (RuleDescriptor* rule = rules; rule != NULL; rule = rule->next) {
+				if (rule->effect != e)
+					continue;
 				LOGD("[PolicyDescriptor]Rule id = %s, position = %d",
-						itvec->first.c_str(), itvec->second);
+						rule->id->c_str(), rule->position);
+				if (!first)
+					result.append(", ");
+				first = false;
 				result.append("{");
-				result.append("\"id\":\""+itvec->first+"\", ");
-				result.append("\"position\":\""+IPolicyBaseDescriptor::numberToString(itvec->second)+"\"");
+				result.append("\"id\":\"").append(*rule->id).append("\", ");
+				result.append("\"position\":\"");
+				appendNumber(result, rule->position);
+				result.append("\"");
 				result.append("}");
-				itvec++;
-				if(itvec != itmap->second.end()){
-					result.append(", ");
-				}
 			}
 			result.append("]");
-			itmap++;
-			if(itmap != rules.end())
+			if (left != 0)
 				result.append(", ");
 		}
 		result.append("}");
 	}
 	result.append("}");
-	return result;
 }
-
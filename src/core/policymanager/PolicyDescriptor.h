@@ -9,18 +9,24 @@
 #define POLICYDESCRIPTOR_H_
 #include "Globals.h"
 #include "IPolicyBaseDescriptor.h"
-#include <map>
-#include <vector>
+
+typedef struct RuleDescriptor {
+	int				effect;
+	const string*	id;
+	int				position;
+	RuleDescriptor*	next;
+} RuleDescriptor;
 
 class PolicyDescriptor : public IPolicyBaseDescriptor{
 public:
-	PolicyDescriptor();
-	PolicyDescriptor(string id);
+	PolicyDescriptor(const string* id, const string* combine);
 	virtual ~PolicyDescriptor();
-	void addRule(int effect, string id, int position);
-	string toJSONString();
+	void addRule(EvaluationArena& arena, int effect, const string* id, int position);
+	void appendJSON(string& out);
 private:
-	map<int,vector<pair<string, int> > > rules;
+	RuleDescriptor* rules;		// in the order added
+	RuleDescriptor* lastRule;
+	unsigned int effects;		// bit set of the effects of rules
 };
 
 
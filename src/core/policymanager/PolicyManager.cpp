@@ -19,13 +19,24 @@
 
 #include "PolicyManager.h"
 #include "../../debug.h"
+#include "../mutex.h"
+#include <algorithm>
+
+// generation of every policy loaded by this process, see DecisionCache
+static unsigned int policy_generation = 0;
+static Mutex generation_lock;
+
+static unsigned int nextGeneration(){
+	MutexLock lock(generation_lock);
+	return ++policy_generation;
+}
 
 PolicyManager::PolicyManager()
-	:dhp(0), pip(0)
+	:policyDocument(0), program(0), validPolicyFile(false), arenaPeak(0), dhp(0), pip(0)
 {}
 
 PolicyManager::PolicyManager(const string & policyFileName, map<string, vector<string>*>* info)
-	:dhp(0), pip(0)
+	:policyDocument(0), program(0), arenaPeak(0), dhp(0), pip(0)
 {
 	TiXmlDocument doc(policyFileName);
 	LOGD("Policy manager file : %s",policyFileName.data());
@@ -46,6 +57,9 @@ PolicyManager::PolicyManager(const string & policyFileName, map<string, vector<s
 			LOGD("DHPref number after PolicySet element creation: %lu", (*dhp).size());
 		}
 		policyName = policyDocument->description;
+		program = new PolicyProgram(policyDocument, dhp);
+		LOGD("Policy program size: %u nodes", program->size());
+		cache.reset(&program->getReferences(), nextGeneration());
 	}
 	else{
 		validPolicyFile = false;
@@ -64,150 +78,331 @@ PolicyManager::PolicyManager(const string & policyFileName, map<string, vector<s
 }
 
 PolicyManager::~PolicyManager() {
+	delete program;
+	if (dhp == NULL)
+		return;
 	for (map<string, DataHandlingPreferences*>::iterator it = dhp->begin(); it != dhp->end(); it++)
 		delete (*it).second;
 }
 
+// attributes the loaded policy can look at, NULL if it failed to load
+const AttributeReferences* PolicyManager::getReferences() const{
+	return program ? &program->getReferences() : NULL;
+}
+
+/*
+ * Regexp and glob values of the loaded policy that did not compile, as
+ * "value: reason"; they match no request.
+ */
+vector<string> PolicyManager::getMatchErrors() const{
+	vector<string> errors;
+	if(program)
+		program->getMatchErrors(errors);
+	return errors;
+}
+
+/*
+ * EvaluationMode of the loaded policy; both give the same decisions, so
+ * the decision cache stays valid. Not to be changed while requests are
+ * being checked.
+ */
+void PolicyManager::setEvaluationMode(int mode){
+	if(program)
+		program->setMode(mode);
+}
+
+PolicyStatistics PolicyManager::getStatistics(){
+	PolicyStatistics stats;
+	stats.cacheHits = cache.getHits();
+	stats.cacheMisses = cache.getMisses();
+	MutexLock locked(statsLock);
+	stats.arenaPeak = arenaPeak;
+	return stats;
+}
+
 string PolicyManager::getPolicyName(){
 	return policyName;
 }
 
 Effect PolicyManager::checkRequest(Request * req){
-	Effect xacml_eff;
-	bool dhp_eff = false;
-	int features = 0;
-	vector<bool> purpose = req->getPurposeAttrs();
+	EvaluationContext context;
+	context.withPath = false;
+	return checkRequest(req, context);
+}
 
-	LOGD("Policy manager start check");
-	if(validPolicyFile) {
-		selectedDHPref.first.clear();
-		selectedDHPref.second = false;
-		xacml_eff = policyDocument->evaluate(req, &selectedDHPref);
-		LOGD("XACML response: %d", xacml_eff);
-
-		// valid purposes vector
-		LOGD("Ontology size = %d",arraysize(ontology_vector));
-		if (purpose.size() == arraysize(ontology_vector)) {
-			LOGD("PolicyManager: valid purposes vector");
-
-			// in ProvisionalAction tags a single resouce requires a single DHPref
-			// no more than one resouce must be used in non installation enforceRequest call
-			if ((req->getResourceAttrs()).count(API_FEATURE) == 1) {
-				features = (req->getResourceAttrs())[API_FEATURE]->size();
-			}
-			if (features == 1){
-				LOGD("One feature requested, DHPref evaluation started");
-				if (selectedDHPref.first.empty() == false) {
-					LOGD("Selected DHPref: %s", selectedDHPref.first.c_str());
-					DHPrefs::iterator it;
-					it=(*dhp).find(selectedDHPref.first);
-					if (it == (*dhp).end()){
-						LOGD("DHPref: %s not found", selectedDHPref.first.c_str());
-					}
-					else {	
-						LOGD("DHPref: %s found", selectedDHPref.first.c_str());
-						dhp_eff = (*dhp)[selectedDHPref.first]->evaluate(req);
-					}
-				}
-			}
-			// in installation enforceRequest call more resource parameters can be used
-			// the result of Data handling preferences evaluation is set to true because
-			// the XACML response only is significant
-			else {
-				LOGD("%d features requested, DHPref evaluation skipped", features);
-				dhp_eff = true;
-			}
-		}
-		// invalid purposes vector
-		else {
-			LOGD("PolicyManager: invalid purposes vector");
-		}
+Effect PolicyManager::checkRequest(Request * req, string& path){
+	EvaluationContext context;
+	context.withPath = true;
+	Effect eff = checkRequest(req, context);
+	if(validPolicyFile)
+		path = context.path;
+	return eff;
+}
+
+/*
+ * The loaded policy is never modified after construction: everything an
+ * evaluation produces goes to the context, so concurrent calls only share
+ * the decision cache, which locks itself.
+ */
+Effect PolicyManager::checkRequest(Request * req, EvaluationContext& context){
+	if(!validPolicyFile)
+		return INAPPLICABLE;
+	return decide(req, context, NULL);
+}
+
+// size of the units of work a batch is split into
+static const unsigned int BATCH_CHUNK = 16;
+
+// orders batch positions by the subject attributes of their request
+typedef struct {
+	const vector<Request*>* reqs;
+	bool operator()(unsigned int a, unsigned int b) const {
+		return (*reqs)[a]->compareSubject(*(*reqs)[b]) < 0;
+	}
+} SubjectOrder;
+
+// orders batch positions by decision key, so that repeated requests are adjacent
+typedef struct {
+	const vector<DecisionKey>* keys;
+	bool operator()(unsigned int a, unsigned int b) const {
+		const DecisionKey& x = (*keys)[a];
+		const DecisionKey& y = (*keys)[b];
+		if (x.h1 != y.h1)
+			return x.h1 < y.h1;
+		if (x.h2 != y.h2)
+			return x.h2 < y.h2;
+		if (x.timeValid != y.timeValid)
+			return x.timeValid < y.timeValid;
+		return x.timemin < y.timemin;
+	}
+} KeyOrder;
 
-		if (dhp_eff == true){
-			LOGD("DHP response: true");
+static bool sameDecision(const DecisionKey& x, const DecisionKey& y){
+	return x.cacheable && y.cacheable && x.h1 == y.h1 && x.h2 == y.h2
+		&& x.timeValid == y.timeValid && x.timemin == y.timemin;
+}
+
+/*
+ * Requests of a batch that the decision cache could not answer, split in
+ * chunks of requests with the same subject attributes. Every worker has
+ * its own evaluation context and subject memo and only writes the results
+ * of the requests it evaluates, so the workers share nothing but the
+ * read-only policy and take no lock.
+ */
+class BatchEvaluation : public ThreadTask
+	{
+
+public:
+	PolicyManager*					manager;
+	const vector<Request*>*			reqs;
+	vector<unsigned int>			order;		// requests to evaluate
+	vector<unsigned int>			chunks;		// first position in order of each chunk, then the end
+	vector<EvaluationContext>		contexts;	// per worker
+	vector<SubjectMemo>				memos;		// per worker
+	vector<Effect>*					effects;
+	vector< pair<string, bool> >	dhprefs;
+	vector<string>*					paths;
+
+	void run(unsigned int worker, unsigned int chunk){
+		EvaluationContext& context = contexts[worker];
+		SubjectMemo& memo = memos[worker];
+
+		manager->program->resetMemo(memo);
+		for(unsigned int i = chunks[chunk]; i < chunks[chunk + 1]; i++){
+			unsigned int n = order[i];
+			(*effects)[n] = manager->evaluate((*reqs)[n], context, &memo);
+			dhprefs[n] = context.selectedDHPref;
+			if(paths)
+				(*paths)[n] = context.path;
 		}
+	}
+	};
+
+/*
+ * Batch form of checkRequest, effects (and paths if not NULL) are in the
+ * order of reqs. The decision cache is looked up first; each distinct
+ * request left is evaluated once, grouped by subject attributes so that a
+ * group matches the subject targets of the policy only once. With a pool
+ * the groups are evaluated in parallel.
+ */
+void PolicyManager::checkRequests(const vector<Request*>& reqs, vector<Effect>& effects,
+		vector<string>* paths, ThreadPool* pool){
+	BatchEvaluation batch;
+	vector<DecisionKey> keys(reqs.size());
+	vector<unsigned int> pending;
+	vector<unsigned int> repeated;		// position of the request evaluated in its place
+	bool withPath = (paths != NULL);
+	unsigned int workers = pool ? pool->size() : 1;
+
+	effects.assign(reqs.size(), INAPPLICABLE);
+	if(paths)
+		paths->assign(reqs.size(), string());
+	if(!validPolicyFile)
+		return;
+
+	batch.manager = this;
+	batch.reqs = &reqs;
+	batch.effects = &effects;
+	batch.paths = paths;
+	batch.dhprefs.resize(reqs.size());
+	batch.contexts.resize(workers);
+	batch.memos.resize(workers);
+	for(unsigned int w = 0; w < workers; w++)
+		batch.contexts[w].withPath = withPath;
+
+	for(unsigned int i = 0; i < reqs.size(); i++){
+		cache.makeKey(reqs[i], withPath, keys[i]);
+		if(!cache.lookup(keys[i], effects[i], batch.dhprefs[i], withPath ? &(*paths)[i] : NULL))
+			pending.push_back(i);
+	}
+
+	KeyOrder byKey;
+	byKey.keys = &keys;
+	stable_sort(pending.begin(), pending.end(), byKey);
+	repeated.assign(reqs.size(), reqs.size());
+	for(unsigned int i = 0; i < pending.size(); i++){
+		if(i > 0 && sameDecision(keys[pending[i]], keys[pending[i - 1]]))
+			repeated[pending[i]] = repeated[pending[i - 1]] < reqs.size()
+				? repeated[pending[i - 1]] : pending[i - 1];
 		else
-			LOGD("DHP response: false");
+			batch.order.push_back(pending[i]);
+	}
 
-		if (xacml_eff == PERMIT && dhp_eff == false){
-			LOGD("XACML-DHPref combined response: %d", PROMPT_BLANKET);
-			return PROMPT_BLANKET;
-		}
-		else {
-			LOGD("XACML-DHPref combined response: %d", xacml_eff);
-			return xacml_eff;
+	SubjectOrder bySubject;
+	bySubject.reqs = &reqs;
+	stable_sort(batch.order.begin(), batch.order.end(), bySubject);
+	for(unsigned int i = 0; i < batch.order.size(); i++){
+		if(i == 0 || i - batch.chunks.back() == BATCH_CHUNK
+				|| reqs[batch.order[i]]->compareSubject(*reqs[batch.order[i - 1]]) != 0)
+			batch.chunks.push_back(i);
+	}
+	unsigned int chunkCount = batch.chunks.size();
+	batch.chunks.push_back(batch.order.size());
+
+	if(pool)
+		pool->run(batch, chunkCount);
+	else {
+		for(unsigned int c = 0; c < chunkCount; c++)
+			batch.run(0, c);
+	}
+
+	for(unsigned int i = 0; i < batch.order.size(); i++){
+		unsigned int n = batch.order[i];
+		cache.store(keys[n], effects[n], batch.dhprefs[n], withPath ? &(*paths)[n] : NULL);
+	}
+	for(unsigned int i = 0; i < pending.size(); i++){
+		unsigned int n = pending[i];
+		if(repeated[n] < reqs.size()){
+			effects[n] = effects[repeated[n]];
+			if(paths)
+				(*paths)[n] = (*paths)[repeated[n]];
 		}
 	}
-	else
-		return INAPPLICABLE;
+	LOGD("Policy manager batch of %lu requests, %lu evaluated in %u chunks",
+			reqs.size(), batch.order.size(), chunkCount);
 }
-Effect PolicyManager::checkRequest(Request * req, string& path){
+
+// cached decision for a valid policy
+Effect PolicyManager::decide(Request * req, EvaluationContext& context, SubjectMemo* memo){
+	Effect eff;
+	DecisionKey key;
+	string* path = context.withPath ? &context.path : NULL;
+
+	cache.makeKey(req, context.withPath, key);
+	if(cache.lookup(key, eff, context.selectedDHPref, path)){
+		LOGD("Policy manager cached response: %d", eff);
+		return eff;
+	}
+	eff = evaluate(req, context, memo);
+	cache.store(key, eff, context.selectedDHPref, path);
+	return eff;
+}
+
+Effect PolicyManager::evaluate(Request * req, EvaluationContext& context, SubjectMemo* memo){
+	pair<string, bool>& selectedDHPref = context.selectedDHPref;
 	Effect xacml_eff;
 	bool dhp_eff = false;
 	int features = 0;
-	vector<bool> purpose = req->getPurposeAttrs();
+	const vector<bool>& purpose = req->getPurposeAttrs();
+
+	ArenaMark start = context.arena.mark();
+	size_t peak = context.arena.getPeak();
+
 	LOGD("Policy manager start check");
-	if(validPolicyFile) {
-		selectedDHPref.first.clear();
-		selectedDHPref.second = false;
-		IPolicyBaseDescriptor* psd;
-		xacml_eff = policyDocument->evaluate(req, &selectedDHPref, psd);
-		LOGD("XACML response: %d", xacml_eff);
-
-		// valid purposes vector
-		LOGD("Ontology size = %d",arraysize(ontology_vector));
-		if (purpose.size() == arraysize(ontology_vector)) {
-			LOGD("PolicyManager: valid purposes vector");
-
-			// in ProvisionalAction tags a single resouce requires a single DHPref
-			// no more than one resouce must be used in non installation enforceRequest call
-			if ((req->getResourceAttrs()).count(API_FEATURE) == 1) {
-				features = (req->getResourceAttrs())[API_FEATURE]->size();
-			}
-			if (features == 1){
-				LOGD("One feature requested, DHPref evaluation started");
-				if (selectedDHPref.first.empty() == false) {
-					LOGD("Selected DHPref: %s", selectedDHPref.first.c_str());
-					DHPrefs::iterator it;
-					it=(*dhp).find(selectedDHPref.first);
-					if (it == (*dhp).end()){
-						LOGD("DHPref: %s not found", selectedDHPref.first.c_str());
-					}
-					else {
-						LOGD("DHPref: %s found", selectedDHPref.first.c_str());
-						dhp_eff = (*dhp)[selectedDHPref.first]->evaluate(req);
-					}
+	if(memo == NULL){
+		program->resetMemo(context.memo);
+		memo = &context.memo;
+	}
+	selectedDHPref.first.clear();
+	selectedDHPref.second = false;
+	IPolicyBaseDescriptor* psd = NULL;
+	if(context.withPath)
+		xacml_eff = program->evaluate(req, &selectedDHPref, context.arena, psd, memo);
+	else
+		xacml_eff = program->evaluate(req, &selectedDHPref, memo);
+	LOGD("XACML response: %d", xacml_eff);
+
+	// valid purposes vector
+	LOGD("Ontology size = %d",arraysize(ontology_vector));
+	if (purpose.size() == arraysize(ontology_vector)) {
+		LOGD("PolicyManager: valid purposes vector");
+
+		// in ProvisionalAction tags a single resouce requires a single DHPref
+		// no more than one resouce must be used in non installation enforceRequest call
+		const request_attr* req_features = req->getResourceAttr(ATTR_API_FEATURE);
+		if (req_features != NULL) {
+			features = req_features->count;
+		}
+		if (features == 1){
+			LOGD("One feature requested, DHPref evaluation started");
+			if (selectedDHPref.first.empty() == false) {
+				LOGD("Selected DHPref: %s", selectedDHPref.first.c_str());
+				DHPrefs::iterator it;
+				it=(*dhp).find(selectedDHPref.first);
+				if (it == (*dhp).end()){
+					LOGD("DHPref: %s not found", selectedDHPref.first.c_str());
+				}
+				else {	
+					LOGD("DHPref: %s found", selectedDHPref.first.c_str());
+					dhp_eff = it->second->evaluate(req);
 				}
-			}
-			// in installation enforceRequest call more resource parameters can be used
-			// the result of Data handling preferences evaluation is set to true because
-			// the XACML response only is significant
-			else {
-				LOGD("%d features requested, DHPref evaluation skipped", features);
-				dhp_eff = true;
 			}
 		}
-		// invalid purposes vector
+		// in installation enforceRequest call more resource parameters can be used
+		// the result of Data handling preferences evaluation is set to true because
+		// the XACML response only is significant
 		else {
-			LOGD("PolicyManager: invalid purposes vector");
+			LOGD("%d features requested, DHPref evaluation skipped", features);
+			dhp_eff = true;
 		}
+	}
+	// invalid purposes vector
+	else {
+		LOGD("PolicyManager: invalid purposes vector");
+	}
 
-		if (dhp_eff == true){
-			LOGD("DHP response: true");
-		}
-		else
-			LOGD("DHP response: false");
-		path = psd->toJSONString();
-		delete psd;
-		if (xacml_eff == PERMIT && dhp_eff == false){
-			LOGD("XACML-DHPref combined response: %d", PROMPT_BLANKET);
-			return PROMPT_BLANKET;
-		}
-		else {
-			LOGD("XACML-DHPref combined response: %d", xacml_eff);
-			return xacml_eff;
-		}
+	if (dhp_eff == true){
+		LOGD("DHP response: true");
 	}
 	else
-		return INAPPLICABLE;
+		LOGD("DHP response: false");
+
+	if(context.withPath){
+		context.path.clear();
+		psd->appendJSON(context.path);
+	}
+	if(context.arena.getPeak() > peak){
+		MutexLock locked(statsLock);
+		if(context.arena.getPeak() > arenaPeak)
+			arenaPeak = context.arena.getPeak();
+	}
+	context.arena.rewind(start);
+	if (xacml_eff == PERMIT && dhp_eff == false){
+		LOGD("XACML-DHPref combined response: %d", PROMPT_BLANKET);
+		return PROMPT_BLANKET;
+	}
+	else {
+		LOGD("XACML-DHPref combined response: %d", xacml_eff);
+		return xacml_eff;
+	}
 }
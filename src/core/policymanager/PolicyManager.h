@@ -22,19 +22,49 @@
 
 #include "Request.h"
 #include "PolicySet.h"
+#include "PolicyProgram.h"
+#include "DecisionCache.h"
 #include "IPolicyBaseDescriptor.h"
 #include "DataHandlingPreferences.h"
+#include "EvaluationArena.h"
+#include "../threadpool.h"
 //#include "debug.h"
 
+/*
+ * Per-call state of PolicyManager::checkRequest. A context can be reused
+ * for any number of calls, one at a time: what an evaluation puts in the
+ * arena is released when it ends.
+ */
+typedef struct {
+	pair<string, bool>	selectedDHPref;	// data handling preference chosen by the policy
+	bool				withPath;		// also describe the policy path of the decision
+	string				path;			// JSON policy path, if withPath
+	EvaluationArena		arena;
+	SubjectMemo			memo;			// for calls not given the memo of a batch
+} EvaluationContext;
+
+typedef struct {
+	unsigned long	cacheHits;
+	unsigned long	cacheMisses;
+	size_t			arenaPeak;		// most bytes an evaluation arena held
+} PolicyStatistics;
+
 class PolicyManager{ 
 
 private:
 	PolicySet * policyDocument;
+	PolicyProgram * program;
+	DecisionCache cache;
 	bool validPolicyFile;
 	string policyName;
+	Mutex statsLock;
+	size_t arenaPeak;
+
+	Effect evaluate(Request*, EvaluationContext&, SubjectMemo*);
+	friend class BatchEvaluation;
+	Effect decide(Request*, EvaluationContext&, SubjectMemo*);
 
 public:
-	pair<string, bool> selectedDHPref;
 	DHPrefs* dhp;
 	map<string, vector<string>*>* pip;
 	PolicyManager();
@@ -42,6 +72,12 @@ public:
 	virtual ~PolicyManager();
 	Effect checkRequest(Request *);
 	Effect checkRequest(Request*, string&);
+	Effect checkRequest(Request*, EvaluationContext&);
+	void checkRequests(const vector<Request*>&, vector<Effect>&, vector<string>*, ThreadPool* pool = NULL);
+	const AttributeReferences* getReferences() const;
+	vector<string> getMatchErrors() const;
+	void setEvaluationMode(int);
+	PolicyStatistics getStatistics();
 	void init(const string &);
 	string getPolicyName();
 };
@@ -0,0 +1,799 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#include "PolicyProgram.h"
+#include "../../debug.h"
+#include <algorithm>
+
+/*
+ * Combining algorithms, as folds over the effects of the children in
+ * document order: stops() tells whether an effect decides at once, merge()
+ * keeps the effect that wins so far. For the overrides algorithms the
+ * winner is the effect of lowest rank, INAPPLICABLE only if nothing else
+ * came.
+ */
+template <int Algorithm> struct Combiner;
+
+template <> struct Combiner<DENY_OVERRIDES>
+	{
+	static const unsigned char rank[];
+	static bool stops(Effect e) { return e == DENY; }
+	static Effect merge(Effect acc, Effect e) { return rank[e] < rank[acc] ? e : acc; }
+	};
+
+template <> struct Combiner<PERMIT_OVERRIDES>
+	{
+	static const unsigned char rank[];
+	static bool stops(Effect e) { return e == PERMIT; }
+	static Effect merge(Effect acc, Effect e) { return rank[e] < rank[acc] ? e : acc; }
+	};
+
+template <> struct Combiner<FIRST_APPLICABLE>
+	{
+	static bool stops(Effect e) { return e != INAPPLICABLE; }
+	static Effect merge(Effect acc, Effect e) { return acc == INAPPLICABLE ? e : acc; }
+	};
+
+// indexed by Effect: PERMIT, DENY, PROMPT_ONESHOT, PROMPT_SESSION, PROMPT_BLANKET, UNDETERMINED, INAPPLICABLE
+const unsigned char Combiner<DENY_OVERRIDES>::rank[] = {5, 0, 2, 3, 4, 1, 6};
+const unsigned char Combiner<PERMIT_OVERRIDES>::rank[] = {0, 5, 4, 3, 2, 1, 6};
+
+// merge() of an algorithm known only at run time, for path evaluation
+static Effect mergeEffect(int algorithm, Effect acc, Effect e) {
+	switch (algorithm) {
+	case DENY_OVERRIDES:
+		return Combiner<DENY_OVERRIDES>::merge(acc, e);
+	case PERMIT_OVERRIDES:
+		return Combiner<PERMIT_OVERRIDES>::merge(acc, e);
+	default:
+		return Combiner<FIRST_APPLICABLE>::merge(acc, e);
+	}
+}
+
+PolicyProgram::PolicyProgram(PolicySet* root, DHPrefs* dhp) :
+		mode(EVALUATION_LAZY), datahandlingpreferences(dhp) {
+	nodes.resize(1);
+	ids.resize(1);
+	combines.resize(1);
+	initNode(0, root);
+	compileChildren(0, root);
+	internValues();
+	internPredicates();
+	predicates.build(values);
+	collectReferences();
+	buildIndexes();
+	LOGD("[PolicyProgram] compiled %lu nodes, %lu subjects, %lu provisional actions, %u values, %u predicates, %lu subject indexes, %lu rule indexes",
+			nodes.size(), subjects.size(), actions.size(), values.size(), predicates.size(), indexes.size(), ruleIndexes.size());
+}
+
+PolicyProgram::~PolicyProgram() {
+}
+
+unsigned int PolicyProgram::size() {
+	return nodes.size();
+}
+
+const AttributeReferences& PolicyProgram::getReferences() const {
+	return references;
+}
+
+// match values of the policy that never match, see Matcher
+void PolicyProgram::getMatchErrors(vector<string>& errors) const {
+	predicates.collectErrors(errors);
+}
+
+// only to be changed while no evaluation is running
+void PolicyProgram::setMode(int m) {
+	mode = m;
+}
+
+int PolicyProgram::getMode() const {
+	return mode;
+}
+
+void PolicyProgram::appendActions(ProgramNode& node,
+		const vector<ProvisionalActions*>& provisionalactions) {
+	node.firstAction = actions.size();
+	node.actionCount = provisionalactions.size();
+	actions.insert(actions.end(), provisionalactions.begin(),
+			provisionalactions.end());
+}
+
+void PolicyProgram::initNode(unsigned int n, IPolicyBase* base) {
+	ProgramNode node;
+	node.effect = UNDETERMINED;
+	node.firstChild = 0;
+	node.subjectIndex = -1;
+	node.ruleIndex = -1;
+	node.ruleTable = -1;
+	node.condition = NULL;
+	node.firstSubject = subjects.size();
+
+	if (base->get_iType() == POLICY_SET) {
+		PolicySet* set = static_cast<PolicySet*>(base);
+		node.opcode = OP_POLICY_SET;
+		node.algorithm = string2algorithm(set->policyCombiningAlgorithm);
+		node.childCount = set->sortArray.size();
+		node.subjectCount = set->subjects.size();
+		subjects.insert(subjects.end(), set->subjects.begin(), set->subjects.end());
+		appendActions(node, set->provisionalactions);
+		combines[n] = set->policyCombiningAlgorithm;
+	} else {
+		Policy* policy = static_cast<Policy*>(base);
+		node.opcode = OP_POLICY;
+		node.algorithm = string2algorithm(policy->ruleCombiningAlgorithm);
+		node.childCount = policy->rules.size();
+		node.subjectCount = policy->subjects.size();
+		subjects.insert(subjects.end(), policy->subjects.begin(), policy->subjects.end());
+		appendActions(node, policy->provisionalactions);
+		combines[n] = policy->ruleCombiningAlgorithm;
+	}
+	ids[n] = base->id;
+	nodes[n] = node;
+}
+
+void PolicyProgram::initRule(unsigned int n, Rule* rule) {
+	ProgramNode node;
+	node.opcode = OP_RULE;
+	node.algorithm = UNKNOWN_ALGORITHM;
+	node.effect = rule->effect;
+	node.firstChild = 0;
+	node.childCount = 0;
+	node.firstSubject = 0;
+	node.subjectCount = 0;
+	node.subjectIndex = -1;
+	node.ruleIndex = -1;
+	node.ruleTable = -1;
+	node.condition = rule->condition;
+	appendActions(node, rule->provisionalactions);
+	ids[n] = rule->id;
+	nodes[n] = node;
+}
+
+void PolicyProgram::compileChildren(unsigned int n, IPolicyBase* base) {
+	unsigned int first = nodes.size();
+	unsigned int count = nodes[n].childCount;
+
+	nodes[n].firstChild = first;
+	nodes.resize(first + count);
+	ids.resize(first + count);
+	combines.resize(first + count);
+
+	if (nodes[n].opcode == OP_POLICY_SET) {
+		PolicySet* set = static_cast<PolicySet*>(base);
+		// siblings first, so that each child block stays contiguous
+		for (unsigned int i = 0; i < count; i++)
+			initNode(first + i, set->sortArray[i]);
+		for (unsigned int i = 0; i < count; i++)
+			compileChildren(first + i, set->sortArray[i]);
+	} else {
+		Policy* policy = static_cast<Policy*>(base);
+		for (unsigned int i = 0; i < count; i++)
+			initRule(first + i, policy->rules[i]);
+	}
+}
+
+void PolicyProgram::internValues() {
+	for (unsigned int i = 0; i < subjects.size(); i++)
+		subjects[i]->intern(values);
+	for (unsigned int n = 0; n < nodes.size(); n++) {
+		if (nodes[n].condition)
+			nodes[n].condition->intern(values);
+	}
+}
+
+void PolicyProgram::internPredicates() {
+	for (unsigned int i = 0; i < subjects.size(); i++)
+		subjects[i]->intern(predicates);
+	for (unsigned int n = 0; n < nodes.size(); n++) {
+		if (nodes[n].condition)
+			nodes[n].condition->intern(predicates);
+	}
+}
+
+void PolicyProgram::collectReferences() {
+	for (unsigned int i = 0; i < ATTR_COUNT; i++) {
+		references.subjects[i] = false;
+		references.environment[i] = false;
+	}
+	references.capabilities = false;
+	references.timeExact = false;
+	for (unsigned int i = 0; i < subjects.size(); i++)
+		subjects[i]->collectReferences(references);
+	for (unsigned int n = 0; n < nodes.size(); n++) {
+		if (nodes[n].condition)
+			nodes[n].condition->collectReferences(references);
+	}
+	vector<int>& bounds = references.timeThresholds;
+	sort(bounds.begin(), bounds.end());
+	bounds.erase(unique(bounds.begin(), bounds.end()), bounds.end());
+}
+
+// literals of node n on attr, false if one of its subjects has none
+bool PolicyProgram::childLiterals(unsigned int n, int attr, vector<string>& literals) {
+	const ProgramNode& node = nodes[n];
+	if (node.subjectCount == 0)
+		return false;
+	for (unsigned int i = node.firstSubject; i < node.firstSubject + node.subjectCount; i++) {
+		if (!subjects[i]->literals(attr, literals))
+			return false;
+	}
+	return true;
+}
+
+/*
+ * A first-matching-target node with enough children is indexed on the
+ * subject attribute that the most of its children restrict to literals,
+ * e.g. one policy per user-id; a policy with enough rules is indexed on
+ * the resources their conditions match, e.g. one rule per api-feature.
+ * Every policy also gets its RuleTable.
+ */
+void PolicyProgram::buildIndexes() {
+	for (unsigned int n = 0; n < nodes.size(); n++) {
+		const ProgramNode& node = nodes[n];
+		if (node.opcode == OP_POLICY) {
+			buildRuleIndex(n);
+			buildRuleTable(n);
+			continue;
+		}
+		if (node.opcode != OP_POLICY_SET || node.algorithm != FIRST_MATCHING_TARGET
+				|| node.childCount < SUBJECT_INDEX_MIN_CHILDREN)
+			continue;
+		unsigned int end = node.firstChild + node.childCount;
+		int best = ATTR_UNKNOWN;
+		unsigned int bestCount = 0;
+		for (int attr = 0; attr < ATTR_API_FEATURE; attr++) {
+			unsigned int count = 0;
+			for (unsigned int i = node.firstChild; i < end; i++) {
+				vector<string> literals;
+				if (childLiterals(i, attr, literals))
+					count++;
+			}
+			if (count > bestCount) {
+				best = attr;
+				bestCount = count;
+			}
+		}
+		if (bestCount < SUBJECT_INDEX_MIN_CHILDREN)
+			continue;
+
+		SubjectIndex index(best);
+		for (unsigned int i = node.firstChild; i < end; i++) {
+			vector<string> literals;
+			if (childLiterals(i, best, literals))
+				index.add(literals, i);
+			else
+				index.addOther(i);
+		}
+		index.build();
+		nodes[n].subjectIndex = indexes.size();
+		indexes.push_back(index);
+		LOGD("[PolicyProgram] node %u indexed on %s: %u of %u children",
+				n, attribute2string((AttributeId) best), bestCount, node.childCount);
+	}
+}
+
+void PolicyProgram::buildRuleIndex(unsigned int n) {
+	const ProgramNode& node = nodes[n];
+	vector< vector<string> > features(node.childCount), capabilities(node.childCount);
+	vector<bool> literals(node.childCount, false);
+	unsigned int count = 0;
+
+	if (node.childCount < RULE_INDEX_MIN_RULES)
+		return;
+	for (unsigned int i = 0; i < node.childCount; i++) {
+		Condition* condition = nodes[node.firstChild + i].condition;
+		literals[i] = condition && condition->resourceLiterals(features[i], capabilities[i]);
+		if (literals[i])
+			count++;
+	}
+	if (count < RULE_INDEX_MIN_RULES)
+		return;
+
+	ResourceIndex index;
+	for (unsigned int i = 0; i < node.childCount; i++) {
+		if (literals[i])
+			index.add(features[i], capabilities[i], node.firstChild + i);
+		else
+			index.addOther(node.firstChild + i);
+	}
+	index.build();
+	nodes[n].ruleIndex = ruleIndexes.size();
+	ruleIndexes.push_back(index);
+	LOGD("[PolicyProgram] node %u indexed on resources: %u of %u rules", n, count, node.childCount);
+}
+
+// appends the rules of pairs[begin..end), sorted (key, rule) pairs with the same key
+static void appendRules(vector<PredicateMask>& masks, const vector< pair<unsigned int, unsigned int> >& pairs,
+		unsigned int begin, unsigned int end) {
+	unsigned int start = masks.size();
+	for (unsigned int k = begin; k < end; k++) {
+		unsigned int word = pairs[k].second / 32;
+		if (masks.size() == start || masks.back().word != word) {
+			PredicateMask m;
+			m.word = word;
+			m.bits = 0;
+			masks.push_back(m);
+		}
+		masks.back().bits |= 1U << (pairs[k].second % 32);
+	}
+}
+
+// keys of sorted (key, rule) pairs, each with its rules in masks
+static void appendKeys(vector<unsigned int>& keys, vector<unsigned int>& first, vector<PredicateMask>& masks,
+		const vector< pair<unsigned int, unsigned int> >& pairs) {
+	for (unsigned int k = 0; k < pairs.size(); ) {
+		unsigned int end = k;
+		while (end < pairs.size() && pairs[end].first == pairs[k].first)
+			end++;
+		keys.push_back(pairs[k].first);
+		first.push_back(masks.size());
+		appendRules(masks, pairs, k, end);
+		k = end;
+	}
+	first.push_back(masks.size());
+}
+
+void PolicyProgram::buildRuleTable(unsigned int n) {
+	const ProgramNode& node = nodes[n];
+	vector< pair<unsigned int, unsigned int> > byPredicate, bySource;	// (predicate or source, rule)
+	RuleTable table;
+
+	table.words = (node.childCount + 31) / 32;
+	table.always.assign(table.words, 0);
+	table.others.assign(table.words, 0);
+	for (unsigned int r = 0; r < node.childCount; r++) {
+		Condition* condition = nodes[node.firstChild + r].condition;
+		vector<unsigned int> rulePredicates;
+		int shape = condition ? condition->shape(rulePredicates) : CONDITION_ALWAYS;
+		if (shape == CONDITION_ALWAYS)
+			table.always[r / 32] |= 1U << (r % 32);
+		else if (shape == CONDITION_OTHER)
+			table.others[r / 32] |= 1U << (r % 32);
+		else {
+			for (unsigned int i = 0; i < rulePredicates.size(); i++) {
+				byPredicate.push_back(make_pair(rulePredicates[i], r));
+				bySource.push_back(make_pair(predicates.getSource(rulePredicates[i]), r));
+			}
+		}
+	}
+	sort(byPredicate.begin(), byPredicate.end());
+	byPredicate.erase(unique(byPredicate.begin(), byPredicate.end()), byPredicate.end());
+	sort(bySource.begin(), bySource.end());
+	bySource.erase(unique(bySource.begin(), bySource.end()), bySource.end());
+	appendKeys(table.predicates, table.predicateRules, table.masks, byPredicate);
+	appendKeys(table.sources, table.sourceRules, table.masks, bySource);
+	nodes[n].ruleTable = ruleTables.size();
+	ruleTables.push_back(table);
+}
+
+void PolicyProgram::resetMemo(SubjectMemo& memo) const {
+	memo.matches.assign(subjects.size(), -1);
+	memo.predicates.reset(predicates.size());
+}
+
+bool PolicyProgram::matchSubject(unsigned int i, const Request* req, SubjectMemo* memo) {
+	if (memo == NULL)
+		return subjects[i]->match(req);
+	signed char& m = memo->matches[i];
+	if (m < 0)
+		m = ((mode == EVALUATION_VECTOR) ? subjects[i]->match(memo->results)
+				: subjects[i]->match(req, &memo->predicates)) ? 1 : 0;
+	return m == 1;
+}
+
+bool PolicyProgram::matchSubject(const ProgramNode& node, const Request* req, SubjectMemo* memo) {
+	if (node.subjectCount == 0)
+		return true;
+	for (unsigned int i = node.firstSubject; i < node.firstSubject + node.subjectCount; i++) {
+		if (matchSubject(i, req, memo))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * First child of a first-matching-target node whose target matches, or
+ * the end of its children. With an index only the candidates it gives
+ * are matched, in document order.
+ */
+unsigned int PolicyProgram::firstMatchingChild(const ProgramNode& node, const Request* req, SubjectMemo* memo) {
+	unsigned int end = node.firstChild + node.childCount;
+
+	if (node.subjectIndex >= 0) {
+		const SubjectIndex& index = indexes[node.subjectIndex];
+		unsigned int hits[SUBJECT_INDEX_HITS];
+		unsigned int count = index.lookup(req->getSubjectAttr(index.getAttr()), hits, SUBJECT_INDEX_HITS);
+		if (count <= SUBJECT_INDEX_HITS) {
+			const vector<unsigned int>& others = index.getOthers();
+			unsigned int h = 0, o = 0;
+			while (h < count || o < others.size()) {
+				unsigned int i = (o == others.size() || (h < count && hits[h] < others[o])) ? hits[h++] : others[o++];
+				if (matchSubject(nodes[i], req, memo))
+					return i;
+			}
+			return end;
+		}
+	}
+	for (unsigned int i = node.firstChild; i < end; i++) {
+		if (matchSubject(nodes[i], req, memo))
+			return i;
+	}
+	return end;
+}
+
+void PolicyProgram::selectDHPref(const ProgramNode& node, const Request* req,
+		pair<string, bool>* selectedDHPref) {
+	const string* preferenceid;
+	bool exact;
+
+	if ((*selectedDHPref).second == true)
+		return;
+
+	// search for a provisional action with a resource matching the request
+	for (unsigned int i = node.firstAction; i < node.firstAction + node.actionCount; i++) {
+		preferenceid = actions[i]->evaluate(req, exact);
+		LOGD("[PolicyProgram] ProvisionalActions %d evaluation response: %s", i,
+				preferenceid ? preferenceid->c_str() : "");
+
+		// search for a dh preference with an id matching the string returned by
+		// the previous provisional action
+		if (preferenceid != NULL && preferenceid->empty() == false) {
+			// exact match: select this DHPref
+			// partial match: select this DHPref only if another partial match is not selected
+			if (exact == true || (*selectedDHPref).first.empty() == true) {
+				// test if DHPref exists
+				if ((*datahandlingpreferences).count(*preferenceid) == 1) {
+					(*selectedDHPref).first = *preferenceid;
+					(*selectedDHPref).second = exact;
+					LOGD("[PolicyProgram] DHPref found: %s",
+							(*selectedDHPref).first.c_str());
+					break;
+				}
+			}
+		}
+	}
+}
+
+// predicate results of the request about to be evaluated
+void PolicyProgram::resetPredicates(const Request* req, SubjectMemo* memo) {
+	if (memo == NULL)
+		return;
+	if (mode == EVALUATION_VECTOR)
+		predicates.evaluate(req, memo->results);
+	else
+		memo->predicates.reset(predicates.size());
+}
+
+Effect PolicyProgram::evaluate(Request* req, pair<string, bool>* selectedDHPref,
+		SubjectMemo* memo) {
+	req->resolveValues(values);
+	resetPredicates(req, memo);
+	return evaluateNode(0, req, selectedDHPref, memo, false);
+}
+
+Effect PolicyProgram::evaluateNode(unsigned int n, const Request* req,
+		pair<string, bool>* selectedDHPref, SubjectMemo* memo, bool subjectMatched) {
+	const ProgramNode& node = nodes[n];
+
+	if (node.opcode == OP_RULE)
+		return evaluateRule(node, req, selectedDHPref, memo);
+	if (!subjectMatched && !matchSubject(node, req, memo))
+		return INAPPLICABLE;
+	if (node.opcode == OP_POLICY_SET)
+		return evaluatePolicySet(node, req, selectedDHPref, memo);
+	return evaluatePolicy(node, req, selectedDHPref, memo);
+}
+
+// the children of node combined by C, stopping at the first decisive effect
+template <class C>
+Effect PolicyProgram::combine(const ProgramNode& node, const Request* req,
+		pair<string, bool>* selectedDHPref, SubjectMemo* memo) {
+	unsigned int end = node.firstChild + node.childCount;
+	Effect result = INAPPLICABLE;
+
+	if (node.ruleTable >= 0 && memo && mode == EVALUATION_VECTOR)
+		return combine<C>(node, ruleTables[node.ruleTable], req, selectedDHPref, memo);
+	if (node.ruleIndex >= 0) {
+		unsigned int rules[RULE_INDEX_HITS];
+		unsigned int count = ruleIndexes[node.ruleIndex].lookup(req, rules, RULE_INDEX_HITS);
+		if (count <= RULE_INDEX_HITS)
+			return combine<C>(node, rules, count, req, selectedDHPref, memo);
+	}
+	for (unsigned int i = node.firstChild; i < end; i++) {
+		Effect eff = evaluateNode(i, req, selectedDHPref, memo, false);
+		selectDHPref(node, req, selectedDHPref);
+		if (C::stops(eff))
+			return eff;
+		result = C::merge(result, eff);
+	}
+	return result;
+}
+
+/*
+ * As above, for a policy whose rules but the count candidate ones are
+ * known to be inapplicable: those are not evaluated, though the policy's
+ * provisional actions still get their turn after each of them.
+ */
+template <class C>
+Effect PolicyProgram::combine(const ProgramNode& node, const unsigned int* rules, unsigned int count,
+		const Request* req, pair<string, bool>* selectedDHPref, SubjectMemo* memo) {
+	unsigned int end = node.firstChild + node.childCount;
+	unsigned int i = node.firstChild;
+	Effect result = INAPPLICABLE;
+
+	for (unsigned int k = 0; k < count; k++, i++) {
+		for (; node.actionCount > 0 && i < rules[k]; i++)
+			selectDHPref(node, req, selectedDHPref);
+		i = rules[k];
+		Effect eff = evaluateRule(nodes[i], req, selectedDHPref, memo);
+		selectDHPref(node, req, selectedDHPref);
+		if (C::stops(eff))
+			return eff;
+		result = C::merge(result, eff);
+	}
+	for (; node.actionCount > 0 && i < end; i++)
+		selectDHPref(node, req, selectedDHPref);
+	return result;
+}
+
+// index of the lowest set bit of a non-zero word
+static unsigned int lowestBit(uint32_t bits) {
+	static const unsigned char position[32] = {0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+			31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9};
+	return position[((bits & (~bits + 1)) * 0x077CB531U) >> 27];
+}
+
+/*
+ * As above, in EVALUATION_VECTOR: the rules that match or are not
+ * determined are set from the predicate results of the request (see
+ * RuleTable), and only those and the rules left to their condition are
+ * visited, in document order, with the provisional actions of the policy
+ * taking their turns as in the index form.
+ */
+template <class C>
+Effect PolicyProgram::combine(const ProgramNode& node, const RuleTable& table,
+		const Request* req, pair<string, bool>* selectedDHPref, SubjectMemo* memo) {
+	const PredicateVector& results = memo->results;
+	vector<uint32_t>& matched = memo->rulesMatched;
+	vector<uint32_t>& undetermined = memo->rulesUndetermined;
+	unsigned int end = node.firstChild + node.childCount;
+	unsigned int i = node.firstChild;
+	Effect result = INAPPLICABLE;
+
+	matched = table.always;
+	undetermined.assign(table.words, 0);
+	for (unsigned int h = 0; h < results.hits.size(); h++) {
+		vector<unsigned int>::const_iterator it = lower_bound(table.predicates.begin(), table.predicates.end(), results.hits[h]);
+		if (it == table.predicates.end() || *it != results.hits[h])
+			continue;
+		unsigned int k = it - table.predicates.begin();
+		for (unsigned int m = table.predicateRules[k]; m < table.predicateRules[k + 1]; m++)
+			matched[table.masks[m].word] |= table.masks[m].bits;
+	}
+	for (unsigned int k = 0; k < table.sources.size(); k++) {
+		if (results.present[table.sources[k]])
+			continue;
+		for (unsigned int m = table.sourceRules[k]; m < table.sourceRules[k + 1]; m++)
+			undetermined[table.masks[m].word] |= table.masks[m].bits;
+	}
+
+	for (unsigned int w = 0; w < table.words; w++) {
+		uint32_t candidates = matched[w] | undetermined[w] | table.others[w];
+		while (candidates != 0) {
+			unsigned int b = lowestBit(candidates);
+			unsigned int r = node.firstChild + w * 32 + b;
+			Effect eff;
+			candidates &= candidates - 1;
+			for (; node.actionCount > 0 && i < r; i++)
+				selectDHPref(node, req, selectedDHPref);
+			i = r + 1;
+			if (matched[w] & (1U << b)) {
+				selectDHPref(nodes[r], req, selectedDHPref);
+				eff = (Effect) nodes[r].effect;
+			}
+			else if (undetermined[w] & (1U << b))
+				eff = UNDETERMINED;
+			else
+				eff = evaluateRule(nodes[r], req, selectedDHPref, memo);
+			selectDHPref(node, req, selectedDHPref);
+			if (C::stops(eff))
+				return eff;
+			result = C::merge(result, eff);
+		}
+	}
+	for (; node.actionCount > 0 && i < end; i++)
+		selectDHPref(node, req, selectedDHPref);
+	return result;
+}
+
+Effect PolicyProgram::evaluatePolicySet(const ProgramNode& node, const Request* req,
+		pair<string, bool>* selectedDHPref, SubjectMemo* memo) {
+	unsigned int end = node.firstChild + node.childCount;
+
+	if (node.childCount == 0)
+		return INAPPLICABLE;
+	if (req->getResources() == NULL)
+		return PERMIT;
+
+	switch (node.algorithm) {
+	case DENY_OVERRIDES:
+		return combine< Combiner<DENY_OVERRIDES> >(node, req, selectedDHPref, memo);
+	case PERMIT_OVERRIDES:
+		return combine< Combiner<PERMIT_OVERRIDES> >(node, req, selectedDHPref, memo);
+	case FIRST_MATCHING_TARGET: {
+		unsigned int i = firstMatchingChild(node, req, memo);
+		if (i == end)
+			return INAPPLICABLE;
+		Effect eff = evaluateNode(i, req, selectedDHPref, memo, true);
+		selectDHPref(node, req, selectedDHPref);
+		return eff;
+	}
+	default:
+		// unknown combine value: the policy-set is skipped, as the tree walk did
+		return INAPPLICABLE;
+	}
+}
+
+Effect PolicyProgram::evaluatePolicy(const ProgramNode& node, const Request* req,
+		pair<string, bool>* selectedDHPref, SubjectMemo* memo) {
+	if (req->getResources() == NULL)
+		return PERMIT;
+
+	switch (node.algorithm) {
+	case DENY_OVERRIDES:
+		return combine< Combiner<DENY_OVERRIDES> >(node, req, selectedDHPref, memo);
+	case PERMIT_OVERRIDES:
+		return combine< Combiner<PERMIT_OVERRIDES> >(node, req, selectedDHPref, memo);
+	case FIRST_APPLICABLE:
+		return combine< Combiner<FIRST_APPLICABLE> >(node, req, selectedDHPref, memo);
+	default:
+		// combine values the parser does not know (and first-matching-target,
+		// which only policy-sets have): the policy cannot be decided, and
+		// UNDETERMINED lets the enclosing algorithm deal with it, as the
+		// tree walk did
+		return UNDETERMINED;
+	}
+}
+
+Effect PolicyProgram::evaluateRule(const ProgramNode& node, const Request* req,
+		pair<string, bool>* selectedDHPref, SubjectMemo* memo) {
+	ConditionResponse cr = MATCH;
+
+	if (node.condition && memo && mode == EVALUATION_VECTOR)
+		cr = node.condition->evaluate(memo->results);
+	else if (node.condition)
+		cr = node.condition->evaluate(req, memo ? &memo->predicates : NULL);
+	// there is no condition tag, or there is condition tag and request resource is matching policy resource
+	if (cr == MATCH) {
+		selectDHPref(node, req, selectedDHPref);
+		return (Effect) node.effect;
+	}
+	// there is condition tag and request resource is not matching policy resource
+	if (cr == NO_MATCH)
+		return INAPPLICABLE;
+	return UNDETERMINED;
+}
+
+/*
+ * Path evaluation: every child is visited (no early exit) so that the
+ * returned descriptor tree reports the effect of each policy and rule.
+ * The tree is built in arena and lives as long as what it holds.
+ */
+Effect PolicyProgram::evaluate(Request* req, pair<string, bool>* selectedDHPref,
+		EvaluationArena& arena, IPolicyBaseDescriptor* &path, SubjectMemo* memo) {
+	req->resolveValues(values);
+	resetPredicates(req, memo);
+	return evaluateNode(0, req, selectedDHPref, memo, arena, path);
+}
+
+Effect PolicyProgram::evaluateNode(unsigned int n, const Request* req,
+		pair<string, bool>* selectedDHPref, SubjectMemo* memo, EvaluationArena& arena,
+		IPolicyBaseDescriptor* &path) {
+	if (nodes[n].opcode == OP_POLICY_SET)
+		return evaluatePolicySet(n, req, selectedDHPref, memo, arena, path);
+	return evaluatePolicy(n, req, selectedDHPref, memo, arena, path);
+}
+
+Effect PolicyProgram::evaluatePolicySet(unsigned int n, const Request* req,
+		pair<string, bool>* selectedDHPref, SubjectMemo* memo, EvaluationArena& arena,
+		IPolicyBaseDescriptor* &path) {
+	const ProgramNode& node = nodes[n];
+	unsigned int end = node.firstChild + node.childCount;
+	PolicySetDescriptor* psd = new (arena) PolicySetDescriptor(&ids[n], &combines[n]);
+	Effect result = INAPPLICABLE;
+
+	path = psd;
+	if (!matchSubject(node, req, memo) || node.childCount == 0)
+		return INAPPLICABLE;
+	if (req->getResources() == NULL) {
+		psd->effect = PERMIT;
+		return PERMIT;
+	}
+
+	switch (node.algorithm) {
+	case DENY_OVERRIDES:
+	case PERMIT_OVERRIDES:
+		for (unsigned int i = node.firstChild; i < end; i++) {
+			IPolicyBaseDescriptor* desc;
+			Effect eff = evaluateNode(i, req, selectedDHPref, memo, arena, desc);
+			desc->position = i - node.firstChild;
+			psd->addChild(desc);
+			selectDHPref(node, req, selectedDHPref);
+			result = mergeEffect(node.algorithm, result, eff);
+		}
+		break;
+	case FIRST_MATCHING_TARGET:
+		for (unsigned int i = node.firstChild; i < end; i++) {
+			if (matchSubject(nodes[i], req, memo)) {
+				IPolicyBaseDescriptor* desc;
+				Effect eff = evaluateNode(i, req, selectedDHPref, memo, arena, desc);
+				desc->position = i - node.firstChild;
+				psd->addChild(desc);
+				selectDHPref(node, req, selectedDHPref);
+				if (result == INAPPLICABLE)
+					result = eff;
+			}
+		}
+		break;
+	default:
+		// unknown combine value: INAPPLICABLE, as in evaluatePolicySet
+		break;
+	}
+	psd->effect = result;
+	return result;
+}
+
+Effect PolicyProgram::evaluatePolicy(unsigned int n, const Request* req,
+		pair<string, bool>* selectedDHPref, SubjectMemo* memo, EvaluationArena& arena,
+		IPolicyBaseDescriptor* &path) {
+	const ProgramNode& node = nodes[n];
+	unsigned int end = node.firstChild + node.childCount;
+	PolicyDescriptor* pd = new (arena) PolicyDescriptor(&ids[n], &combines[n]);
+	Effect result = INAPPLICABLE;
+
+	path = pd;
+	if (!matchSubject(node, req, memo)) {
+		pd->effect = INAPPLICABLE;
+		return INAPPLICABLE;
+	}
+	if (req->getResources() == NULL) {
+		pd->effect = PERMIT;
+		return PERMIT;
+	}
+
+	switch (node.algorithm) {
+	case DENY_OVERRIDES:
+	case PERMIT_OVERRIDES:
+	case FIRST_APPLICABLE:
+		for (unsigned int i = node.firstChild; i < end; i++) {
+			Effect tmp_effect = evaluateRule(nodes[i], req, selectedDHPref, memo);
+			pd->addRule(arena, tmp_effect, &ids[i], i - node.firstChild);
+			selectDHPref(node, req, selectedDHPref);
+			result = mergeEffect(node.algorithm, result, tmp_effect);
+		}
+		break;
+	default:
+		// unknown combine value: UNDETERMINED, as in evaluatePolicy
+		result = UNDETERMINED;
+		break;
+	}
+	pd->effect = result;
+	return result;
+}
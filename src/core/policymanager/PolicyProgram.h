@@ -0,0 +1,174 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#ifndef POLICYPROGRAM_H_
+#define POLICYPROGRAM_H_
+
+#include "PolicySet.h"
+#include "PolicySetDescriptor.h"
+#include "PolicyDescriptor.h"
+#include "ValueDictionary.h"
+#include "SubjectIndex.h"
+#include "ResourceIndex.h"
+
+#include <vector>
+using namespace std;
+
+enum ProgramOpcode {OP_POLICY_SET, OP_POLICY, OP_RULE};
+
+/*
+ * How targets and conditions are evaluated: each match element when it
+ * is reached (EVALUATION_LAZY), or the predicates the values of the
+ * request match up front, then subjects and the rules of a policy as
+ * masks over the results (EVALUATION_VECTOR, see RuleTable), which costs
+ * what the request matches rather than the number of rules.
+ */
+enum EvaluationMode {EVALUATION_LAZY, EVALUATION_VECTOR};
+
+/*
+ * One element of the compiled policy. Children of a node are stored
+ * contiguously in the node array, so a combining loop walks adjacent
+ * memory instead of chasing IPolicyBase pointers.
+ */
+typedef struct {
+	unsigned char	opcode;			// ProgramOpcode
+	unsigned char	algorithm;		// CombiningAlgorithm (policy-set, policy)
+	unsigned char	effect;			// Effect (rule)
+	unsigned int	firstChild;
+	unsigned int	childCount;
+	unsigned int	firstSubject;
+	unsigned int	subjectCount;
+	unsigned int	firstAction;
+	unsigned int	actionCount;
+	int				subjectIndex;	// in PolicyProgram::indexes, -1 if none
+	int				ruleIndex;		// in PolicyProgram::ruleIndexes, -1 if none
+	int				ruleTable;		// in PolicyProgram::ruleTables, -1 if none
+	Condition*		condition;		// rule condition, NULL if none
+} ProgramNode;
+
+// fewest children a first-matching-target node indexes by subject
+const unsigned int SUBJECT_INDEX_MIN_CHILDREN = 8;
+// most candidates taken from an index before falling back to every child
+const unsigned int SUBJECT_INDEX_HITS = 64;
+// fewest rules indexed by resource a policy needs to be indexed
+const unsigned int RULE_INDEX_MIN_RULES = 8;
+// most candidate rules taken from an index before evaluating every rule
+const unsigned int RULE_INDEX_HITS = 64;
+
+/*
+ * Rules of a policy as masks over its rules, for EVALUATION_VECTOR. A
+ * rule whose condition is CONDITION_ANY matches when one of its
+ * predicates is among the matched ones of the request, and is otherwise
+ * NOT_DETERMINED when the request lacks a source one of them reads; a
+ * rule without condition (or CONDITION_ALWAYS) always matches; the others
+ * are left to Condition::evaluate. A rule in none of these masks is
+ * inapplicable and not looked at.
+ */
+typedef struct {
+	unsigned int			words;
+	vector<uint32_t>		always;
+	vector<uint32_t>		others;
+	vector<unsigned int>	predicates;		// sorted, of the CONDITION_ANY rules
+	vector<unsigned int>	predicateRules;	// rules of predicates[i]: masks[predicateRules[i]..predicateRules[i + 1])
+	vector<unsigned int>	sources;		// sorted, read by the CONDITION_ANY rules
+	vector<unsigned int>	sourceRules;	// as predicateRules
+	vector<PredicateMask>	masks;			// over the rules of the policy
+} RuleTable;
+
+/*
+ * Subject target results of one request, reused by the requests of a
+ * batch that carry the same subject attributes (see Request::compareSubject),
+ * and predicate results, which are only kept for one request.
+ */
+typedef struct {
+	vector<signed char>	matches;	// per program subject: -1 not evaluated, else 0 or 1
+	PredicateMemo		predicates;	// EVALUATION_LAZY
+	PredicateVector		results;	// EVALUATION_VECTOR
+	vector<uint32_t>	rulesMatched;		// of the policy being combined, EVALUATION_VECTOR
+	vector<uint32_t>	rulesUndetermined;
+} SubjectMemo;
+
+/*
+ * Flat, read-only form of a parsed PolicySet tree.
+ * The tree still owns subjects, conditions and provisional actions; the
+ * program only references them from contiguous tables and walks its node
+ * array with a plain switch on the opcode.
+ */
+class PolicyProgram
+	{
+
+private:
+	vector<ProgramNode>				nodes;
+	vector<Subject*>				subjects;
+	vector<ProvisionalActions*>		actions;
+	ValueDictionary					values;
+	AttributeReferences				references;
+	vector<SubjectIndex>			indexes;
+	vector<ResourceIndex>			ruleIndexes;
+	vector<RuleTable>				ruleTables;
+	PredicateTable					predicates;
+	int								mode;		// EvaluationMode
+	// cold data, only needed to build path descriptors
+	vector<string>					ids;
+	vector<string>					combines;
+	DHPrefs*						datahandlingpreferences;
+
+	void initNode(unsigned int, IPolicyBase*);
+	void initRule(unsigned int, Rule*);
+	void compileChildren(unsigned int, IPolicyBase*);
+	void appendActions(ProgramNode&, const vector<ProvisionalActions*>&);
+	void internValues();
+	void internPredicates();
+	void collectReferences();
+	void buildIndexes();
+	bool childLiterals(unsigned int, int, vector<string>&);
+	void buildRuleIndex(unsigned int);
+	void buildRuleTable(unsigned int);
+
+	void resetPredicates(const Request*, SubjectMemo*);
+	bool matchSubject(unsigned int, const Request*, SubjectMemo*);
+	bool matchSubject(const ProgramNode&, const Request*, SubjectMemo*);
+	unsigned int firstMatchingChild(const ProgramNode&, const Request*, SubjectMemo*);
+	void selectDHPref(const ProgramNode&, const Request*, pair<string, bool>*);
+	Effect evaluateNode(unsigned int, const Request*, pair<string, bool>*, SubjectMemo*, bool);
+	Effect evaluatePolicySet(const ProgramNode&, const Request*, pair<string, bool>*, SubjectMemo*);
+	Effect evaluatePolicy(const ProgramNode&, const Request*, pair<string, bool>*, SubjectMemo*);
+	Effect evaluateRule(const ProgramNode&, const Request*, pair<string, bool>*, SubjectMemo*);
+	template <class C> Effect combine(const ProgramNode&, const Request*, pair<string, bool>*, SubjectMemo*);
+	template <class C> Effect combine(const ProgramNode&, const unsigned int*, unsigned int, const Request*, pair<string, bool>*, SubjectMemo*);
+	template <class C> Effect combine(const ProgramNode&, const RuleTable&, const Request*, pair<string, bool>*, SubjectMemo*);
+	Effect evaluateNode(unsigned int, const Request*, pair<string, bool>*, SubjectMemo*, EvaluationArena&, IPolicyBaseDescriptor*&);
+	Effect evaluatePolicySet(unsigned int, const Request*, pair<string, bool>*, SubjectMemo*, EvaluationArena&, IPolicyBaseDescriptor*&);
+	Effect evaluatePolicy(unsigned int, const Request*, pair<string, bool>*, SubjectMemo*, EvaluationArena&, IPolicyBaseDescriptor*&);
+
+public:
+	PolicyProgram(PolicySet*, DHPrefs*);
+	virtual ~PolicyProgram();
+
+	Effect evaluate(Request*, pair<string, bool>*, SubjectMemo* memo = NULL);
+	Effect evaluate(Request*, pair<string, bool>*, EvaluationArena&, IPolicyBaseDescriptor*&, SubjectMemo* memo = NULL);
+	void resetMemo(SubjectMemo&) const;
+	void setMode(int);
+	int getMode() const;
+	unsigned int size();
+	const AttributeReferences& getReferences() const;
+	void getMatchErrors(vector<string>&) const;
+	};
+
+#endif /* POLICYPROGRAM_H_ */
@@ -25,7 +25,6 @@
 #include "IPolicyBase.h"
 #include "DataHandlingPreferences.h"
 #include "ProvisionalActions.h"
-#include "PolicySetDescriptor.h"
 
 #include <vector>
 using namespace std;
@@ -43,19 +42,12 @@ private:
 	DHPrefs*			datahandlingpreferences;
 	vector<ProvisionalActions*>		provisionalactions;
 	
-	bool matchSubject(Request*);
-	Effect evaluatePolicies(Request*, pair<string, bool>*);
-	Effect evaluatePolicies(Request*, pair<string, bool>*, IPolicyBaseDescriptor*&);
-//	Effect evaluatePolicySets(Request*);
-	void selectDHPref(Request*, pair<string, bool>*);
+	friend class PolicyProgram;
 	
 public:
 	PolicySet(TiXmlElement*, DHPrefs*, map<string, vector<string>*> *);
 	PolicySet(IPolicyBase*);
 	virtual ~PolicySet();
-	
-	Effect evaluate(Request*, pair<string, bool>*);
-	Effect evaluate(Request*, pair<string, bool>*, IPolicyBaseDescriptor*&);
 	};
 
 #endif /* POLICYSET_H_ */
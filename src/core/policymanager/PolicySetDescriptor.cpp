@@ -7,73 +7,68 @@
 #include "PolicySetDescriptor.h"
 #include "../../debug.h"
 #include <stdio.h>
-PolicySetDescriptor::PolicySetDescriptor() {
-	this->type = POLICY_SET;
-}
-PolicySetDescriptor::PolicySetDescriptor(string id) {
-	this->id = id;
-	this->position = position;
+PolicySetDescriptor::PolicySetDescriptor(const string* id, const string* combine)
+	: IPolicyBaseDescriptor(id, combine) {
 	this->type = POLICY_SET;
+	policyChilds = NULL;
+	lastPolicy = NULL;
+	policySetChilds = NULL;
+	lastPolicySet = NULL;
 }
 PolicySetDescriptor::~PolicySetDescriptor() {
-	for (vector<IPolicyBaseDescriptor*>::iterator it = policyChilds.begin();
-			it != policyChilds.end(); it++) {
-		delete *it;
-	}
-	for (vector<IPolicyBaseDescriptor*>::iterator it = policySetChilds.begin();
-			it != policySetChilds.end(); it++) {
-		delete *it;
-	}
 }
 void PolicySetDescriptor::addChild(IPolicyBaseDescriptor* child) {
-	if (child->type == POLICY_SET)
-		policySetChilds.push_back(child);
-	else
-		policyChilds.push_back(child);
+	child->next = NULL;
+	if (child->type == POLICY_SET) {
+		if (lastPolicySet == NULL)
+			policySetChilds = child;
+		else
+			lastPolicySet->next = child;
+		lastPolicySet = child;
+	}
+	else {
+		if (lastPolicy == NULL)
+			policyChilds = child;
+		else
+			lastPolicy->next = child;
+		lastPolicy = child;
+	}
 }
-string PolicySetDescriptor::toJSONString() {
-	string result = "";
-	LOGD("[PolicySetDescriptor] id = %s, position = %d", id.c_str(), position);
+void PolicySetDescriptor::appendJSON(string& result) {
+	LOGD("[PolicySetDescriptor] id = %s, position = %d", id->c_str(), position);
 	//result.append("POLICYSET 'id':'" + id + "'");
 	result.append("{");
 
 	result.append(" \"type\":\"policy-set\",");
 
-	result.append(" \"id\":\"" + id + "\",");
-	result.append(" \"combine\":\"" + combine + "\",");
-	result.append(" \"effect\":\"" + IPolicyBaseDescriptor::numberToString(effect) + "\",");
-	result.append(
-			" \"position\":\"" + IPolicyBaseDescriptor::numberToString(position)+"\"");
-	if (!policyChilds.empty()) {
+	result.append(" \"id\":\"").append(*id).append("\",");
+	result.append(" \"combine\":\"").append(*combine).append("\",");
+	result.append(" \"effect\":\"");
+	appendNumber(result, effect);
+	result.append("\",");
+	result.append(" \"position\":\"");
+	appendNumber(result, position);
+	result.append("\"");
+	if (policyChilds != NULL) {
 		result.append(",");
 		result.append(" \"policy\": [");
-		for (vector<IPolicyBaseDescriptor*>::iterator it1 =
-				policyChilds.begin(); it1 != policyChilds.end();) {
-			//result.append("\n");
-			//result.append((*it)->toJSONString());
-			result.append((*it1)->toJSONString());
-			it1++;
-			if (it1 != policyChilds.end())
+		for (IPolicyBaseDescriptor* it1 = policyChilds; it1 != NULL; it1 = it1->next) {
+			it1->appendJSON(result);
+			if (it1->next != NULL)
 				result.append(", ");
 		}
 		result.append("]");
 	}
-	if (!policySetChilds.empty()) {
-		if (!policyChilds.empty())
+	if (policySetChilds != NULL) {
+		if (policyChilds != NULL)
 			result.append(", ");
 		result.append(" \"policy-set\": [");
-		for (vector<IPolicyBaseDescriptor*>::iterator it2 =
-				policySetChilds.begin(); it2 != policySetChilds.end();) {
-			//result.append("\n");
-			//result.append((*it)->toJSONString());
-			result.append((*it2)->toJSONString());
-			it2++;
-			if (it2 != policySetChilds.end())
+		for (IPolicyBaseDescriptor* it2 = policySetChilds; it2 != NULL; it2 = it2->next) {
+			it2->appendJSON(result);
+			if (it2->next != NULL)
 				result.append(", ");
 		}
 		result.append("]");
 	}
 	result.append("}");
-	return result;
 }
-
@@ -8,17 +8,18 @@
 #ifndef POLICYSETDESCRIPTOR_H_
 #define POLICYSETDESCRIPTOR_H_
 #include "IPolicyBaseDescriptor.h"
-#include <vector>
 class PolicySetDescriptor : public IPolicyBaseDescriptor{
 public:
-	PolicySetDescriptor();
-	PolicySetDescriptor(string id);
+	PolicySetDescriptor(const string* id, const string* combine);
 	virtual ~PolicySetDescriptor();
 	void addChild(IPolicyBaseDescriptor* child);
-	string toJSONString();
+	void appendJSON(string& out);
 private:
-	vector<IPolicyBaseDescriptor*> policyChilds;
-	vector<IPolicyBaseDescriptor*> policySetChilds;
+	// children in the order added, linked by next
+	IPolicyBaseDescriptor* policyChilds;
+	IPolicyBaseDescriptor* lastPolicy;
+	IPolicyBaseDescriptor* policySetChilds;
+	IPolicyBaseDescriptor* lastPolicySet;
 };
 
 
@@ -0,0 +1,358 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+#include "PredicateTable.h"
+#include <algorithm>
+
+PredicateTable::PredicateTable() {
+}
+
+PredicateTable::~PredicateTable() {
+}
+
+// id of the predicate of info, the same for every identical match element
+unsigned int PredicateTable::add(int scope, int attr, const string& name, const match_info_str* info) {
+	string source(1, (char) ('0' + scope));
+	source += '\0' + name;
+	string key = source + '\0' + info->mod_func + '\0' + info->equal_func + '\0' + info->value;
+
+	map<string, unsigned int>::iterator it = ids.find(key);
+	if (it != ids.end())
+		return it->second;
+	it = sourceIds.find(source);
+	if (it == sourceIds.end()) {
+		PredicateSource ps;
+		ps.scope = scope;
+		ps.attr = attr;
+		ps.name = name;
+		it = sourceIds.insert(make_pair(source, sources.size())).first;
+		sources.push_back(ps);
+		filters.push_back(SubjectIndex(attr));
+	}
+	Predicate predicate;
+	predicate.scope = scope;
+	predicate.attr = attr;
+	predicate.name = name;
+	predicate.match = info;
+	predicate.source = it->second;
+	ids[key] = predicates.size();
+	predicates.push_back(predicate);
+	return predicates.size() - 1;
+}
+
+/* Whether p can only match the values equal to one of its literals, which
+ * a request value then has the id of: whole-string comparisons of values
+ * the dictionary interned, without a URI function. */
+bool PredicateTable::literalOnly(const Predicate& p) const {
+	const vector<match_expr>& matchers = p.match->matchers;
+
+	if (p.match->mod_func != "" || p.attr == ATTR_DAYS_OF_WEEK || p.attr == ATTR_DAYS_OF_MONTH)
+		return false;
+	// environment values are only compared with the first one
+	unsigned int count = (p.scope == PREDICATE_ENVIRONMENT) ? 1 : matchers.size();
+	for (unsigned int i = 0; i < count; i++) {
+		const match_expr& expr = matchers[i];
+		if (expr.id == VALUE_UNRESOLVED)
+			return false;
+		if (expr.mode != STRCMP_NORMAL && !((expr.mode == STRCMP_REGEXP || expr.mode == STRCMP_GLOBBING)
+				&& expr.compiled && expr.kind == MATCH_EXACT))
+			return false;
+	}
+	return true;
+}
+
+/* Indexes the open predicates of source under the literals a value must
+ * contain for them to match (see match_literal); those with a URI
+ * function, a days attribute or a general pattern are always candidates.
+ */
+void PredicateTable::buildFilter(unsigned int source) {
+	const vector<unsigned int>& open = sources[source].open;
+
+	for (unsigned int k = 0; k < open.size(); k++) {
+		const Predicate& p = predicates[open[k]];
+		const vector<match_expr>& matchers = p.match->matchers;
+		unsigned int count = (p.scope == PREDICATE_ENVIRONMENT) ? 1 : matchers.size();
+		vector<string> literals(count);
+		bool indexed = (p.match->mod_func == "" && p.attr != ATTR_DAYS_OF_WEEK && p.attr != ATTR_DAYS_OF_MONTH
+				&& count > 0);
+		for (unsigned int i = 0; indexed && i < count; i++)
+			indexed = match_literal(matchers[i], literals[i]);
+		if (indexed)
+			filters[source].add(literals, open[k]);
+		else
+			filters[source].addOther(open[k]);
+	}
+	filters[source].build();
+}
+
+/*
+ * Open predicates of source that one value can match, at most
+ * PREDICATE_FILTER_HITS of them, unsorted; returns their number, or
+ * PREDICATE_FILTER_HITS + 1 if there are more.
+ */
+unsigned int PredicateTable::candidates(unsigned int source, const char* data, size_t length,
+		unsigned int* hits) const {
+	request_value value;
+	request_attr values;
+
+	value.data = data;
+	value.length = length;
+	value.id = VALUE_UNKNOWN;
+	values.values = &value;
+	values.count = 1;
+	unsigned int count = filters[source].collect(&values, hits, 0, PREDICATE_FILTER_HITS);
+	const vector<unsigned int>& others = filters[source].getOthers();
+	if (count > PREDICATE_FILTER_HITS || others.size() > PREDICATE_FILTER_HITS - count)
+		return PREDICATE_FILTER_HITS + 1;
+	for (unsigned int i = 0; i < others.size(); i++)
+		hits[count++] = others[i];
+	return count;
+}
+
+/* Fills the sources once every predicate is added and every literal of
+ * the policy interned in dictionary: the predicates a literal matches are
+ * its ids for literal-only ones, and the result of the comparison for
+ * the open ones.
+ */
+void PredicateTable::build(const ValueDictionary& dictionary) {
+	unsigned int end = VALUE_UNKNOWN + 1 + dictionary.size();
+	vector< vector< pair<unsigned int, unsigned int> > > pairs(sources.size());	// (value id, predicate)
+	unsigned int hits[PREDICATE_FILTER_HITS];
+
+	for (unsigned int p = 0; p < predicates.size(); p++) {
+		const Predicate& predicate = predicates[p];
+		PredicateSource& source = sources[predicate.source];
+		appendMask(source.reads, p);
+		source.members.push_back(p);
+		if (!literalOnly(predicate)) {
+			source.open.push_back(p);
+			continue;
+		}
+		const vector<match_expr>& matchers = predicate.match->matchers;
+		unsigned int count = (predicate.scope == PREDICATE_ENVIRONMENT) ? 1 : matchers.size();
+		for (unsigned int i = 0; i < count; i++)
+			pairs[predicate.source].push_back(make_pair(matchers[i].id, p));
+	}
+	for (unsigned int s = 0; s < sources.size(); s++) {
+		const vector<unsigned int>& open = sources[s].open;
+		buildFilter(s);
+		for (unsigned int id = VALUE_UNKNOWN + 1; id < end && !open.empty(); id++) {
+			const string& literal = dictionary.literal(id);
+			unsigned int count = candidates(s, literal.data(), literal.size(), hits);
+			const unsigned int* tried = hits;
+			if (count > PREDICATE_FILTER_HITS) {
+				tried = &open[0];
+				count = open.size();
+			}
+			for (unsigned int k = 0; k < count; k++) {
+				if (matchValue(predicates[tried[k]], literal.data(), literal.size(), id))
+					pairs[s].push_back(make_pair(id, tried[k]));
+			}
+		}
+	}
+	for (unsigned int s = 0; s < sources.size(); s++) {
+		vector< pair<unsigned int, unsigned int> >& list = pairs[s];
+		PredicateSource& source = sources[s];
+		sort(list.begin(), list.end());
+		list.erase(unique(list.begin(), list.end()), list.end());
+		source.first.assign(end + 1, 0);
+		source.matches.resize(list.size());
+		for (unsigned int k = 0; k < list.size(); k++) {
+			source.first[list[k].first + 1]++;
+			source.matches[k] = list[k].second;
+		}
+		for (unsigned int id = 1; id <= end; id++)
+			source.first[id] += source.first[id - 1];
+	}
+}
+
+unsigned int PredicateTable::size() const {
+	return predicates.size();
+}
+
+unsigned int PredicateTable::getSource(unsigned int predicate) const {
+	return predicates[predicate].source;
+}
+
+// p on one value of its attribute
+bool PredicateTable::matchValue(const Predicate& p, const char* data, size_t length, unsigned int id) const {
+	request_env value;
+
+	if (p.scope != PREDICATE_ENVIRONMENT)
+		return ::matchValue(p.match, data, length, id);
+	value.value = data;
+	value.length = length;
+	value.id = id;
+	if (p.attr == ATTR_DAYS_OF_WEEK || p.attr == ATTR_DAYS_OF_MONTH)
+		return matchDays(p.match, &value);
+	return matchEnvironment(p.match, &value);
+}
+
+static void setMatched(PredicateVector& results, unsigned int p) {
+	uint32_t bit = 1U << (p % 32);
+	if (results.matched[p / 32] & bit)
+		return;
+	results.matched[p / 32] |= bit;
+	results.hits.push_back(p);
+}
+
+/* the predicates of source one value matches: looked up by id for a
+ * literal, else the open ones its filter finds, or every one for a value
+ * not looked up */
+void PredicateTable::matchValue(unsigned int s, const char* data, size_t length,
+		unsigned int id, PredicateVector& results) const {
+	const PredicateSource& source = sources[s];
+	unsigned int hits[PREDICATE_FILTER_HITS];
+
+	if (id > VALUE_UNKNOWN && id + 1 < source.first.size()) {
+		for (unsigned int k = source.first[id]; k < source.first[id + 1]; k++)
+			setMatched(results, source.matches[k]);
+		return;
+	}
+	const vector<unsigned int>& all = (id == VALUE_UNKNOWN) ? source.open : source.members;
+	if (all.empty())
+		return;
+	unsigned int count = (id == VALUE_UNKNOWN) ? candidates(s, data, length, hits) : PREDICATE_FILTER_HITS + 1;
+	const unsigned int* tried = hits;
+	if (count > PREDICATE_FILTER_HITS) {
+		tried = &all[0];
+		count = all.size();
+	}
+	for (unsigned int k = 0; k < count; k++) {
+		if (matchValue(predicates[tried[k]], data, length, id))
+			setMatched(results, tried[k]);
+	}
+}
+
+void PredicateTable::matchValues(unsigned int source, const request_attr& values,
+		PredicateVector& results) const {
+	for (unsigned int i = 0; i < values.count; i++)
+		matchValue(source, values.values[i].data, values.values[i].length, values.values[i].id, results);
+}
+
+/* every predicate of the table evaluated for req, at the cost of the
+ * values of req rather than of the number of predicates */
+void PredicateTable::evaluate(const Request* req, PredicateVector& results) const {
+	unsigned int words = (predicates.size() + 31) / 32;
+
+	results.matched.assign(words, 0);
+	results.determined.assign(words, 0);
+	results.hits.clear();
+	results.present.assign(sources.size(), false);
+	for (unsigned int s = 0; s < sources.size(); s++) {
+		const PredicateSource& source = sources[s];
+		const request_attr* values;
+		const request_env* env;
+
+		switch (source.scope) {
+		case PREDICATE_SUBJECT:
+			values = (source.attr != ATTR_UNKNOWN) ? req->getSubjectAttr(source.attr) : req->getSubjectAttr(source.name);
+			if (values == NULL)
+				continue;
+			matchValues(s, *values, results);
+			break;
+		case PREDICATE_FEATURE:
+			values = req->getResourceAttr(ATTR_API_FEATURE);
+			if (values == NULL)
+				continue;
+			matchValues(s, *values, results);
+			break;
+		case PREDICATE_CAPABILITY:
+			values = (source.attr != ATTR_UNKNOWN) ? req->getResourceAttr(source.attr) : req->getResourceAttr(source.name);
+			if (values == NULL)
+				continue;
+			// compared with every resource value, see matchAnyCapability
+			for (const request_attr* a = req->getResources(); a != NULL; a = a->next) {
+				if (a->attr != ATTR_API_FEATURE)
+					matchValues(s, *a, results);
+			}
+			break;
+		default:
+			env = req->getEnvironmentAttr(source.attr);
+			matchValue(s, env->value ? env->value : "", env->length, env->id, results);
+			break;
+		}
+		results.present[s] = true;
+		for (unsigned int i = 0; i < source.reads.size(); i++)
+			results.determined[source.reads[i].word] |= source.reads[i].bits;
+	}
+}
+
+// "value: reason" of every regexp or glob value that did not compile
+void PredicateTable::collectErrors(vector<string>& errors) const {
+	for (unsigned int p = 0; p < predicates.size(); p++) {
+		const vector<match_expr>& matchers = predicates[p].match->matchers;
+		for (unsigned int i = 0; i < matchers.size(); i++) {
+			const match_expr& expr = matchers[i];
+			if ((expr.mode == STRCMP_REGEXP || expr.mode == STRCMP_GLOBBING) && !expr.compiled)
+				errors.push_back(expr.value + ": " + expr.re.getError());
+		}
+	}
+}
+
+// adds predicate to mask, kept sorted by word
+void PredicateTable::appendMask(vector<PredicateMask>& mask, unsigned int predicate) {
+	unsigned int word = predicate / 32;
+	vector<PredicateMask>::iterator it = mask.begin();
+
+	while (it != mask.end() && it->word < word)
+		it++;
+	if (it == mask.end() || it->word != word) {
+		PredicateMask m;
+		m.word = word;
+		m.bits = 0;
+		it = mask.insert(it, m);
+	}
+	it->bits |= 1U << (predicate % 32);
+}
+
+bool matchValue(const match_info_str* info, const char* data, size_t length, unsigned int id) {
+	if (info->mod_func != "") {
+		StringView part = modFunction(info->mod_func, StringView(data, length));
+		return equals_any(part.data, part.length, info->matchers);
+	}
+	return equals_any(data, length, info->matchers, id);
+}
+
+bool matchAnyValue(const match_info_str* info, const request_attr& values) {
+	for (unsigned int i = 0; i < values.count; i++) {
+		if (matchValue(info, values.values[i].data, values.values[i].length, values.values[i].id))
+			return true;
+	}
+	return false;
+}
+
+/* Every resource value of the request but the api-feature ones is
+ * compared, whatever the attribute of the capability match. */
+bool matchAnyCapability(const match_info_str* info, const request_attr* resources) {
+	for (const request_attr* a = resources; a != NULL; a = a->next) {
+		if (a->attr != ATTR_API_FEATURE && matchAnyValue(info, *a))
+			return true;
+	}
+	return false;
+}
+
+bool matchEnvironment(const match_info_str* info, const request_env* value) {
+	return equals(value->value ? value->value : "", value->length, info->matchers[0], value->id);
+}
+
+bool matchDays(const match_info_str* info, const request_env* value) {
+	return compare_in_set(value->value ? value->value : "", value->length, info->value);
+}
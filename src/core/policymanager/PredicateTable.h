@@ -0,0 +1,173 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+
+#ifndef PREDICATETABLE_H_
+#define PREDICATETABLE_H_
+
+#include "Request.h"
+#include "SubjectIndex.h"
+#include "ValueDictionary.h"
+#include "../../core/common.h"
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+typedef struct {
+	string equal_func;
+//	string match;
+	string value;
+	string mod_func;
+	vector<match_expr> matchers;	// compiled value (one per bag item in subject-match)
+	unsigned int predicate;			// in the PredicateTable of the policy, PREDICATE_NONE if none
+} match_info_str;
+
+// all the match elements on one attribute
+typedef struct {
+	int						attr;		// AttributeId, ATTR_UNKNOWN if not well-known
+	string					name;
+	vector<match_info_str*>	matches;
+} attribute_match;
+
+// what a predicate matches the values of
+enum PredicateScope {PREDICATE_SUBJECT, PREDICATE_FEATURE, PREDICATE_CAPABILITY, PREDICATE_ENVIRONMENT};
+
+// predicate of a match element not in a table
+const unsigned int PREDICATE_NONE = (unsigned int) -1;
+
+// most open predicates taken from a filter before comparing them all
+const unsigned int PREDICATE_FILTER_HITS = 64;
+
+typedef struct {
+	unsigned char			scope;		// PredicateScope
+	int						attr;		// AttributeId, ATTR_UNKNOWN if not well-known
+	string					name;		// of the attribute
+	const match_info_str*	match;		// first of the identical match elements
+	unsigned int			source;		// in the PredicateTable
+} Predicate;
+
+/*
+ * Results of all the predicates of a table for one request, one bit per
+ * predicate in each vector. A predicate is determined when the request
+ * has the attribute it reads (environment ones always are), and matched
+ * when it is determined and a value matches.
+ */
+typedef struct {
+	vector<uint32_t>		matched;
+	vector<uint32_t>		determined;
+	vector<unsigned int>	hits;		// the matched predicates, in no order
+	vector<bool>			present;	// by source, whether its predicates are determined
+} PredicateVector;
+
+// the bits of a set of predicates (or rules) in one word of a bit vector
+typedef struct {
+	unsigned int	word;
+	uint32_t		bits;
+} PredicateMask;
+
+/*
+ * The predicates reading one request attribute, with the ones every
+ * literal of the policy's ValueDictionary matches, worked out at load
+ * time: a request value resolved to a literal sets them without a
+ * comparison. Only values that are not literals are compared, with the
+ * open predicates, those a value outside the dictionary can match
+ * (anything but a whole-string literal), and of those only the ones the
+ * filter of the source finds a literal of in the value.
+ */
+typedef struct {
+	unsigned char			scope;		// PredicateScope
+	int						attr;		// AttributeId, ATTR_UNKNOWN if not well-known
+	string					name;		// of the attribute
+	vector<PredicateMask>	reads;		// every predicate of the source
+	vector<unsigned int>	members;	// the same, for values that are not looked up
+	vector<unsigned int>	open;
+	vector<unsigned int>	first;		// by value id, its predicates in matches
+	vector<unsigned int>	matches;
+} PredicateSource;
+
+/*
+ * Atomic predicates of a policy: one per distinct match element, given
+ * by the attribute it reads, its URI function, its comparison function
+ * and its value. Match elements repeated across subjects and conditions,
+ * e.g. the same owner check in many policies, share one predicate, so
+ * that a PredicateMemo evaluates it at most once per request, and a
+ * PredicateVector holds the results of them all. The predicates are
+ * grouped by the attribute they read into sources (see build).
+ */
+class PredicateTable
+	{
+
+private:
+	map<string, unsigned int>	ids;
+	vector<Predicate>			predicates;
+	map<string, unsigned int>	sourceIds;
+	vector<PredicateSource>		sources;
+	vector<SubjectIndex>		filters;	// by source, its open predicates by literal
+
+	bool matchValue(const Predicate&, const char*, size_t, unsigned int) const;
+	bool literalOnly(const Predicate&) const;
+	void matchValues(unsigned int source, const request_attr&, PredicateVector&) const;
+	void matchValue(unsigned int source, const char*, size_t, unsigned int, PredicateVector&) const;
+	void buildFilter(unsigned int source);
+	unsigned int candidates(unsigned int source, const char*, size_t, unsigned int* hits) const;
+
+public:
+	PredicateTable();
+	virtual ~PredicateTable();
+
+	unsigned int add(int scope, int attr, const string& name, const match_info_str*);
+	void build(const ValueDictionary&);
+	unsigned int size() const;
+	unsigned int getSource(unsigned int predicate) const;
+	void evaluate(const Request*, PredicateVector&) const;
+	void collectErrors(vector<string>&) const;
+	static void appendMask(vector<PredicateMask>&, unsigned int predicate);
+	};
+
+/*
+ * Results of the predicates of a table for one request, two bits each:
+ * whether the predicate was evaluated and whether it matched.
+ */
+class PredicateMemo
+	{
+
+private:
+	vector<uint32_t>	bits;
+
+public:
+	void reset(unsigned int count) { bits.assign((count + 15) / 16, 0); }
+	// -1 if not evaluated yet, else 0 or 1
+	int get(unsigned int p) const {
+		uint32_t b = bits[p / 16] >> (2 * (p % 16));
+		return (b & 1) ? (int) ((b >> 1) & 1) : -1;
+	}
+	void set(unsigned int p, bool matched) { bits[p / 16] |= (matched ? 3U : 1U) << (2 * (p % 16)); }
+	};
+
+// comparisons of one match element, shared by lazy and vector evaluation
+bool matchValue(const match_info_str* info, const char* data, size_t length, unsigned int id);
+bool matchAnyValue(const match_info_str* info, const request_attr& values);
+bool matchAnyCapability(const match_info_str* info, const request_attr* resources);
+bool matchEnvironment(const match_info_str* info, const request_env* value);
+bool matchDays(const match_info_str* info, const request_env* value);
+
+#endif /* PREDICATETABLE_H_ */
@@ -32,6 +32,8 @@ ProvisionalAction::ProvisionalAction(TiXmlElement* provisionalaction){
 	if (child) {
 		value2 = child->GetText();
 	}
+	compile_match_expr(glob1, value1, STRCMP_GLOBBING);
+	compile_match_expr(glob2, value2, STRCMP_GLOBBING);
 	if (value1.empty() == false && value2.empty() == false) {
 		LOGD("ProvisionalAction constructor, attribute values: %s, %s", value1.c_str(), value2.c_str());
 	}
@@ -43,41 +45,47 @@ ProvisionalAction::ProvisionalAction(TiXmlElement* provisionalaction){
 ProvisionalAction::~ProvisionalAction(){
 }
 
-pair<string, bool> ProvisionalAction::evaluate(Request * req){
+// returns the id of the DHPref linked to the requested feature, or NULL;
+// exact is set when the feature is matched exactly rather than by glob
+const string* ProvisionalAction::evaluate(const Request * req, bool& exact){
 
 	int features = 0;
-	string req_feature;
-	map<string, vector<string>* > resource_attrs = req->getResourceAttrs();
+	const request_attr* req_features = req->getResourceAttr(ATTR_API_FEATURE);
 
-	if (resource_attrs.count(API_FEATURE) == 1) {
-		features = (req->getResourceAttrs())[API_FEATURE]->size();
+	if (req_features != NULL) {
+		features = req_features->count;
 		if (features == 1) {
-			req_feature = (req->getResourceAttrs())[API_FEATURE]->at(0);
+			const request_value& req_feature = req_features->values[0];
 
 			// Provisional actions link together a single DHPref and a single feature,
 			// more than a feature in a request should not be allowed
 			// this is already tested in PolicyManager.cpp, but it is tested again here to be careful
 			if (value1.empty() == false && value2.empty() == false) {
-				LOGD("ProvisionalAction: values %s and %s to compare with %s", value1.c_str(), value2.c_str(), req_feature.c_str());
-				if (value1.compare(req_feature) == 0) {
-					LOGD("ProvisionalAction: %s and %s exact match", value1.c_str(), req_feature.c_str());
-					return pair<string, bool>(value2, true);
+				LOGD("ProvisionalAction: values %s and %s to compare with %s", value1.c_str(), value2.c_str(), req_feature.data);
+				if (value1.compare(0, string::npos, req_feature.data, req_feature.length) == 0) {
+					LOGD("ProvisionalAction: %s and %s exact match", value1.c_str(), req_feature.data);
+					exact = true;
+					return &value2;
 				}
-				if (value2.compare(req_feature) == 0) {
-					LOGD("ProvisionalAction: %s and %s exact match", value2.c_str(), req_feature.c_str());
-					return pair<string, bool>(value1, true);
+				if (value2.compare(0, string::npos, req_feature.data, req_feature.length) == 0) {
+					LOGD("ProvisionalAction: %s and %s exact match", value2.c_str(), req_feature.data);
+					exact = true;
+					return &value1;
 				}
-				if (equals(req_feature, value1, string2strcmp_mode("glob"))) {
-					LOGD("ProvisionalAction: %s and %s partial match", value1.c_str(), req_feature.c_str());
-					return pair<string, bool>(value2, false);
+				if (equals(req_feature.data, req_feature.length, glob1)) {
+					LOGD("ProvisionalAction: %s and %s partial match", value1.c_str(), req_feature.data);
+					exact = false;
+					return &value2;
 				}
-				if (equals(req_feature, value2, string2strcmp_mode("glob"))) {
-					LOGD("ProvisionalAction: %s and %s partial match", value2.c_str(), req_feature.c_str());
-					return pair<string, bool>(value1, false);
+				if (equals(req_feature.data, req_feature.length, glob2)) {
+					LOGD("ProvisionalAction: %s and %s partial match", value2.c_str(), req_feature.data);
+					exact = false;
+					return &value1;
 				}
 			}
 		}
 	}
 	
-	return pair<string, bool>("", false);
+	exact = false;
+	return NULL;
 }
@@ -31,12 +31,14 @@ class ProvisionalAction{
 private:
 	string	value1;
 	string	value2;
+	match_expr	glob1;
+	match_expr	glob2;
 	
 public:
 	ProvisionalAction(TiXmlElement*);
 	virtual ~ProvisionalAction();
 
-	pair<string, bool> evaluate(Request *);
+	const string* evaluate(const Request *, bool&);
 };
 
 #endif /* PROVISIONALACTION_H_ */
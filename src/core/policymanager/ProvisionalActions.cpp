@@ -36,28 +36,26 @@ ProvisionalActions::~ProvisionalActions() {
 		delete *it;
 }
 
-pair<string, bool> ProvisionalActions::evaluate(Request * req){
+const string* ProvisionalActions::evaluate(const Request * req, bool& exact){
 
-	pair<string, bool> preferenceid;
-	pair<string, bool> partial_match_preferenceid;
+	const string* preferenceid;
+	const string* partial_match_preferenceid = NULL;
 
 	// search for a provisional action with a resource matching the request
 	for(unsigned int i=0; i<provisionalaction.size(); i++){
 		LOGD("ProvisionalActions: ProvisionalAction %d evaluation", i);
-		preferenceid = provisionalaction[i]->evaluate(req);
-		LOGD("ProvisionalActions: ProvisionalAction %d evaluation response: %s", i, preferenceid.first.c_str());
+		preferenceid = provisionalaction[i]->evaluate(req, exact);
+		LOGD("ProvisionalActions: ProvisionalAction %d evaluation response: %s", i, preferenceid ? preferenceid->c_str() : "");
 
 		// return the exact match
-		if (preferenceid.second == true)
+		if (preferenceid != NULL && exact == true)
 			return preferenceid;
 
 		// save the partial match
-		if (preferenceid.first.empty() == false && preferenceid.second == false)
+		if (preferenceid != NULL && preferenceid->empty() == false)
 			partial_match_preferenceid = preferenceid;
 	}
 	
-	if (partial_match_preferenceid.first.empty() == false)
-		return partial_match_preferenceid;
-	else
-		return pair<string, bool>("", false);
+	exact = false;
+	return partial_match_preferenceid;
 }
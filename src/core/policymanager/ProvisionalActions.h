@@ -34,7 +34,7 @@ public:
 	ProvisionalActions(TiXmlElement*);
 	virtual ~ProvisionalActions();
 
-	pair<string, bool> evaluate(Request *);
+	const string* evaluate(const Request *, bool&);
 };
 
 #endif /* PROVISIONALACTIONS_H_ */
@@ -18,51 +18,223 @@
  ******************************************************************************/
 
 #include "Request.h"
+#include <cstdlib>
+#include <cstring>
+
+// chunk sizes are multiples of this, so that anything fits aligned
+static const size_t ARENA_ALIGN = sizeof(double) > sizeof(void*) ? sizeof(double) : sizeof(void*);
+
+RequestArena::RequestArena() : next(first), left(sizeof(first)), chunks(NULL){
+}
+
+RequestArena::~RequestArena(){
+	while(chunks != NULL){
+		char* previous = *(char**) chunks;
+		free(chunks);
+		chunks = previous;
+	}
+}
+
+void* RequestArena::allocate(size_t size){
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+	if(size > left){
+		// at least twice the inline chunk, so that overflow stays rare
+		size_t length = ARENA_ALIGN + (size > 2 * sizeof(first) ? size : 2 * sizeof(first));
+		char* chunk = (char*) malloc(length);
+		if(chunk == NULL)
+			throw bad_alloc();
+		*(char**) chunk = chunks;
+		chunks = chunk;
+		next = chunk + ARENA_ALIGN;
+		left = length - ARENA_ALIGN;
+	}
+	void* result = next;
+	next += size;
+	left -= size;
+	return result;
+}
+
+const char* RequestArena::copy(const char* data, size_t length){
+	char* result = (char*) allocate(length + 1);
+	memcpy(result, data, length);
+	result[length] = '\0';
+	return result;
+}
+
+Request::Request(){
+	init();
+}
 
 Request::Request(map<string, vector<string>*>& info, map<string, vector<string>*>& resources, vector<bool> purpose, obligations& obl, map<string,string>&environment){	
-	subject_attrs = info;
-	resource_attrs = resources;
+	init();
+	addAttrs(info, true);
+	addAttrs(resources, false);
 	purpose_attrs = purpose;
 	obligations_attrs = obl;
-	request_subject_text = "";
-	request_resource_text = "";
-	request_environment_text = "";
-	environment_attrs = environment;
+	for(map<string,string>::iterator it = environment.begin(); it != environment.end(); it++)
+		memcpy(setEnvironmentAttr(it->first, it->second.size()), it->second.data(), it->second.size());
 }
 	
 Request::Request(const string& widgetRootPath, map<string, vector<string>*>& resources){
+	init();
 	this->widgetRootPath = widgetRootPath;
-	resource_attrs = resources;
-	request_subject_text = "";
-	request_resource_text = "";
-	request_environment_text = "";
+	addAttrs(resources, false);
 	
 	string roaming = "";
 	string bearer = "unknown";
 
-	environment_attrs["roaming"] = roaming;
-	environment_attrs["bearer-type"] = bearer;
+	setEnvironmentAttr("roaming", roaming.size());
+	memcpy(setEnvironmentAttr("bearer-type", bearer.size()), bearer.data(), bearer.size());
 }
 
 Request::Request(const string& widgetRootPath, map<string, vector<string>*>& resources, map<string,string>&environment){
+	init();
 	this->widgetRootPath = widgetRootPath;
-	resource_attrs = resources;
+	addAttrs(resources, false);
+	for(map<string,string>::iterator it = environment.begin(); it != environment.end(); it++)
+		memcpy(setEnvironmentAttr(it->first, it->second.size()), it->second.data(), it->second.size());
+}
+
+// the arena holds everything else
+Request::~Request(){
+}
+
+void Request::init(){
 	request_subject_text = "";
 	request_resource_text = "";
 	request_environment_text = "";
-	environment_attrs = environment;
+	present = 0;
+	subjects = NULL;
+	resources = NULL;
+	environment_others = NULL;
+	for(unsigned int i = 0; i < ATTR_ROAMING; i++){
+		slots[i].attr = i;
+		slots[i].name = attribute2string((AttributeId) i);
+		slots[i].values = NULL;
+		slots[i].count = 0;
+		slots[i].capacity = 0;
+		slots[i].next = NULL;
+	}
+	for(unsigned int i = 0; i < ATTR_COUNT; i++){
+		environment_slots[i].value = NULL;
+		environment_slots[i].length = 0;
+		environment_slots[i].id = VALUE_UNRESOLVED;
+	}
 }
 
-Request::~Request(){
-	for(map<string,vector<string>*>::iterator it = subject_attrs.begin(); it!=subject_attrs.end(); it++){
-		it->second->clear();
+// values of the maps are copied, the vectors are deleted as the request owned them
+void Request::addAttrs(map<string, vector<string>*>& attrs, bool subject){
+	for(map<string,vector<string>*>::iterator it = attrs.begin(); it != attrs.end(); it++){
+		request_attr* attr = subject ? addSubjectAttr(it->first) : addResourceAttr(it->first);
+		for(unsigned int i = 0; i < it->second->size(); i++)
+			addValue(attr, it->second->at(i).data(), it->second->at(i).size());
 		delete it->second;
 		it->second = NULL;
 	}
-	for(map<string,vector<string>*>::iterator it = resource_attrs.begin(); it!=resource_attrs.end(); it++){
-		it->second->clear();
-		delete it->second;
-		it->second = NULL;
+}
+
+/*
+ * Slot of a well-known attribute, put in its list if not there yet; the
+ * list keeps AttributeId order, before any unknown attribute.
+ */
+request_attr* Request::linkAttr(request_attr** list, int attr){
+	request_attr* slot = &slots[attr];
+	if(present & (1U << attr))
+		return slot;
+	while(*list != NULL && (*list)->attr != ATTR_UNKNOWN && (*list)->attr < attr)
+		list = &(*list)->next;
+	slot->next = *list;
+	*list = slot;
+	present |= 1U << attr;
+	return slot;
+}
+
+// attribute outside AttributeId, added at the end of the list if not there yet
+request_attr* Request::otherAttr(request_attr** list, const string& name){
+	for(; *list != NULL; list = &(*list)->next){
+		if((*list)->attr == ATTR_UNKNOWN && name == (*list)->name)
+			return *list;
+	}
+	request_attr* other = (request_attr*) arena.allocate(sizeof(request_attr));
+	other->attr = ATTR_UNKNOWN;
+	other->name = arena.copy(name.data(), name.size());
+	other->values = NULL;
+	other->count = 0;
+	other->capacity = 0;
+	other->next = NULL;
+	*list = other;
+	return other;
+}
+
+// a well-known name outside its group is kept with the unknown ones
+request_attr* Request::addSubjectAttr(const string& name){
+	AttributeId attr = string2attribute(name);
+	return (attr < ATTR_API_FEATURE) ? linkAttr(&subjects, attr) : otherAttr(&subjects, name);
+}
+
+request_attr* Request::addResourceAttr(const string& name){
+	AttributeId attr = string2attribute(name);
+	return (attr >= ATTR_API_FEATURE && attr < ATTR_ROAMING) ? linkAttr(&resources, attr) : otherAttr(&resources, name);
+}
+
+// well-known subject or resource attribute
+request_attr* Request::addAttr(AttributeId attr){
+	return linkAttr((attr < ATTR_API_FEATURE) ? &subjects : &resources, attr);
+}
+
+// room for a value of up to length characters, ended by a NUL
+char* Request::addValue(request_attr* attr, size_t length){
+	if(attr->count == attr->capacity){
+		unsigned int capacity = attr->capacity ? 2 * attr->capacity : 1;
+		request_value* values = (request_value*) arena.allocate(capacity * sizeof(request_value));
+		if(attr->count > 0)
+			memcpy(values, attr->values, attr->count * sizeof(request_value));
+		attr->values = values;
+		attr->capacity = capacity;
+	}
+	char* data = (char*) arena.allocate(length + 1);
+	data[length] = '\0';
+	request_value& value = attr->values[attr->count++];
+	value.data = data;
+	value.length = length;
+	value.id = VALUE_UNRESOLVED;
+	return data;
+}
+
+void Request::addValue(request_attr* attr, const char* data, size_t length){
+	memcpy(addValue(attr, length), data, length);
+}
+
+// room for the value of an environment attribute, replacing any previous one
+char* Request::setEnvironmentAttr(AttributeId attr, size_t length){
+	char* data = (char*) arena.allocate(length + 1);
+	data[length] = '\0';
+	environment_slots[attr].value = data;
+	environment_slots[attr].length = length;
+	return data;
+}
+
+char* Request::setEnvironmentAttr(const string& name, size_t length){
+	AttributeId attr = string2attribute(name);
+	if(attr >= ATTR_ROAMING && attr < ATTR_COUNT)
+		return setEnvironmentAttr(attr, length);
+	request_attr* other = otherAttr(&environment_others, name);
+	other->count = 0;
+	return addValue(other, length);
+}
+
+// values end at their first NUL, as those read from JavaScript strings do
+void Request::trimValues(){
+	request_attr* lists[] = {subjects, resources};
+	for(unsigned int k = 0; k < 2; k++){
+		for(request_attr* a = lists[k]; a != NULL; a = a->next){
+			for(unsigned int i = 0; i < a->count; i++)
+				a->values[i].length = strlen(a->values[i].data);
+		}
+	}
+	for(unsigned int i = ATTR_ROAMING; i < ATTR_COUNT; i++){
+		if(environment_slots[i].value != NULL)
+			environment_slots[i].length = strlen(environment_slots[i].value);
 	}
 }
 
@@ -78,16 +250,15 @@ TiXmlElement* Request::getXmlSubjectTag(){
 	attribute->LinkEndChild(attributeValue);
 	subject->LinkEndChild(attribute);
 	
-	vector<string>* tmp;
-	for(map<string,vector<string>*>::iterator it=subject_attrs.begin(); it!=subject_attrs.end(); it++)
+	for(const request_attr* a = subjects; a != NULL; a = a->next)
 	{
-		tmp = it->second;
-		for(unsigned int i=0; i<tmp->size(); i++){
+		for(unsigned int i=0; i<a->count; i++){
+			string value(a->values[i].data, a->values[i].length);
 			attribute = new TiXmlElement("Attribute");
 			attributeValue = new TiXmlElement("AttributeValue");
-			attribute->SetAttribute("AttributeId", it->first);
-			attributeValue->LinkEndChild(new TiXmlText(tmp->at(i)));
-			request_subject_text += it->first + ":" + tmp->at(i) + ";";
+			attribute->SetAttribute("AttributeId", a->name);
+			attributeValue->LinkEndChild(new TiXmlText(value));
+			request_subject_text += string(a->name) + ":" + value + ";";
 			attribute->LinkEndChild(attributeValue);
 			subject->LinkEndChild(attribute);
 		}
@@ -100,15 +271,14 @@ TiXmlElement* Request::getXmlResourcesTag(){
 	TiXmlElement * attribute;
 	TiXmlElement * attributeValue;
 	
-	vector<string>* tmp;
-	for(map<string,vector<string>*>::iterator it=resource_attrs.begin(); it!=resource_attrs.end(); it++){
-		tmp = it->second;
-		for(unsigned int i=0; i<tmp->size(); i++){
+	for(const request_attr* a = this->resources; a != NULL; a = a->next){
+		for(unsigned int i=0; i<a->count; i++){
+			string value(a->values[i].data, a->values[i].length);
 			attribute = new TiXmlElement("Attribute");
 			attributeValue = new TiXmlElement("AttributeValue");
-			attribute->SetAttribute("AttributeId", it->first);
-			attributeValue->LinkEndChild(new TiXmlText(tmp->at(i)));
-			request_resource_text += it->first + ":" + tmp->at(i) + ";";
+			attribute->SetAttribute("AttributeId", a->name);
+			attributeValue->LinkEndChild(new TiXmlText(value));
+			request_resource_text += string(a->name) + ":" + value + ";";
 			attribute->LinkEndChild(attributeValue);
 			resources->LinkEndChild(attribute);
 		}
@@ -122,6 +292,13 @@ TiXmlElement* Request::getXmlEnvironmentTag(){
 	TiXmlElement * attribute;
 	TiXmlElement * attributeValue;
 	
+	map<string, string> environment_attrs;
+	for(unsigned int i = ATTR_ROAMING; i < ATTR_COUNT; i++){
+		if(environment_slots[i].value != NULL)
+			environment_attrs[attribute2string((AttributeId) i)].assign(environment_slots[i].value, environment_slots[i].length);
+	}
+	for(const request_attr* a = environment_others; a != NULL; a = a->next)
+		environment_attrs[a->name].assign(a->values[0].data, a->values[0].length);
 	for(map<string,string>::iterator it=environment_attrs.begin(); it!=environment_attrs.end(); it++){
 		attribute = new TiXmlElement("Attribute");
 		attributeValue = new TiXmlElement("AttributeValue");
@@ -150,15 +327,11 @@ void Request::saveXmlFile(const string& path){
 	getXmlDocument()->SaveFile(path);
 }
 
-map<string, vector<string>*>& Request::getSubjectAttrs(){
-	return subject_attrs;
-}
-
-map<string, vector<string>*>& Request::getResourceAttrs(){
-	return resource_attrs;
+vector<bool>& Request::getPurposeAttrs(){
+	return purpose_attrs;
 }
 
-vector<bool> Request::getPurposeAttrs(){
+const vector<bool>& Request::getPurposeAttrs() const{
 	return purpose_attrs;
 }
 
@@ -166,8 +339,8 @@ obligations& Request::getObligationsAttrs(){
 	return obligations_attrs;
 }
 
-map<string,string>& Request::getEnvironmentAttrs(){
-	return environment_attrs;
+const obligations& Request::getObligationsAttrs() const{
+	return obligations_attrs;
 }
 
 string Request::getRequestText(){
@@ -182,10 +355,88 @@ string Request::getWidgetRootPath(){
 	return widgetRootPath;
 }
 
-void Request::setSubjectAttrs(map<string, vector<string>*>& subjects){
-	subject_attrs = subjects;
+const request_attr* Request::findAttr(const request_attr* list, const char* name){
+	for(; list != NULL; list = list->next){
+		if(strcmp(name, list->name) == 0)
+			return list;
+	}
+	return NULL;
 }
 
-void Request::setResourceAttrs(map<string, vector<string>*>& resources){
-	resource_attrs = resources;
+// attributes added outside their group are only found by name
+const request_attr* Request::getSubjectAttr(int attr) const{
+	if(attr >= ATTR_API_FEATURE)
+		return findAttr(subjects, attribute2string((AttributeId) attr));
+	return (present & (1U << attr)) ? &slots[attr] : NULL;
+}
+
+const request_attr* Request::getSubjectAttr(const string& name) const{
+	return findAttr(subjects, name.c_str());
+}
+
+const request_attr* Request::getResourceAttr(int attr) const{
+	if(attr < ATTR_API_FEATURE || attr >= ATTR_ROAMING)
+		return findAttr(resources, attribute2string((AttributeId) attr));
+	return (present & (1U << attr)) ? &slots[attr] : NULL;
+}
+
+const request_attr* Request::getResourceAttr(const string& name) const{
+	return findAttr(resources, name.c_str());
+}
+
+const request_attr* Request::getSubjects() const{
+	return subjects;
+}
+
+const request_attr* Request::getResources() const{
+	return resources;
+}
+
+const request_env* Request::getEnvironmentAttr(int attr) const{
+	return &environment_slots[attr];
+}
+
+/*
+ * Orders requests by their subject attributes (names and values); 0 means
+ * that every subject target gives the same result for both.
+ */
+int Request::compareSubject(const Request& other) const{
+	const request_attr* a = subjects;
+	const request_attr* b = other.subjects;
+	for(; a != NULL && b != NULL; a = a->next, b = b->next){
+		int c = strcmp(a->name, b->name);
+		if(c != 0)
+			return c;
+		if(a->count != b->count)
+			return (a->count < b->count) ? -1 : 1;
+		for(unsigned int j = 0; j < a->count; j++){
+			const request_value& x = a->values[j];
+			const request_value& y = b->values[j];
+			c = memcmp(x.data, y.data, (x.length < y.length) ? x.length : y.length);
+			if(c == 0 && x.length != y.length)
+				c = (x.length < y.length) ? -1 : 1;
+			if(c != 0)
+				return c;
+		}
+	}
+	if(a != b)
+		return (a == NULL) ? -1 : 1;
+	return 0;
+}
+
+static void resolveList(request_attr* list, const ValueDictionary& dictionary){
+	for(; list != NULL; list = list->next){
+		for(unsigned int j = 0; j < list->count; j++)
+			list->values[j].id = dictionary.find(list->values[j].data, list->values[j].length);
+	}
+}
+
+// look up every value in the dictionary of the policy about to be evaluated
+void Request::resolveValues(const ValueDictionary& dictionary){
+	resolveList(subjects, dictionary);
+	resolveList(resources, dictionary);
+	for(unsigned int i = ATTR_ROAMING; i < ATTR_COUNT; i++){
+		request_env& env = environment_slots[i];
+		env.id = dictionary.find(env.value ? env.value : "", env.length);
+	}
 }
@@ -24,6 +24,8 @@
 #include <map>
 #include "../../../contrib/xmltools/tinyxml.h"
 #include "../../core/Environment.h"
+#include "Globals.h"
+#include "ValueDictionary.h"
 using namespace std;
 
 typedef struct {
@@ -32,42 +34,160 @@ typedef struct {
 } obligation;
 typedef vector<obligation> obligations;
 
+// one value of a request attribute, kept in the arena of the request
+typedef struct {
+	const char*		data;		// NUL terminated
+	size_t			length;
+	unsigned int	id;			// ValueDictionary id, VALUE_UNRESOLVED if not looked up
+} request_value;
+
+// one subject or resource attribute of a request
+typedef struct request_attr_t {
+	int						attr;		// AttributeId, ATTR_UNKNOWN if not well-known
+	const char*				name;
+	request_value*			values;
+	unsigned int			count;
+	unsigned int			capacity;
+	struct request_attr_t*	next;		// following attribute of the same group
+} request_attr;
+
+/*
+ * Request attributes a compiled policy can look at, collected at load
+ * time; anything else in a request cannot change the decision.
+ */
+typedef struct {
+	bool			subjects[ATTR_COUNT];
+	vector<string>	otherSubjects;		// subject attributes outside AttributeId
+	bool			capabilities;		// resource-match on anything but api-feature
+	bool			environment[ATTR_COUNT];
+	bool			timeExact;			// timemin compared other than as a number
+	vector<int>		timeThresholds;		// sorted numeric timemin bounds
+} AttributeReferences;
+
+/*
+ * Whether a policy with these references can look at a well-known
+ * attribute; api-feature always counts, and NULL references (nothing
+ * known about the policy) count for every attribute.
+ */
+inline bool attribute_referenced(const AttributeReferences* refs, int attr){
+	if(refs == NULL || attr == ATTR_API_FEATURE)
+		return true;
+	if(attr < ATTR_API_FEATURE)
+		return refs->subjects[attr];
+	if(attr < ATTR_ROAMING)
+		return refs->capabilities;
+	return attr < ATTR_COUNT && refs->environment[attr];
+}
+
+// one environment attribute of a request
+typedef struct {
+	const char*				value;		// NULL if absent, compared as ""
+	size_t					length;
+	unsigned int			id;
+} request_env;
+
+// bytes a request holds before its arena needs the heap
+const unsigned int REQUEST_INLINE_BYTES = 1024;
+
+/*
+ * Bump allocator holding everything a request points to: values, their
+ * arrays and the attributes outside AttributeId. The first chunk is part
+ * of the request; memory is only given back when the arena goes.
+ */
+class RequestArena
+	{
+private:
+	char	first[REQUEST_INLINE_BYTES];
+	char*	next;
+	size_t	left;
+	char*	chunks;			// heap chunks, each starting with the previous one
+
+	RequestArena(const RequestArena&);
+	RequestArena& operator=(const RequestArena&);
+
+public:
+	RequestArena();
+	~RequestArena();
+
+	void* allocate(size_t);
+	const char* copy(const char*, size_t);
+	};
+
+/*
+ * Attributes of an access request. Well-known subject and resource
+ * attributes have a fixed slot, anything else goes to a list after them;
+ * every value lives in the arena of the request, so that building one
+ * takes a single allocation for the usual request and destroying it
+ * frees nothing but the arena overflow.
+ */
 class Request
 	{	
 private:
     string widgetRootPath;
-	map<string, vector<string>*>	subject_attrs;
-	map<string, vector<string>*>	resource_attrs;
-	map<string, string>				environment_attrs;
+	RequestArena		arena;
+	request_attr		slots[ATTR_ROAMING];		// indexed by AttributeId
+	uint32_t			present;					// bit of each slot in a list
+	request_attr*		subjects;					// present ones, in AttributeId order
+	request_attr*		resources;					// then the unknown ones
+	request_env			environment_slots[ATTR_COUNT];
+	request_attr*		environment_others;			// unknown environment names
 	vector<bool> purpose_attrs;
 	obligations obligations_attrs;
 	string request_subject_text;
 	string request_resource_text;
 	string request_environment_text;
 	
+	Request(const Request&);
+	Request& operator=(const Request&);
+
+	void init();
+	void addAttrs(map<string, vector<string>*>&, bool subject);
+	request_attr* linkAttr(request_attr**, int);
+	request_attr* otherAttr(request_attr**, const string&);
+	static const request_attr* findAttr(const request_attr*, const char*);
+	
 	TiXmlElement* getXmlSubjectTag();
 	TiXmlElement* getXmlResourcesTag();
 	TiXmlElement* getXmlEnvironmentTag();
 	
 public:
+	Request();
 	Request(const string& widgetRootPath, map<string, vector<string>*>& resources);
 	Request(const string& widgetRootPath, map<string, vector<string>*>& resources, map<string,string>&environment);
 	Request(map<string, vector<string>*>&, map<string, vector<string>*>&, vector<bool>, obligations&, map<string,string>&environment);
 	virtual ~Request();
 	
+	// building
+	request_attr*	addSubjectAttr(const string& name);
+	request_attr*	addResourceAttr(const string& name);
+	request_attr*	addAttr(AttributeId);
+	char*			addValue(request_attr*, size_t length);
+	void			addValue(request_attr*, const char* data, size_t length);
+	char*			setEnvironmentAttr(AttributeId, size_t length);
+	char*			setEnvironmentAttr(const string& name, size_t length);
+	void			trimValues();
+	
 	TiXmlDocument* getXmlDocument();
 	void saveXmlFile(const string&);
 	
-	map<string, vector<string>*>&	getSubjectAttrs();
-	map<string, vector<string>*>&	getResourceAttrs();
-	vector<bool>	getPurposeAttrs();
+	vector<bool>&	getPurposeAttrs();
+	const vector<bool>&	getPurposeAttrs() const;
 	obligations&	getObligationsAttrs();
-	map<string, string>&			getEnvironmentAttrs();
+	const obligations&	getObligationsAttrs() const;
 	string getWidgetRootPath();
 	string getRequestText();
 	string getRequestSubjectText();
-	void setSubjectAttrs(map<string, vector<string>*>&);
-	void setResourceAttrs(map<string, vector<string>*>&);
+	
+	// read-only view used by the evaluator
+	const request_attr*	getSubjectAttr(int attr) const;
+	const request_attr*	getSubjectAttr(const string& name) const;
+	const request_attr*	getResourceAttr(int attr) const;
+	const request_attr*	getResourceAttr(const string& name) const;
+	const request_attr*	getSubjects() const;
+	const request_attr*	getResources() const;
+	const request_env*	getEnvironmentAttr(int attr) const;
+	int compareSubject(const Request&) const;
+	void resolveValues(const ValueDictionary&);
 };
 
 #endif /* REQUEST_H_ */
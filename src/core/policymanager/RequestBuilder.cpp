@@ -0,0 +1,176 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#include "RequestBuilder.h"
+#include "AuthorizationsSet.h"
+#include <cstring>
+
+const char* const request_group_names[REQ_GROUP_COUNT] = {
+	"resourceInfo", "subjectInfo", "widgetInfo", "deviceInfo", "environmentInfo"
+};
+
+const request_field request_fields[REQUEST_FIELD_COUNT] = {
+	{REQ_RESOURCE_INFO,		"deviceCap",						ATTR_DEVICE_CAP},
+	{REQ_RESOURCE_INFO,		"apiFeature",						ATTR_API_FEATURE},
+	{REQ_RESOURCE_INFO,		"serviceId",						ATTR_SERVICE_ID},
+	{REQ_RESOURCE_INFO,		"paramFeature",						ATTR_PARAM_FEATURE},
+	{REQ_SUBJECT_INFO,		"userId",							ATTR_USER_ID},
+	{REQ_SUBJECT_INFO,		"userKeyCn",						ATTR_USER_KEY_CN},
+	{REQ_SUBJECT_INFO,		"userKeyFingerprint",				ATTR_USER_KEY_FINGERPRINT},
+	{REQ_SUBJECT_INFO,		"userKeyRootCn",					ATTR_USER_KEY_ROOT_CN},
+	{REQ_SUBJECT_INFO,		"userKeyRootFingerprint",			ATTR_USER_KEY_ROOT_FINGERPRINT},
+	{REQ_WIDGET_INFO,		"id",								ATTR_ID},
+	{REQ_WIDGET_INFO,		"distributorKeyCn",					ATTR_DISTRIBUTOR_KEY_CN},
+	{REQ_WIDGET_INFO,		"distributorKeyFingerprint",		ATTR_DISTRIBUTOR_KEY_FINGERPRINT},
+	{REQ_WIDGET_INFO,		"distributorKeyRootCn",				ATTR_DISTRIBUTOR_KEY_ROOT_CN},
+	{REQ_WIDGET_INFO,		"distributorKeyRootFingerprint",	ATTR_DISTRIBUTOR_KEY_ROOT_FINGERPRINT},
+	{REQ_WIDGET_INFO,		"authorKeyCn",						ATTR_AUTHOR_KEY_CN},
+	{REQ_WIDGET_INFO,		"authorKeyFingerprint",				ATTR_AUTHOR_KEY_FINGERPRINT},
+	{REQ_WIDGET_INFO,		"authorKeyRootCn",					ATTR_AUTHOR_KEY_ROOT_CN},
+	{REQ_WIDGET_INFO,		"authorKeyRootFingerprint",			ATTR_AUTHOR_KEY_ROOT_FINGERPRINT},
+	{REQ_DEVICE_INFO,		"targetId",							ATTR_TARGET_ID},
+	{REQ_DEVICE_INFO,		"targetDomain",						ATTR_TARGET_DOMAIN},
+	{REQ_DEVICE_INFO,		"requestorId",						ATTR_REQUESTOR_ID},
+	{REQ_DEVICE_INFO,		"requestorDomain",					ATTR_REQUESTOR_DOMAIN},
+	{REQ_DEVICE_INFO,		"webinosEnabled",					ATTR_WEBINOS_ENABLED},
+	{REQ_ENVIRONMENT_INFO,	"profile",							ATTR_PROFILE},
+	{REQ_ENVIRONMENT_INFO,	"timemin",							ATTR_TIMEMIN},
+	{REQ_ENVIRONMENT_INFO,	"days-of-week",						ATTR_DAYS_OF_WEEK},
+	{REQ_ENVIRONMENT_INFO,	"days-of-month",					ATTR_DAYS_OF_MONTH},
+};
+
+// index of a field in request_fields, -1 if there is none
+int find_request_field(const string& group, const string& property){
+	for(unsigned int i = 0; i < REQUEST_FIELD_COUNT; i++){
+		if(property == request_fields[i].property && group == request_group_names[request_fields[i].group])
+			return i;
+	}
+	return -1;
+}
+
+/*
+ * Every subject attribute the policy can look at gets an entry, even
+ * when the request has no value for it, as every resource attribute
+ * does: that is what a request the policy matches against looks like.
+ */
+RequestBuilder::RequestBuilder(const AttributeReferences* refs, EvaluationArena* arena)
+	:request(arena ? new (*arena) Request() : new Request()), references(refs), arena(arena)
+{
+	for(unsigned int i = 0; i < ATTR_ROAMING; i++)
+		slots[i] = attribute_referenced(references, i) ? request->addAttr((AttributeId) i) : NULL;
+}
+
+RequestBuilder::~RequestBuilder(){
+	release(request, arena);
+}
+
+// frees a request built with arena (NULL for one on the heap)
+void RequestBuilder::release(Request* req, EvaluationArena* arena){
+	if(arena == NULL)
+		delete req;
+	else if(req != NULL)
+		req->~Request();
+}
+
+bool RequestBuilder::wants(unsigned int field) const{
+	return attribute_referenced(references, request_fields[field].attr);
+}
+
+// room for the next value of an attribute, NULL if it is not kept
+char* RequestBuilder::value(AttributeId attr, size_t length){
+	if(!attribute_referenced(references, attr))
+		return NULL;
+	if(attr >= ATTR_ROAMING)
+		return request->setEnvironmentAttr(attr, length);
+	return request->addValue(slots[attr], length);
+}
+
+char* RequestBuilder::add(unsigned int field, size_t length){
+	return value(request_fields[field].attr, length);
+}
+
+// for callers reading requests some other way than through V8, e.g. JSON
+bool RequestBuilder::add(const string& group, const string& property, const string& value){
+	int field = find_request_field(group, property);
+	if(field < 0)
+		return false;
+	char* room = add(field, value.size());
+	if(room != NULL)
+		memcpy(room, value.data(), value.size());
+	return true;
+}
+
+// purposes and obligations are moved to the request, which the caller now owns
+Request* RequestBuilder::build(vector<bool>& purpose, obligations& obl){
+	Request* result = request;
+	request = NULL;
+	result->trimValues();
+	result->getPurposeAttrs().swap(purpose);
+	result->getObligationsAttrs().swap(obl);
+	return result;
+}
+
+/*
+ * Request from its binary encoding, NULL if the data is not one. Values
+ * end at their first NUL, as those read from JS strings do; purposes
+ * default to all of them, as for a JS request without "purpose".
+ */
+Request* RequestBuilder::decode(const unsigned char* data, size_t length, const AttributeReferences* refs,
+		EvaluationArena* arena){
+	if(length == 0 || data[0] != REQUEST_ENCODING_VERSION)
+		return NULL;
+
+	RequestBuilder builder(refs, arena);
+	vector<bool> purpose(arraysize(ontology_vector), true);
+	size_t pos = 1;
+	while(pos < length){
+		unsigned int attr = data[pos++];
+		size_t size = 0;
+		for(unsigned int shift = 0; ; shift += 7){
+			if(pos >= length || shift > 28)
+				return NULL;
+			unsigned char byte = data[pos++];
+			size |= (size_t) (byte & 0x7F) << shift;
+			if((byte & 0x80) == 0)
+				break;
+		}
+		if(size > length - pos)
+			return NULL;
+		const char* bytes = (const char*) data + pos;
+		pos += size;
+
+		if(attr == REQUEST_PURPOSE){
+			// as for a JS purpose array of the wrong length
+			purpose.clear();
+			if(size == arraysize(ontology_vector)){
+				for(size_t i = 0; i < size; i++)
+					purpose.push_back(bytes[i] != 0);
+			}
+		}
+		else if(attr < ATTR_COUNT){
+			char* room = builder.value((AttributeId) attr, size);
+			if(room != NULL)
+				memcpy(room, bytes, size);
+		}
+		else
+			return NULL;
+	}
+	obligations obl;
+	return builder.build(purpose, obl);
+}
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#ifndef REQUESTBUILDER_H_
+#define REQUESTBUILDER_H_
+
+#include "Request.h"
+#include "EvaluationArena.h"
+#include <string>
+#include <vector>
+using namespace std;
+
+// objects of a JS (or JSON) request holding its attributes
+enum RequestGroup {REQ_RESOURCE_INFO, REQ_SUBJECT_INFO, REQ_WIDGET_INFO, REQ_DEVICE_INFO,
+	REQ_ENVIRONMENT_INFO, REQ_GROUP_COUNT};
+
+// a property of one of those objects, and the attribute it is read into
+typedef struct {
+	RequestGroup	group;
+	const char*		property;
+	AttributeId		attr;
+} request_field;
+
+const unsigned int REQUEST_FIELD_COUNT = 27;
+
+extern const char* const request_group_names[REQ_GROUP_COUNT];
+// ordered by group
+extern const request_field request_fields[REQUEST_FIELD_COUNT];
+
+int find_request_field(const string& group, const string& property);
+
+/*
+ * Binary request encoding (see lib/requestEncoder.js): a version byte,
+ * then records made of an attribute byte (AttributeId, or
+ * REQUEST_PURPOSE), a LEB128 length and that many bytes of value. An
+ * attribute may repeat; a purpose record holds one byte (0 or 1) per
+ * purpose of the ontology. Obligations cannot be encoded.
+ */
+const unsigned char REQUEST_ENCODING_VERSION = 1;
+const unsigned char REQUEST_PURPOSE = 0xFF;
+
+/*
+ * Fills a new Request with the attribute values of a request, field by
+ * field. Values only go to the attributes in the references given (all
+ * of them if NULL): subject and resource attributes are added for these
+ * only, and wants() tells the caller which fields it can skip reading at
+ * all. Values are written straight into the arena of the request and end
+ * at their first NUL.
+ * With an EvaluationArena the request itself is placed there, and must be
+ * given back with release() before the arena is rewound.
+ */
+class RequestBuilder
+	{
+
+private:
+	Request*						request;
+	const AttributeReferences*		references;
+	EvaluationArena*				arena;
+	request_attr*					slots[ATTR_ROAMING];	// NULL if not kept
+
+	RequestBuilder(const RequestBuilder&);
+	RequestBuilder& operator=(const RequestBuilder&);
+
+public:
+	RequestBuilder(const AttributeReferences*, EvaluationArena* arena = NULL);
+	virtual ~RequestBuilder();
+
+	bool wants(unsigned int field) const;
+	char* value(AttributeId, size_t length);
+	char* add(unsigned int field, size_t length);
+	bool add(const string& group, const string& property, const string& value);
+	Request* build(vector<bool>& purpose, obligations&);
+
+	static Request* decode(const unsigned char*, size_t, const AttributeReferences*, EvaluationArena* arena = NULL);
+	static void release(Request*, EvaluationArena*);
+	};
+
+#endif /* REQUESTBUILDER_H_ */
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+#include "ResourceIndex.h"
+#include <algorithm>
+
+ResourceIndex::ResourceIndex()
+	:features(ATTR_API_FEATURE), capabilities(ATTR_DEVICE_CAP), anyCapabilities(false)
+{
+}
+
+ResourceIndex::~ResourceIndex() {
+}
+
+// rule is a candidate when the request contains any of the literals
+void ResourceIndex::add(const vector<string>& featureLiterals,
+		const vector<string>& capabilityLiterals, unsigned int rule) {
+	features.add(featureLiterals, rule);
+	if (!capabilityLiterals.empty()) {
+		capabilities.add(capabilityLiterals, rule);
+		anyCapabilities = true;
+	}
+}
+
+void ResourceIndex::addOther(unsigned int rule) {
+	others.push_back(rule);
+}
+
+void ResourceIndex::build() {
+	features.build();
+	capabilities.build();
+	sort(others.begin(), others.end());
+}
+
+// rules indexed by literal
+unsigned int ResourceIndex::size() const {
+	return features.size();
+}
+
+/*
+ * Sorted candidate rules of req, at most max of them; returns their
+ * number, or max + 1 if there are more or the index cannot tell.
+ */
+unsigned int ResourceIndex::lookup(const Request* req, unsigned int* rules, unsigned int max) const {
+	const request_attr* values = req->getResourceAttr(ATTR_API_FEATURE);
+
+	if (values == NULL || (anyCapabilities && req->getResourceAttr(ATTR_DEVICE_CAP) == NULL))
+		return max + 1;
+	unsigned int count = features.collect(values, rules, 0, max);
+	for (const request_attr* a = req->getResources(); anyCapabilities && a != NULL && count <= max; a = a->next) {
+		if (a->attr != ATTR_API_FEATURE)
+			count = capabilities.collect(a, rules, count, max);
+	}
+	if (count > max || others.size() > max - count)
+		return max + 1;
+	for (unsigned int i = 0; i < others.size(); i++)
+		rules[count++] = others[i];
+	sort(rules, rules + count);
+	return count;
+}
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+
+#ifndef RESOURCEINDEX_H_
+#define RESOURCEINDEX_H_
+
+#include "SubjectIndex.h"
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+ * Candidate rules of a policy, found from the resources of a request.
+ * A rule is indexed under literals one of which the request must contain
+ * for its condition to match (see Condition::resourceLiterals): feature
+ * literals are searched for in the api-feature values, capability literals
+ * in the other resource values. Rules without a condition, or with one
+ * that cannot be indexed, are candidates for any request; so are all
+ * rules of a request without api-feature, or without device-cap when
+ * there are capability literals, as their conditions are then not
+ * decided by the match values alone.
+ */
+class ResourceIndex
+	{
+
+private:
+	SubjectIndex			features;
+	SubjectIndex			capabilities;
+	vector<unsigned int>	others;			// rules not indexed, sorted
+	bool					anyCapabilities;
+
+public:
+	ResourceIndex();
+	virtual ~ResourceIndex();
+
+	void add(const vector<string>& features, const vector<string>& capabilities, unsigned int rule);
+	void addOther(unsigned int rule);
+	void build();
+
+	unsigned int size() const;
+	unsigned int lookup(const Request*, unsigned int* rules, unsigned int max) const;
+	};
+
+#endif /* RESOURCEINDEX_H_ */
@@ -0,0 +1,230 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#include "RootPolicyManager.h"
+#include "../../debug.h"
+#include <fstream>
+#include <sstream>
+
+// name of the entity standing for the per-application policy files
+#define APP_ENTITY "app"
+
+/*
+ * Combination of the result so far (row) with the next one (column),
+ * indexed by Effect; the same tables as LUT_do and LUT_dupop in
+ * lib/rootPm.js.
+ */
+static const int ROOT_LUT[2][7][7] = {
+	// Deny-overrides
+	{
+		{0, 1, 2, 3, 4, 5, 0},
+		{1, 1, 1, 1, 1, 1, 1},
+		{2, 1, 2, 2, 2, 5, 2},
+		{3, 1, 2, 3, 3, 5, 3},
+		{4, 1, 2, 3, 4, 5, 4},
+		{5, 5, 5, 5, 5, 5, 5},
+		{0, 1, 2, 3, 4, 5, 6},
+	},
+	// Deny-unless-permit-or-prompt
+	{
+		{0, 1, 2, 3, 4, 1, 0},
+		{1, 1, 1, 1, 1, 1, 1},
+		{2, 1, 2, 2, 2, 1, 2},
+		{3, 1, 2, 3, 3, 1, 3},
+		{4, 1, 2, 3, 4, 1, 4},
+		{1, 1, 1, 1, 1, 1, 1},
+		{0, 1, 2, 3, 4, 1, 6},
+	},
+};
+
+// as path.join(path.dirname(rootFile), file) for the relative names of the entities
+static string includedPath(const string& rootFile, string file){
+	size_t slash = rootFile.find_last_of('/');
+	while(file.compare(0, 2, "./") == 0)
+		file = file.substr(2);
+	if(slash == string::npos)
+		return file;
+	return rootFile.substr(0, slash + 1) + file;
+}
+
+RootPolicyManager::RootPolicyManager(const string& fileName)
+	:rootFileName(fileName), root(0)
+{
+	LOGD("Root policy manager file : %s", rootFileName.c_str());
+	if(!load())
+		LOGD("[RootPolicyManager] Root policy not loaded");
+}
+
+RootPolicyManager::~RootPolicyManager() {
+	freeNode(root);
+}
+
+/*
+ * The DTD is read by hand, as lib/rootPm.js does: entities are
+ * "<!ENTITY name SYSTEM file>" with file relative to the root policy.
+ * References to them are turned into <extfile>name</extfile> elements
+ * and the rest is parsed as plain XML.
+ */
+bool RootPolicyManager::load(){
+	ifstream in(rootFileName.c_str());
+	if(!in)
+		return false;
+	stringstream buffer;
+	buffer << in.rdbuf();
+	string text = buffer.str();
+
+	size_t doctype = text.find("<!DOCTYPE");
+	if(doctype != string::npos){
+		size_t open = text.find('[', doctype);
+		size_t close = (open == string::npos) ? string::npos : text.find(']', open);
+		size_t end = text.find('>', (close == string::npos) ? doctype : close);
+		if(end == string::npos)
+			return false;
+		if(close != string::npos){
+			string dtd = text.substr(open + 1, close - open - 1);
+			size_t entity = dtd.find("<!ENTITY");
+			while(entity != string::npos){
+				size_t entityEnd = dtd.find('>', entity);
+				if(entityEnd == string::npos)
+					break;
+				string name, system, file;
+				istringstream decl(dtd.substr(entity + 8, entityEnd - entity - 8));
+				decl >> name >> system >> file;
+				if(file.size() > 1 && (file[0] == '"' || file[0] == '\'') && file[file.size() - 1] == file[0])
+					file = file.substr(1, file.size() - 2);
+				if(!name.empty() && !file.empty()){
+					includedFiles[name] = includedPath(rootFileName, file);
+					LOGD("[RootPolicyManager] %s is %s", name.c_str(), includedFiles[name].c_str());
+				}
+				entity = dtd.find("<!ENTITY", entityEnd);
+			}
+		}
+		text = text.substr(0, doctype) + text.substr(end + 1);
+	}
+
+	for(size_t amp = text.find('&'); amp != string::npos; amp = text.find('&', amp + 1)){
+		size_t semicolon = text.find(';', amp);
+		if(semicolon == string::npos)
+			break;
+		string name = text.substr(amp + 1, semicolon - amp - 1);
+		if(includedFiles.find(name) != includedFiles.end())
+			text.replace(amp, semicolon - amp + 1, "<extfile>" + name + "</extfile>");
+	}
+
+	TiXmlDocument doc;
+	doc.Parse(text.c_str());
+	TiXmlElement* element = doc.RootElement();
+	if(doc.Error() || element == NULL || element->ValueStr() != "policy-set"){
+		LOGD("[RootPolicyManager] Root policy parse error: %s", doc.ErrorDesc());
+		return false;
+	}
+	root = parseNode(element);
+	return true;
+}
+
+RootPolicyNode* RootPolicyManager::parseNode(TiXmlElement* element){
+	RootPolicyNode* node = new RootPolicyNode();
+	const char* algorithm = element->Attribute("combining-algorithm");
+
+	node->algorithm = ROOT_NO_ALGORITHM;
+	if(algorithm != NULL && string(algorithm) == "Deny-overrides")
+		node->algorithm = ROOT_DENY_OVERRIDES;
+	else if(algorithm != NULL && string(algorithm) == "Deny-unless-permit-or-prompt")
+		node->algorithm = ROOT_DENY_UNLESS_PERMIT_OR_PROMPT;
+
+	for(TiXmlElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement()){
+		if(child->ValueStr() == "policy-set")
+			node->policysets.push_back(parseNode(child));
+		else if(child->ValueStr() == "extfile" && child->GetText() != NULL)
+			node->extfiles.push_back(child->GetText());
+	}
+	return node;
+}
+
+void RootPolicyManager::freeNode(RootPolicyNode* node){
+	if(node == NULL)
+		return;
+	for(unsigned int i = 0; i < node->policysets.size(); i++)
+		freeNode(node->policysets[i]);
+	delete node;
+}
+
+PolicyManager* RootPolicyManager::getManager(const string& name){
+	map<string, PolicyManager* const*>::iterator it = managers.find(name);
+	return (it != managers.end()) ? *it->second : NULL;
+}
+
+// policy of the requesting application, if one was set for its id
+PolicyManager* RootPolicyManager::getAppManager(const Request* req){
+	const request_attr* id = req->getSubjectAttr(ATTR_ID);
+	if(id == NULL || id->count == 0 || id->values[0].length == 0)
+		return NULL;
+
+	map<string, PolicyManager* const*>::iterator it = appManagers.find(string(id->values[0].data, id->values[0].length));
+	return (it != appManagers.end()) ? *it->second : NULL;
+}
+
+Effect RootPolicyManager::evaluate(const RootPolicyNode* node, Request* req){
+	int res = INAPPLICABLE;
+
+	if(node->algorithm != ROOT_NO_ALGORITHM){
+		const int (*lut)[7] = ROOT_LUT[node->algorithm];
+		for(unsigned int i = 0; i < node->policysets.size(); i++)
+			res = lut[res][evaluate(node->policysets[i], req)];
+		for(unsigned int i = 0; i < node->extfiles.size(); i++){
+			PolicyManager* pm = (node->extfiles[i] == APP_ENTITY) ? getAppManager(req) : getManager(node->extfiles[i]);
+			Effect effect = pm ? pm->checkRequest(req) : INAPPLICABLE;
+			res = lut[res][effect];
+		}
+	}
+	// Deny-unless-permit-or-prompt turns undetermined and inapplicable into deny
+	if(node->algorithm == ROOT_DENY_UNLESS_PERMIT_OR_PROMPT && res > PROMPT_BLANKET)
+		res = DENY;
+	return (Effect) res;
+}
+
+bool RootPolicyManager::isValid() const{
+	return root != NULL;
+}
+
+// manager of the included file "name", NULL to remove it
+void RootPolicyManager::setManager(const string& name, PolicyManager* const* pm){
+	if(pm == NULL)
+		managers.erase(name);
+	else
+		managers[name] = pm;
+}
+
+// manager of the "app" file of application appId, NULL to remove it
+void RootPolicyManager::setAppManager(const string& appId, PolicyManager* const* pm){
+	if(pm == NULL)
+		appManagers.erase(appId);
+	else
+		appManagers[appId] = pm;
+}
+
+Effect RootPolicyManager::checkRequest(Request* req){
+	if(root == NULL)
+		return INAPPLICABLE;
+	return evaluate(root, req);
+}
+
+const map<string, string>& RootPolicyManager::getIncludedFiles() const{
+	return includedFiles;
+}
@@ -0,0 +1,85 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#ifndef ROOTPOLICYMANAGER_H_
+#define ROOTPOLICYMANAGER_H_
+
+#include "PolicyManager.h"
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+// combining algorithms of the root policy-set, indexes of the root LUTs
+const int ROOT_NO_ALGORITHM = -1;
+const int ROOT_DENY_OVERRIDES = 0;
+const int ROOT_DENY_UNLESS_PERMIT_OR_PROMPT = 1;
+
+/*
+ * policy-set element of the root policy: nested policy-sets first, then
+ * the included policy files, referenced by entity name.
+ */
+typedef struct RootPolicyNode {
+	int						algorithm;
+	vector<RootPolicyNode*>	policysets;
+	vector<string>			extfiles;
+} RootPolicyNode;
+
+/*
+ * Root policy (rootPolicy.xml): a policy-set tree whose leaves are the
+ * policy files included as DTD entities, e.g.
+ *   <!ENTITY user SYSTEM ./policy.xml>  ...  &user;
+ * The policy managers of the included files are not loaded here: they
+ * are set by whoever checked the files (lib/rootPm.js runs the schema
+ * check), and "app" stands for the manager set for the "id" subject
+ * attribute of the request. Each one is given as the address of the
+ * pointer to the manager in use, read on every request, so a manager
+ * reloaded in place is picked up. None of them is owned. Results are
+ * combined with the same LUTs as lib/rootPm.js, so a decision is a
+ * single checkRequest call.
+ */
+class RootPolicyManager
+	{
+
+private:
+	string								rootFileName;
+	RootPolicyNode*						root;
+	map<string, string>					includedFiles;		// entity name -> policy file
+	map<string, PolicyManager* const*>	managers;			// by entity name, except "app"
+	map<string, PolicyManager* const*>	appManagers;		// by application id
+
+	bool load();
+	RootPolicyNode* parseNode(TiXmlElement*);
+	void freeNode(RootPolicyNode*);
+	PolicyManager* getManager(const string&);
+	PolicyManager* getAppManager(const Request*);
+	Effect evaluate(const RootPolicyNode*, Request*);
+
+public:
+	RootPolicyManager(const string&);
+	virtual ~RootPolicyManager();
+
+	bool isValid() const;
+	void setManager(const string&, PolicyManager* const*);
+	void setAppManager(const string&, PolicyManager* const*);
+	Effect checkRequest(Request*);
+	const map<string, string>& getIncludedFiles() const;
+	};
+
+#endif /* ROOTPOLICYMANAGER_H_ */
@@ -37,13 +37,13 @@ private:
 	DHPrefs*			datahandlingpreferences;
 	vector<ProvisionalActions*>		provisionalactions;
 
+	friend class PolicyProgram;
 	
 public:
 	string id;
 	Rule(TiXmlElement*, DHPrefs*);
 	virtual ~Rule();
 	
-	Effect evaluate(Request*, pair<string, bool>*);
 	static Effect string2effect(const string &);
 	
 	};
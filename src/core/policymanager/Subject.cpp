@@ -44,6 +44,7 @@ Subject::Subject(TiXmlElement* subject, map<string, vector<string>*> *pip){
 				tmp_info->value = tmp.substr(pos, nextPos-pos);
 				
 				tmp_info->mod_func = (dot_pos != (int)string::npos) ? attr.substr(dot_pos+1) : "";
+				tmp_info->predicate = PREDICATE_NONE;
 				LOGD("subject() %d - equal_func=%s, value=%s, mod_func=%s", pos, tmp_info->equal_func.data(), tmp_info->value.data(), tmp_info->mod_func.data());
 
 				if (pip !=NULL)
@@ -75,12 +76,25 @@ Subject::Subject(TiXmlElement* subject, map<string, vector<string>*> *pip){
 					}
 				}
 
+				int mode = string2strcmp_mode(tmp_info->equal_func);
+				vector<StringView> bagVector = split(tmp_info->value, ',');
+				tmp_info->matchers.resize(bagVector.size());
+				for (unsigned int i = 0; i < bagVector.size(); i++)
+					compile_match_expr(tmp_info->matchers[i], bagVector[i].str(), mode);
+
 				info[key].push_back(tmp_info);
 			}
 			pos = nextPos+1;
 		}
 	}
 	LOGD("[Subject]  : subjects-match size : %lu",info.size());
+	for(map<string,vector<match_info_str*> >::iterator it = info.begin(); it != info.end(); it++){
+		attribute_match m;
+		m.attr = string2attribute(it->first);
+		m.name = it->first;
+		m.matches = it->second;
+		attrs.push_back(m);
+	}
 }
 
 Subject::~Subject()
@@ -88,44 +102,97 @@ Subject::~Subject()
 	// TODO Auto-generated destructor stub
 	}
 
-bool Subject::match(Request* req){
-	bool foundInBag = false;
-	for(map<string,vector<match_info_str*> >::iterator it_policy=info.begin(); it_policy != info.end(); it_policy++){
-		 
-		// For Debug
-		LOGD("[Subject] cerco in %s ",it_policy->first.data());
-		for(map<string,vector<string>* >::iterator it=req->getSubjectAttrs().begin(); it != req->getSubjectAttrs().end(); it++)
-			LOGD("[Subject] req %s",it->first.data());
+bool Subject::match(const Request* req, PredicateMemo* memo){
+	for(unsigned int k = 0; k < attrs.size(); k++){
+		const attribute_match& policy_attr = attrs[k];
+		LOGD("[Subject] cerco in %s ",policy_attr.name.data());
 		
+		const request_attr* req_attr = (policy_attr.attr != ATTR_UNKNOWN)
+			? req->getSubjectAttr(policy_attr.attr)
+			: req->getSubjectAttr(policy_attr.name);
+		if(req_attr == NULL)
+			return false;
 		
-		if(req->getSubjectAttrs().find(it_policy->first) != req->getSubjectAttrs().end()){
-			vector<string>* req_vet = req->getSubjectAttrs()[it_policy->first];
-			vector<match_info_str*> info_vet = it_policy->second;		
-			for(unsigned int j=0;j<info_vet.size(); j++){ //iteration on all policy's elements
-				foundInBag = false;
-				for(unsigned int i=0; !foundInBag && i<req_vet->size(); i++){ //iteration on request's elements. 
-					string mod_function = info_vet[j]->mod_func;
-					LOGD("Subject.match() - mod_function=%s - req_vet=%s", mod_function.data(), req_vet->at(i).data());
-
-                    vector<string> bagVector = split(info_vet[j]->value.data(), ',');
-
-                    for(vector<string>::iterator it_bag = bagVector.begin(); it_bag != bagVector.end(); it_bag++) {
-						string s = (mod_function != "") 
-							? modFunction(mod_function, req_vet->at(i))
-							: req_vet->at(i);
-						LOGD("[Subject] Compare %s with %s ",s.data(),it_bag->data());
-						if(equals(s, it_bag->data(), string2strcmp_mode(info_vet[j]->equal_func))){
-							foundInBag = true;
-							LOGD("[Subject] Found subject-match for %s ",s.data());
-						}
-					}
-				}
-				if(!foundInBag)
+		const vector<match_info_str*>& info_vet = policy_attr.matches;
+		for(unsigned int j=0;j<info_vet.size(); j++){ //iteration on all policy's elements
+			int known = memo ? memo->get(info_vet[j]->predicate) : -1;
+			if(known >= 0){
+				if(known == 0)
 					return false;
+				continue;
 			}
+			bool foundInBag = matchAnyValue(info_vet[j], *req_attr);
+			LOGD("[Subject] Compare with %s: %d",info_vet[j]->value.data(),foundInBag);
+			if(memo)
+				memo->set(info_vet[j]->predicate, foundInBag);
+			if(!foundInBag)
+				return false;
 		}
-		else
+	}
+	return true;
+}
+
+// as above, from the results of all the predicates of the policy
+bool Subject::match(const PredicateVector& results) const{
+	for(unsigned int i = 0; i < mask.size(); i++){
+		if((results.matched[mask[i].word] & mask[i].bits) != mask[i].bits)
 			return false;
 	}
 	return true;
 }
+
+void Subject::intern(ValueDictionary& dictionary){
+	for(map<string,vector<match_info_str*> >::iterator it = info.begin(); it != info.end(); it++){
+		for(unsigned int j = 0; j < it->second.size(); j++){
+			match_info_str* m = it->second[j];
+			// values reduced by a function are never resolved
+			if(m->mod_func != "")
+				continue;
+			for(unsigned int i = 0; i < m->matchers.size(); i++)
+				dictionary.intern(m->matchers[i]);
+		}
+	}
+}
+
+void Subject::intern(PredicateTable& predicates){
+	for(unsigned int k = 0; k < attrs.size(); k++){
+		const vector<match_info_str*>& matches = attrs[k].matches;
+		for(unsigned int j = 0; j < matches.size(); j++){
+			matches[j]->predicate = predicates.add(PREDICATE_SUBJECT, attrs[k].attr, attrs[k].name, matches[j]);
+			PredicateTable::appendMask(mask, matches[j]->predicate);
+		}
+	}
+}
+
+/* Literals one of which some value of attr must contain for the subject
+ * to match, false if the subject does not restrict attr that way; a value
+ * reduced by a URI function is a part of the request value.
+ * */
+bool Subject::literals(int attr, vector<string>& out) const{
+	for(unsigned int k = 0; k < attrs.size(); k++){
+		if(attrs[k].attr != attr)
+			continue;
+		const vector<match_info_str*>& matches = attrs[k].matches;
+		for(unsigned int j = 0; j < matches.size(); j++){
+			const vector<match_expr>& matchers = matches[j]->matchers;
+			vector<string> found(matchers.size());
+			unsigned int i = 0;
+			while(i < matchers.size() && match_literal(matchers[i], found[i]))
+				i++;
+			if(i == matchers.size() && i > 0){
+				out.insert(out.end(), found.begin(), found.end());
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void Subject::collectReferences(AttributeReferences& refs){
+	for(unsigned int k = 0; k < attrs.size(); k++){
+		if(attrs[k].attr != ATTR_UNKNOWN)
+			refs.subjects[attrs[k].attr] = true;
+		else if(!contains(refs.otherSubjects, attrs[k].name))
+			refs.otherSubjects.push_back(attrs[k].name);
+	}
+}
@@ -22,6 +22,7 @@
 
 #include "../../core/policymanager/Request.h"
 #include "../../core/common.h"
+#include "PredicateTable.h"
 #include <map>
 #include <string>
 #include <vector>
@@ -30,25 +31,24 @@
 
 using namespace std;
 
-typedef struct {
-	string equal_func;
-//	string match;
-	string value;
-	string mod_func;
-} match_info_str;
-
-
 class Subject
 	{
 	
 private:
 	map<string,vector<match_info_str*> > info;
+	vector<attribute_match> attrs;
+	vector<PredicateMask> mask;		// predicates that all have to match
 	
 public:
 	Subject(TiXmlElement*, map<string, vector<string>*> *);
 	virtual ~Subject();
 	
-	bool match(Request*);
+	bool match(const Request*, PredicateMemo* memo = NULL);
+	bool match(const PredicateVector&) const;
+	void intern(ValueDictionary&);
+	void intern(PredicateTable&);
+	void collectReferences(AttributeReferences&);
+	bool literals(int attr, vector<string>& out) const;
 	};
 
 #endif /* SUBJECT_H_ */
@@ -0,0 +1,141 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+#include "SubjectIndex.h"
+#include <algorithm>
+
+SubjectIndex::SubjectIndex(int attr)
+	:attr(attr), states(1), indexed(0)
+{
+	states[0].fail = 0;
+}
+
+SubjectIndex::~SubjectIndex() {
+}
+
+// child is a candidate when a value contains any of literals, none empty
+void SubjectIndex::add(const vector<string>& literals, unsigned int child) {
+	for (unsigned int i = 0; i < literals.size(); i++) {
+		unsigned int s = 0;
+		for (unsigned int j = 0; j < literals[i].size(); j++) {
+			unsigned char c = literals[i][j];
+			vector< pair<unsigned char, unsigned int> >& next = states[s].next;
+			vector< pair<unsigned char, unsigned int> >::iterator it =
+					lower_bound(next.begin(), next.end(), make_pair(c, 0U));
+			if (it != next.end() && it->first == c) {
+				s = it->second;
+				continue;
+			}
+			unsigned int created = states.size();
+			next.insert(it, make_pair(c, created));
+			states.push_back(State());
+			states[created].fail = 0;
+			s = created;
+		}
+		states[s].children.push_back(child);
+	}
+	indexed++;
+}
+
+void SubjectIndex::addOther(unsigned int child) {
+	others.push_back(child);
+}
+
+// fail links, breadth first, each state also reporting what its fail state does
+void SubjectIndex::build() {
+	vector<unsigned int> queue;
+
+	for (unsigned int i = 0; i < states[0].next.size(); i++)
+		queue.push_back(states[0].next[i].second);
+	for (unsigned int q = 0; q < queue.size(); q++) {
+		unsigned int s = queue[q];
+		State& state = states[s];
+		vector<unsigned int>& inherited = states[state.fail].children;
+		state.children.insert(state.children.end(), inherited.begin(), inherited.end());
+		sort(state.children.begin(), state.children.end());
+		state.children.erase(unique(state.children.begin(), state.children.end()), state.children.end());
+		for (unsigned int i = 0; i < state.next.size(); i++) {
+			unsigned int child = state.next[i].second;
+			states[child].fail = (s == 0) ? 0 : step(state.fail, state.next[i].first);
+			queue.push_back(child);
+		}
+	}
+	sort(others.begin(), others.end());
+}
+
+unsigned int SubjectIndex::step(unsigned int s, unsigned char c) const {
+	for (;;) {
+		const vector< pair<unsigned char, unsigned int> >& next = states[s].next;
+		vector< pair<unsigned char, unsigned int> >::const_iterator it =
+				lower_bound(next.begin(), next.end(), make_pair(c, 0U));
+		if (it != next.end() && it->first == c)
+			return it->second;
+		if (s == 0)
+			return 0;
+		s = states[s].fail;
+	}
+}
+
+int SubjectIndex::getAttr() const {
+	return attr;
+}
+
+// children indexed by literal
+unsigned int SubjectIndex::size() const {
+	return indexed;
+}
+
+const vector<unsigned int>& SubjectIndex::getOthers() const {
+	return others;
+}
+
+/*
+ * Sorted indexed children some value of values contains a literal of,
+ * at most max of them; returns their number, or max + 1 if there are
+ * more. NULL values (attribute not in the request) have none.
+ */
+unsigned int SubjectIndex::lookup(const request_attr* values, unsigned int* hits, unsigned int max) const {
+	unsigned int count = collect(values, hits, 0, max);
+
+	if (count <= max)
+		sort(hits, hits + count);
+	return count;
+}
+
+// as lookup, adding to the count hits already found, unsorted
+unsigned int SubjectIndex::collect(const request_attr* values, unsigned int* hits, unsigned int count, unsigned int max) const {
+	for (unsigned int v = 0; values != NULL && v < values->count; v++) {
+		const request_value& value = values->values[v];
+		unsigned int s = 0;
+		for (size_t i = 0; i < value.length; i++) {
+			s = step(s, value.data[i]);
+			const vector<unsigned int>& children = states[s].children;
+			for (unsigned int k = 0; k < children.size(); k++) {
+				unsigned int* end = hits + count;
+				if (find(hits, end, children[k]) != end)
+					continue;
+				if (count == max)
+					return max + 1;
+				hits[count++] = children[k];
+			}
+		}
+	}
+	return count;
+}
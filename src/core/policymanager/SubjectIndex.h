@@ -0,0 +1,72 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+#ifndef SUBJECTINDEX_H_
+#define SUBJECTINDEX_H_
+
+#include "Request.h"
+#include <string>
+#include <vector>
+using namespace std;
+
+/*
+ * Candidate children of a first-matching-target node, found from the
+ * values of one subject attribute. A child is indexed under literals one
+ * of which a value of the attribute must contain for the child's target
+ * to match (see Subject::literals); the literals are searched for all at
+ * once, Aho-Corasick style, in a single pass over each value. Children
+ * that cannot be indexed are kept apart and are candidates for any
+ * request. Candidates still have to be matched: the index only tells
+ * which children cannot. The same search serves the resource literals of
+ * rules, see ResourceIndex.
+ */
+class SubjectIndex
+	{
+
+private:
+	typedef struct {
+		vector< pair<unsigned char, unsigned int> >	next;		// sorted by character
+		unsigned int								fail;		// longest proper suffix in the trie
+		vector<unsigned int>						children;	// of the literals ending here, sorted
+	} State;
+
+	int						attr;			// AttributeId of the subject attribute
+	vector<State>			states;			// states[0] is the root
+	vector<unsigned int>	others;			// children not indexed, sorted
+	unsigned int			indexed;
+
+	unsigned int step(unsigned int state, unsigned char c) const;
+
+public:
+	SubjectIndex(int attr);
+	virtual ~SubjectIndex();
+
+	void add(const vector<string>& literals, unsigned int child);
+	void addOther(unsigned int child);
+	void build();
+
+	int getAttr() const;
+	unsigned int size() const;
+	const vector<unsigned int>& getOthers() const;
+	unsigned int lookup(const request_attr*, unsigned int* hits, unsigned int max) const;
+	unsigned int collect(const request_attr*, unsigned int* hits, unsigned int count, unsigned int max) const;
+	};
+
+#endif /* SUBJECTINDEX_H_ */
@@ -114,7 +114,16 @@ TriggersSet::TriggersSet(TiXmlElement* triggersset){
 TriggersSet::~TriggersSet(){
 }
 
-bool TriggersSet::evaluate(vector< map<string, string> > trig){
+// gmtime() shares a static buffer between threads
+static void utcTime(time_t t, struct tm& result){
+#ifdef _WIN32
+	gmtime_s(&result, &t);
+#else
+	gmtime_r(&t, &result);
+#endif
+}
+
+bool TriggersSet::evaluate(const vector< map<string, string> >& trig) const{
 	bool purpose_satisfied, trigger_satisfied;
 	struct tm start1, start2, delay1, delay2;
 	time_t t_start1, t_start2, t_delay1, t_delay2;
@@ -122,18 +131,18 @@ bool TriggersSet::evaluate(vector< map<string, string> > trig){
 	int millisec, off_hour1, off_min1, off_hour2, off_min2;
 
 	// loop among user triggers
-	for(vector< map<string, string> >::iterator triggers_it=triggers.begin() ; triggers_it!=triggers.end() ; triggers_it++){
+	for(vector< map<string, string> >::const_iterator triggers_it=triggers.begin() ; triggers_it!=triggers.end() ; triggers_it++){
 		trigger_satisfied = false;
 		// loop among application triggers
-		for(vector< map<string, string> >::iterator it=trig.begin() ; it!=trig.end() ; it++){
+		for(vector< map<string, string> >::const_iterator it=trig.begin() ; it!=trig.end() ; it++){
 
 			// TriggerAtTime evaluation
-			if((*triggers_it)[triggerIdTag] == (*it)[triggerIdTag] && (*triggers_it)[triggerIdTag] == triggerAtTimeTag){
+			if(mapValue(*triggers_it, triggerIdTag) == mapValue(*it, triggerIdTag) && mapValue(*triggers_it, triggerIdTag) == triggerAtTimeTag){
 				LOGD("TriggerAtTime evaluation");
 
 				// Start is StartNow or is the same time
 				// MaxDelay from DHPref is greter or equal of application MaxDelay
-				if ((*triggers_it)[startTag] == (*it)[startTag] && (*triggers_it)[maxDelayTag] >= (*it)[maxDelayTag]){
+				if (mapValue(*triggers_it, startTag) == mapValue(*it, startTag) && mapValue(*triggers_it, maxDelayTag) >= mapValue(*it, maxDelayTag)){
 					LOGD("TriggerAtTime evaluation: Start is StartNow or is the same time");
 					trigger_satisfied = true;
 					break;
@@ -141,22 +150,22 @@ bool TriggersSet::evaluate(vector< map<string, string> > trig){
 
 				// Dafault case
 				// Application time interval must be inside DHPref time interval
-				if ((*triggers_it)[startTag] != (*it)[startTag]){
+				if (mapValue(*triggers_it, startTag) != mapValue(*it, startTag)){
 					LOGD("TriggerAtTime evaluation: default case");
 
 					// user start time
-					if ((*triggers_it)[startTag] == startNowTag) {
+					if (mapValue(*triggers_it, startTag) == startNowTag) {
 						LOGD("TriggerAtTime evaluation: user current start time");
 						if (time(&t_start1) == -1) {
 							LOGD("Error on user Start");
 							trigger_satisfied = false;
 							break;
 						}
-						start1 = *gmtime(&t_start1);
+						utcTime(t_start1, start1);
 					}
 					else {
 						LOGD("TriggerAtTime evaluation: user policy start time");
-						if (sscanf((*triggers_it)[startTag].c_str(),"%d-%d-%dT%d:%d:%d.%d%c%d:%d",
+						if (sscanf(mapValue(*triggers_it, startTag).c_str(),"%d-%d-%dT%d:%d:%d.%d%c%d:%d",
 								&start1.tm_year, &start1.tm_mon, &start1.tm_mday, &start1.tm_hour,
 								&start1.tm_min, &start1.tm_sec, &millisec, &sign, &off_hour1, &off_min1) != EOF) {
 						
@@ -199,7 +208,7 @@ bool TriggersSet::evaluate(vector< map<string, string> > trig){
 							start1.tm_year+1900, start1.tm_mon+1, start1.tm_mday, start1.tm_hour, start1.tm_min, start1.tm_sec);
 
 					// user MaxDelay
-					if (sscanf((*triggers_it)[maxDelayTag].c_str(),"P%dY%dM%dDT%dH%dM%dS",
+					if (sscanf(mapValue(*triggers_it, maxDelayTag).c_str(),"P%dY%dM%dDT%dH%dM%dS",
 								&delay1.tm_year, &delay1.tm_mon, &delay1.tm_mday, &delay1.tm_hour,
 								&delay1.tm_min, &delay1.tm_sec) != EOF) {
 
@@ -229,18 +238,18 @@ bool TriggersSet::evaluate(vector< map<string, string> > trig){
 					}
 
 					// application start time
-					if ((*it)[startTag] == startNowTag) {
+					if (mapValue(*it, startTag) == startNowTag) {
 						LOGD("TriggerAtTime evaluation: application current start time");
 						if (time(&t_start2) == -1) {
 							LOGD("Error on user Start");
 							trigger_satisfied = false;
 							break;
 						}
-						start2 = *gmtime(&t_start2);
+						utcTime(t_start2, start2);
 					}
 					else {
 						LOGD("TriggerAtTime evaluation: applications manifest start time");
-						if (sscanf((*it)[startTag].c_str(),"%d-%d-%dT%d:%d:%d.%d%c%d:%d",
+						if (sscanf(mapValue(*it, startTag).c_str(),"%d-%d-%dT%d:%d:%d.%d%c%d:%d",
 								&start2.tm_year, &start2.tm_mon, &start2.tm_mday, &start2.tm_hour,
 								&start2.tm_min, &start2.tm_sec, &millisec, &sign, &off_hour2, &off_min2) != EOF) {
 
@@ -283,7 +292,7 @@ bool TriggersSet::evaluate(vector< map<string, string> > trig){
 							start2.tm_year+1900, start2.tm_mon+1, start2.tm_mday, start2.tm_hour, start2.tm_min, start2.tm_sec);
 
 					// application MaxDelay
-					if (sscanf((*it)[maxDelayTag].c_str(),"P%dY%dM%dDT%dH%dM%dS",
+					if (sscanf(mapValue(*it, maxDelayTag).c_str(),"P%dY%dM%dDT%dH%dM%dS",
 								&delay2.tm_year, &delay2.tm_mon, &delay2.tm_mday, &delay2.tm_hour,
 								&delay2.tm_min, &delay2.tm_sec) != EOF) {
 
@@ -326,36 +335,36 @@ bool TriggersSet::evaluate(vector< map<string, string> > trig){
 			}
 
 			// TriggerPersonalDataAccessedForPurpose
-			if((*triggers_it)[triggerIdTag] == (*it)[triggerIdTag] && (*triggers_it)[triggerIdTag] == triggerPersonalDataAccessedTag){
+			if(mapValue(*triggers_it, triggerIdTag) == mapValue(*it, triggerIdTag) && mapValue(*triggers_it, triggerIdTag) == triggerPersonalDataAccessedTag){
 				LOGD("TriggerPersonalDataAccessedForPurpose evaluation");
 				purpose_satisfied = true;
 				for(unsigned int i = 0; i<arraysize(ontology_vector); i++){
-					LOGD("Trigger purpose %d is %c for the user and %c for the applications", i, (*triggers_it)[purposeTag][i], (*it)[purposeTag][i]);
-					if ((*triggers_it)[purposeTag][i] > (*it)[purposeTag][i]){
+					LOGD("Trigger purpose %d is %c for the user and %c for the applications", i, mapValue(*triggers_it, purposeTag)[i], mapValue(*it, purposeTag)[i]);
+					if (mapValue(*triggers_it, purposeTag)[i] > mapValue(*it, purposeTag)[i]){
 						purpose_satisfied = false;
 						break;
 					}
 				}
-				if ((*triggers_it)[maxDelayTag] >= (*it)[maxDelayTag] && purpose_satisfied == true){
+				if (mapValue(*triggers_it, maxDelayTag) >= mapValue(*it, maxDelayTag) && purpose_satisfied == true){
 					trigger_satisfied = true;
 					break;
 				}
 			}
 			
 			// TriggerPersonalDataDeleted evaluation
-			if((*triggers_it)[triggerIdTag] == (*it)[triggerIdTag] && (*triggers_it)[triggerIdTag] == triggerPersonalDataDeletedTag){
+			if(mapValue(*triggers_it, triggerIdTag) == mapValue(*it, triggerIdTag) && mapValue(*triggers_it, triggerIdTag) == triggerPersonalDataDeletedTag){
 				LOGD("TriggerPersonalDataDeleted evaluation");
 				// MaxDelay from DHPreference is greter or equal of application MaxDelay
-				if ((*triggers_it)[maxDelayTag] >= (*it)[maxDelayTag]){
+				if (mapValue(*triggers_it, maxDelayTag) >= mapValue(*it, maxDelayTag)){
 					trigger_satisfied = true;
 					break;
 				}
 			}
 
 			// TriggerDataSubjectAccess evaluation
-			if((*triggers_it)[triggerIdTag] == (*it)[triggerIdTag] && (*triggers_it)[triggerIdTag] == triggerDataSubjectAccessTag){
+			if(mapValue(*triggers_it, triggerIdTag) == mapValue(*it, triggerIdTag) && mapValue(*triggers_it, triggerIdTag) == triggerDataSubjectAccessTag){
 				LOGD("TriggerDataSubjectAccess evaluation");
-				if ((*triggers_it)[uriTag] == (*it)[uriTag]){
+				if (mapValue(*triggers_it, uriTag) == mapValue(*it, uriTag)){
 					trigger_satisfied = true;
 					break;
 				}
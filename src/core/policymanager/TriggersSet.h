@@ -46,7 +46,7 @@ public:
 	TriggersSet(TiXmlElement*);
 	virtual ~TriggersSet();
 
-	bool evaluate(vector< map<string, string> >);
+	bool evaluate(const vector< map<string, string> >&) const;
 };
 
 #endif /* TRIGGERSSET_H_ */
@@ -0,0 +1,65 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#include "ValueDictionary.h"
+#include <cstring>
+
+ValueDictionary::ValueDictionary() {
+}
+
+ValueDictionary::~ValueDictionary() {
+}
+
+unsigned int ValueDictionary::intern(const string& value) {
+	map<StringView, unsigned int, ViewOrder>::iterator it = ids.find(StringView(value));
+	if (it != ids.end())
+		return it->second;
+	unsigned int id = VALUE_UNKNOWN + 1 + ids.size();
+	// a deque keeps its elements in place as it grows
+	literals.push_back(value);
+	ids[StringView(literals.back())] = id;
+	return id;
+}
+
+// only literals compared as a whole are worth an id
+void ValueDictionary::intern(match_expr& expr) {
+	if (expr.kind == MATCH_PATTERN || !expr.wildcards.empty())
+		return;
+	if (expr.mode != STRCMP_NORMAL && !expr.compiled)
+		return;
+	expr.id = intern(expr.literal);
+}
+
+// id of the length bytes at value
+unsigned int ValueDictionary::find(const char* value, size_t length) const {
+	// the matcher stops at the first NUL, so such values are never resolved
+	if (memchr(value, '\0', length) != NULL)
+		return VALUE_UNRESOLVED;
+	map<StringView, unsigned int, ViewOrder>::const_iterator it = ids.find(StringView(value, length));
+	return (it != ids.end()) ? it->second : VALUE_UNKNOWN;
+}
+
+// literal of an id the dictionary gave
+const string& ValueDictionary::literal(unsigned int id) const {
+	return literals[id - VALUE_UNKNOWN - 1];
+}
+
+unsigned int ValueDictionary::size() const {
+	return ids.size();
+}
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#ifndef VALUEDICTIONARY_H_
+#define VALUEDICTIONARY_H_
+
+#include "../../core/common.h"
+#include <cstring>
+#include <deque>
+#include <map>
+#include <string>
+using namespace std;
+
+// orders views of the literals of a ValueDictionary as strings
+typedef struct {
+	bool operator()(const StringView& a, const StringView& b) const {
+		int c = memcmp(a.data, b.data, (a.length < b.length) ? a.length : b.length);
+		return (c != 0) ? c < 0 : a.length < b.length;
+	}
+} ViewOrder;
+
+/*
+ * Dense integer ids of the literal values of a policy, assigned at load
+ * time. Request values are looked up once per evaluation, after which a
+ * literal comparison is an integer comparison; a value that is not in the
+ * dictionary gets VALUE_UNKNOWN and is equal to no literal.
+ * The dictionary is only written while the policy is compiled. It is
+ * keyed by views of its own copies of the literals, so that request
+ * values are looked up where they are, without a copy.
+ */
+class ValueDictionary
+	{
+
+private:
+	deque<string>							literals;
+	map<StringView, unsigned int, ViewOrder>	ids;	// of views of literals
+
+	ValueDictionary(const ValueDictionary&);
+	ValueDictionary& operator=(const ValueDictionary&);
+
+public:
+	ValueDictionary();
+	virtual ~ValueDictionary();
+
+	unsigned int intern(const string&);
+	void intern(match_expr&);
+	unsigned int find(const char*, size_t) const;
+	const string& literal(unsigned int) const;
+	unsigned int size() const;
+	};
+
+#endif /* VALUEDICTIONARY_H_ */
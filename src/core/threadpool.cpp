@@ -0,0 +1,180 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+#include "threadpool.h"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+typedef struct {
+	ThreadPool*		pool;
+	unsigned int	worker;
+} ThreadStart;
+
+ThreadPool::ThreadPool(unsigned int count) :
+		workers(1), task(NULL), round(0), busy(0), stopping(false) {
+	if (count == 0)
+		count = 1;
+	ranges = new WorkRange[count];
+	// the pool works with the threads it could start: a failure stops the
+	// creation and leaves a smaller pool (one worker, the caller, at worst)
+	for (unsigned int w = 1; w < count; w++) {
+		ThreadStart* arg = new ThreadStart;
+		arg->pool = this;
+		arg->worker = w;
+#ifdef _WIN32
+		HANDLE thread = (HANDLE) _beginthreadex(NULL, 0, start, arg, 0, NULL);
+		if (thread == 0) {
+#else
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, start, arg) != 0) {
+#endif
+			delete arg;
+			break;
+		}
+		threads.push_back(thread);
+	}
+	workers = threads.size() + 1;
+}
+
+ThreadPool::~ThreadPool() {
+	lock.lock();
+	stopping = true;
+	wake.broadcast();
+	lock.unlock();
+	for (unsigned int i = 0; i < threads.size(); i++) {
+#ifdef _WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else
+		pthread_join(threads[i], NULL);
+#endif
+	}
+	delete[] ranges;
+}
+
+unsigned int ThreadPool::size() const {
+	return workers;
+}
+
+unsigned int ThreadPool::hardwareThreads() {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (unsigned int) n : 1;
+#endif
+}
+
+#ifdef _WIN32
+unsigned int __stdcall ThreadPool::start(void* arg) {
+#else
+void* ThreadPool::start(void* arg) {
+#endif
+	ThreadStart* ts = static_cast<ThreadStart*>(arg);
+	ThreadPool* pool = ts->pool;
+	unsigned int worker = ts->worker;
+
+	delete ts;
+	pool->loop(worker);
+	return 0;
+}
+
+void ThreadPool::loop(unsigned int worker) {
+	unsigned int seen = 0;
+
+	lock.lock();
+	for (;;) {
+		while (!stopping && round == seen)
+			wake.wait(lock);
+		if (stopping)
+			break;
+		seen = round;
+		ThreadTask* t = task;
+		lock.unlock();
+		work(worker, t);
+		lock.lock();
+		if (--busy == 0)
+			done.signal();
+	}
+	lock.unlock();
+}
+
+bool ThreadPool::next(unsigned int worker, unsigned int& item) {
+	{
+		WorkRange& own = ranges[worker];
+		MutexLock l(own.lock);
+		if (own.begin < own.end) {
+			item = own.begin++;
+			return true;
+		}
+	}
+	for (unsigned int i = 1; i < workers; i++) {
+		WorkRange& victim = ranges[(worker + i) % workers];
+		MutexLock l(victim.lock);
+		if (victim.begin < victim.end) {
+			item = --victim.end;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::work(unsigned int worker, ThreadTask* t) {
+	unsigned int item;
+
+	while (next(worker, item))
+		t->run(worker, item);
+}
+
+void ThreadPool::run(ThreadTask& t, unsigned int count) {
+	MutexLock s(serial);
+
+	if (workers == 1 || count <= 1) {
+		for (unsigned int i = 0; i < count; i++)
+			t.run(0, i);
+		return;
+	}
+	unsigned int share = count / workers, extra = count % workers, first = 0;
+	for (unsigned int w = 0; w < workers; w++) {
+		MutexLock l(ranges[w].lock);
+		ranges[w].begin = first;
+		first += share + (w < extra ? 1 : 0);
+		ranges[w].end = first;
+	}
+	lock.lock();
+	task = &t;
+	busy = workers - 1;
+	round++;
+	wake.broadcast();
+	lock.unlock();
+
+	work(0, &t);
+
+	lock.lock();
+	while (busy > 0)
+		done.wait(lock);
+	task = NULL;
+	lock.unlock();
+}
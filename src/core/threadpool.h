@@ -0,0 +1,94 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include "mutex.h"
+#include <vector>
+
+using namespace std;
+
+// work of a ThreadPool::run call: items 0..count-1, each run exactly once
+class ThreadTask
+	{
+
+public:
+	virtual ~ThreadTask() {}
+	virtual void run(unsigned int worker, unsigned int item) = 0;
+	};
+
+/* Fixed set of threads for data-parallel loops.
+ * run() gives each worker a contiguous range of the items; a worker takes
+ * items from the front of its own range and, when that is empty, steals
+ * from the back of the others, so that uneven items still keep every
+ * thread busy. The calling thread works as worker 0 and run() returns
+ * once every item is done.
+ * */
+class ThreadPool
+	{
+
+private:
+	typedef struct {
+		Mutex			lock;
+		unsigned int	begin;
+		unsigned int	end;
+	} WorkRange;
+
+#ifdef _WIN32
+	vector<HANDLE>		threads;
+#else
+	vector<pthread_t>	threads;
+#endif
+	unsigned int		workers;
+	WorkRange*			ranges;
+	Mutex				serial;		// one run() at a time
+	Mutex				lock;		// guards the fields below
+	ConditionVariable	wake;
+	ConditionVariable	done;
+	ThreadTask*			task;
+	unsigned int		round;
+	unsigned int		busy;		// helper threads still working on the round
+	bool				stopping;
+
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	bool next(unsigned int, unsigned int&);
+	void work(unsigned int, ThreadTask*);
+	void loop(unsigned int);
+#ifdef _WIN32
+	static unsigned int __stdcall start(void*);
+#else
+	static void* start(void*);
+#endif
+
+public:
+	ThreadPool(unsigned int);
+	virtual ~ThreadPool();
+
+	// workers actually started, at most the count given to the constructor
+	unsigned int size() const;
+	// processors online, at least 1
+	static unsigned int hardwareThreads();
+	void run(ThreadTask&, unsigned int);
+	};
+
+#endif /* THREADPOOL_H_ */
@@ -44,19 +44,30 @@ LOCAL_SRC_FILES :=\
         ../../core/policymanager/ObligationsSet.cpp \
         ../../core/policymanager/Policy.cpp \
         ../../core/policymanager/PolicyManager.cpp \
+        ../../core/policymanager/RootPolicyManager.cpp \
         ../../core/policymanager/PolicySet.cpp \
+        ../../core/policymanager/DecisionCache.cpp \
+        ../../core/policymanager/EvaluationArena.cpp \
+        ../../core/policymanager/PolicyProgram.cpp \
+        ../../core/policymanager/PredicateTable.cpp \
+        ../../core/policymanager/ValueDictionary.cpp \
         ../../core/policymanager/ProvisionalAction.cpp \
         ../../core/policymanager/ProvisionalActions.cpp \
         ../../core/policymanager/Request.cpp \
+        ../../core/policymanager/RequestBuilder.cpp \
         ../../core/policymanager/Rule.cpp \
         ../../core/policymanager/Subject.cpp \
+        ../../core/policymanager/SubjectIndex.cpp \
+        ../../core/policymanager/ResourceIndex.cpp \
         ../../core/policymanager/TriggersSet.cpp \
 	    ../../core/policymanager/IPolicyBaseDescriptor.cpp \
 	    ../../core/policymanager/PolicyDescriptor.cpp \
 	    ../../core/policymanager/PolicySetDescriptor.cpp \
         ../../core/common.cpp \
+        ../../core/matcher.cpp \
+        ../../core/mutex.cpp \
+        ../../core/threadpool.cpp \
         ../../../contrib/xmltools/tinyxml.cpp \
-        ../../../contrib/xmltools/slre.cpp \
         ../../../contrib/xmltools/tinystr.cpp \
         ../../../contrib/xmltools/tinyxmlparser.cpp \
         ../../../contrib/xmltools/tinyxmlerror.cpp
@@ -19,22 +19,122 @@
 
 #include <v8.h>
 #include <node.h>
+#include <node_version.h>
+#include <uv.h>
+#include <node_buffer.h>
 
 #include "core/policymanager/PolicyManager.h"
+#include "core/policymanager/RootPolicyManager.h"
+#include "core/policymanager/RequestBuilder.h"
 #include "debug.h"
 
 using namespace node;
 using namespace v8;
 
+// property names of request_fields and of the objects holding them
+static Persistent<String> group_names[REQ_GROUP_COUNT];
+static Persistent<String> field_names[REQUEST_FIELD_COUNT];
+
+static void InitNames()  {
+	for (unsigned int i = 0; i < REQ_GROUP_COUNT; i++)
+		group_names[i] = Persistent<String>::New(String::NewSymbol(request_group_names[i]));
+	for (unsigned int i = 0; i < REQUEST_FIELD_COUNT; i++)
+		field_names[i] = Persistent<String>::New(String::NewSymbol(request_fields[i].property));
+}
+
+/* Writes a request field as String::AsciiValue would convert it, straight
+ * into the request being built.
+ * */
+static void ReadString(Handle<Value> value, RequestBuilder& builder, unsigned int field)  {
+	Local<String> str = value->ToString();
+	int length = str.IsEmpty() ? 0 : str->Length();
+	char* room = builder.add(field, length);
+	if (length > 0)
+		str->WriteAscii(room, 0, length);
+	LOGD("Parameter %s : %s", attribute2string(request_fields[field].attr), room);
+}
+
+
+/* Request marshalled once from its JS object, so that it can be given to
+ * the enforceRequest of several policy managers in turn.
+ * */
+class PolicyRequestInt: ObjectWrap{
+
+public:
+	Request* request;
+	static Persistent<FunctionTemplate> s_ct;
+
+	static void Init(Handle<Object> target)  {
+		HandleScope scope;
+
+		Local<FunctionTemplate> t = FunctionTemplate::New(New);
+		s_ct = Persistent<FunctionTemplate>::New(t);
+		s_ct->InstanceTemplate()->SetInternalFieldCount(1);
+		s_ct->SetClassName(String::NewSymbol("PolicyRequest"));
+		target->Set(String::NewSymbol("PolicyRequest"),
+		s_ct->GetFunction());
+	}
+
+	PolicyRequestInt() :    request(NULL)  {
+	}
+
+	~PolicyRequestInt()  {
+		delete request;
+	}
+
+	static Handle<Value> New(const Arguments& args);
+	static Request* Get(Handle<Value> value, const AttributeReferences* refs, bool& owned);
+
+	static bool IsInstance(Handle<Value> value)  {
+		return s_ct->HasInstance(value);
+	}
+};
+
+Persistent<FunctionTemplate> PolicyRequestInt::s_ct;
+
 
 class PolicyManagerInt: ObjectWrap{
 
 private:  
 	int m_count;
+	map<PolicyManager*, int> inflight;	// pending async requests per instance
+	unsigned int reloads;		// reloadPolicy calls so far
+	unsigned int published;		// reload whose policy is in pminst
+	int mode;					// EvaluationMode of every policy loaded
+
+	/* State of an enforceRequestAsync call, handed from the JS thread to
+	 * a worker and back.
+	 * */
+	typedef struct {
+		uv_work_t				work;
+		PolicyManagerInt*		owner;
+		PolicyManager*			pm;
+		Request*				request;
+		EvaluationContext		context;
+		Effect					effect;
+		Persistent<Object>		self;		// keeps the wrapper alive
+		Persistent<Function>	callback;
+	} AsyncEnforce;
+
+	/* State of an asynchronous reloadPolicy call: the policy is parsed on
+	 * a worker and published on the JS thread.
+	 * */
+	typedef struct {
+		uv_work_t						work;
+		PolicyManagerInt*				owner;
+		string							fileName;
+		map<string, vector<string>*>*	pip;
+		PolicyManager*					pm;
+		unsigned int					sequence;
+		Persistent<Object>				self;
+		Persistent<Function>			callback;
+	} AsyncReload;
 	
 public:
 	PolicyManager* pminst;
+	ThreadPool* pool;		// evaluates enforceRequests batches, NULL for one thread
 	string policyFileName;
+	EvaluationContext context;	// of the enforceRequest calls, on the JS thread
 	static Persistent<FunctionTemplate> s_ct;
   
 	static void Init(Handle<Object> target)  {
@@ -44,24 +144,29 @@ public:
 		s_ct->InstanceTemplate()->SetInternalFieldCount(1);
 		s_ct->SetClassName(String::NewSymbol("PolicyManagerInt"));
 		NODE_SET_PROTOTYPE_METHOD(s_ct, "enforceRequest", EnforceRequest);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "enforceRequestBuffer", EnforceRequestBuffer);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "enforceRequestAsync", EnforceRequestAsync);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "enforceRequests", EnforceRequests);
 		NODE_SET_PROTOTYPE_METHOD(s_ct, "reloadPolicy", ReloadPolicy);
 		NODE_SET_PROTOTYPE_METHOD(s_ct, "getPolicyFilename", GetPolicyFilename);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "getReferencedAttributes", GetReferencedAttributes);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "getMatchErrors", GetMatchErrors);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "getStatistics", GetStatistics);
 		target->Set(String::NewSymbol("PolicyManagerInt"),
 		s_ct->GetFunction());
 	}
 
-	PolicyManagerInt() :    m_count(0)  {
+	PolicyManagerInt() :    m_count(0), reloads(0), published(0), mode(EVALUATION_LAZY), pool(NULL)  {
 	}
 	
-	~PolicyManagerInt()  {  }
+	~PolicyManagerInt()  {
+		delete pool;
+	}
 
 	static Handle<Value> New(const Arguments& args)  {
 		HandleScope scope;
 		PolicyManagerInt* pmtmp = new PolicyManagerInt();
-
-		map<string, vector<string>*> *pip = new map<string, vector<string>*>();
-		(*pip)["http://webinos.org/subject/id/PZ-Owner"] = new vector<string>();
-		(*pip)["http://webinos.org/subject/id/known"] = new vector<string>();
+		map<string, vector<string>*> *pip = NULL;
 
 		if (args.Length() > 1) {
 			if (!args[0]->IsString()) {
@@ -78,23 +183,31 @@ public:
 			//	delete[] pmtmp->policyFileName;
 			//}
 			pmtmp->policyFileName = *tmpFileName;
+			pip = NewPip(args[1]->ToObject());
 
-			if (args[1]->ToObject()->Has(String::New("http://webinos.org/subject/id/PZ-Owner"))) {
-				v8::String::AsciiValue ownerId(args[1]->ToObject()->Get(String::New("http://webinos.org/subject/id/PZ-Owner")));
-				(*pip)["http://webinos.org/subject/id/PZ-Owner"]->push_back(*ownerId);
-			}
-
-			if (args[1]->ToObject()->Has(String::New("http://webinos.org/subject/id/known"))) {
-				v8::Local<Array> knownList = v8::Local<Array>::Cast(args[1]->ToObject()->Get(String::New("http://webinos.org/subject/id/known")));
-                LOGD("knownList->Length() = %d", knownList->Length());
-				unsigned int i = 0;
-				for (i=0; i < knownList->Length(); i++)
-				{
-			        LOGD("Known[%d]:",i);
-					v8::String::AsciiValue knownId(knownList->Get(i));
-					(*pip)["http://webinos.org/subject/id/known"]->push_back(*knownId);
-
-			        LOGD("Known[%d]: %s",i, *knownId);
+			// options: { threads: <threads evaluating enforceRequests batches,
+			//                     capped at the processors online>,
+			//            mode: "lazy" (default) | "vector", see EvaluationMode }
+			if (args.Length() > 2 && args[2]->IsObject()) {
+				if (args[2]->ToObject()->Has(String::New("mode"))) {
+					v8::String::AsciiValue mode(args[2]->ToObject()->Get(String::New("mode"))->ToString());
+					LOGD("Evaluation mode: %s", *mode);
+					if (string(*mode) == "vector")
+						pmtmp->mode = EVALUATION_VECTOR;
+					else if (string(*mode) != "lazy")
+						return ThrowException(Exception::TypeError(String::New("Bad evaluation mode")));
+				}
+				if (args[2]->ToObject()->Has(String::New("threads"))) {
+					Local<Value> threadsArg = args[2]->ToObject()->Get(String::New("threads"));
+					if (!threadsArg->IsUint32() || threadsArg->Uint32Value() == 0)
+						return ThrowException(Exception::TypeError(String::New("Bad number of threads")));
+					// more threads than processors only add switches
+					unsigned int threads = threadsArg->Uint32Value();
+					if (threads > ThreadPool::hardwareThreads())
+						threads = ThreadPool::hardwareThreads();
+					LOGD("Batch evaluation threads: %u", threads);
+					if (threads > 1)
+						pmtmp->pool = new ThreadPool(threads);
 				}
 			}
 		}
@@ -104,190 +217,62 @@ public:
 		}
 
 		pmtmp->pminst = new PolicyManager(pmtmp->policyFileName, pip);
+		pmtmp->pminst->setEvaluationMode(pmtmp->mode);
 		pmtmp->Wrap(args.This());
 		return args.This();
 	}
 
-	static Handle<Value> EnforceRequest(const Arguments& args)  {
-		HandleScope scope;
+	/* Builds the policy information point map (PZ owner and known PZ
+	 * users) from its JS object; the policy managers using it never free it.
+	 * */
+	static map<string, vector<string>*>* NewPip(Handle<Object> info)  {
+		map<string, vector<string>*> *pip = new map<string, vector<string>*>();
+		(*pip)["http://webinos.org/subject/id/PZ-Owner"] = new vector<string>();
+		(*pip)["http://webinos.org/subject/id/known"] = new vector<string>();
 
-		if (args.Length() < 1) {
-			return ThrowException(Exception::TypeError(String::New("Argument missing")));
+		if (info->Has(String::New("http://webinos.org/subject/id/PZ-Owner"))) {
+			v8::String::AsciiValue ownerId(info->Get(String::New("http://webinos.org/subject/id/PZ-Owner")));
+			(*pip)["http://webinos.org/subject/id/PZ-Owner"]->push_back(*ownerId);
 		}
 
-		if (!args[0]->IsObject()) {
-			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
-		}
-		
-		PolicyManagerInt* pmtmp = ObjectWrap::Unwrap<PolicyManagerInt>(args.This());
-		pmtmp->m_count++;
-
-		map<string, vector<string>*> * subject_attrs = new map<string, vector<string>*>();
-		(*subject_attrs)["user-id"] = new vector<string>();
-		(*subject_attrs)["user-key-cn"] = new vector<string>();
-		(*subject_attrs)["user-key-fingerprint"] = new vector<string>();
-		(*subject_attrs)["user-key-root-cn"] = new vector<string>();
-		(*subject_attrs)["user-key-root-fingerprint"] = new vector<string>();
-		
-		(*subject_attrs)["id"] = new vector<string>();
-		
-		(*subject_attrs)["distributor-key-cn"] = new vector<string>();
-		(*subject_attrs)["distributor-key-fingerprint"] = new vector<string>();
-		(*subject_attrs)["distributor-key-root-cn"] = new vector<string>();
-		(*subject_attrs)["distributor-key-root-fingerprint"] = new vector<string>();
-
-		(*subject_attrs)["author-key-cn"] = new vector<string>();
-		(*subject_attrs)["author-key-fingerprint"] = new vector<string>();
-		(*subject_attrs)["author-key-root-cn"] = new vector<string>();
-		(*subject_attrs)["author-key-root-fingerprint"] = new vector<string>();
-
-		(*subject_attrs)["target-id"] = new vector<string>();
-		(*subject_attrs)["target-domain"] = new vector<string>();
-		(*subject_attrs)["requestor-id"] = new vector<string>();
-		(*subject_attrs)["requestor-domain"] = new vector<string>();
-		(*subject_attrs)["webinos-enabled"] = new vector<string>();
-
-		map<string, vector<string>*> * resource_attrs = new map<string, vector<string>*>();
-		(*resource_attrs)["api-feature"] = new vector<string>();
-		(*resource_attrs)["service-id"] = new vector<string>();
-		(*resource_attrs)["device-cap"] = new vector<string>();
-		(*resource_attrs)["param:feature"] = new vector<string>();
-
-		if (args[0]->ToObject()->Has(String::New("resourceInfo"))) {
-			v8::Local<Value> riTmp = args[0]->ToObject()->Get(String::New("resourceInfo"));
-			if (riTmp->ToObject()->Has(String::New("deviceCap"))) {
-				v8::String::AsciiValue deviceCap(riTmp->ToObject()->Get(String::New("deviceCap")));
-				(*resource_attrs)["device-cap"]->push_back(*deviceCap);
-				LOGD("Parameter device-cap : %s", *deviceCap);
-			}
-			if (riTmp->ToObject()->Has(String::New("apiFeature"))) {
-				v8::String::AsciiValue apiFeature(riTmp->ToObject()->Get(String::New("apiFeature")));
-				(*resource_attrs)["api-feature"]->push_back(*apiFeature);
-				LOGD("Parameter api-feature : %s", *apiFeature);
-			}
-			if (riTmp->ToObject()->Has(String::New("serviceId"))) {
-				v8::String::AsciiValue serviceId(riTmp->ToObject()->Get(String::New("serviceId")));
-				(*resource_attrs)["service-id"]->push_back(*serviceId);
-				LOGD("Parameter service-id : %s", *serviceId);
-			}
-			if (riTmp->ToObject()->Has(String::New("paramFeature"))) {
-				v8::String::AsciiValue paramFeature(riTmp->ToObject()->Get(String::New("paramFeature")));
-				(*resource_attrs)["param:feature"]->push_back(*paramFeature);
-				LOGD("Parameter param:feature : %s", *paramFeature);
-			}
-		}
-		
-		if (args[0]->ToObject()->Has(String::New("subjectInfo"))) {
-			v8::Local<Value> siTmp = args[0]->ToObject()->Get(String::New("subjectInfo"));
-			if (siTmp->ToObject()->Has(String::New("userId"))) {
-				v8::String::AsciiValue userId(siTmp->ToObject()->Get(String::New("userId")));
-				(*subject_attrs)["user-id"]->push_back(*userId);
-				LOGD("Parameter user-id : %s", *userId);
-			}
-			if (siTmp->ToObject()->Has(String::New("userKeyCn"))) {
-				v8::String::AsciiValue userKeyCn(siTmp->ToObject()->Get(String::New("userKeyCn")));
-				(*subject_attrs)["user-key-cn"]->push_back(*userKeyCn);
-				LOGD("Parameter user-key-cn : %s", *userKeyCn);
-			}
-			if (siTmp->ToObject()->Has(String::New("userKeyFingerprint"))) {
-				v8::String::AsciiValue userKeyFingerprint(siTmp->ToObject()->Get(String::New("userKeyFingerprint")));
-				(*subject_attrs)["user-key-fingerprint"]->push_back(*userKeyFingerprint);
-				LOGD("Parameter user-key-fingerprint : %s", *userKeyFingerprint);
-			}
-			if (siTmp->ToObject()->Has(String::New("userKeyRootCn"))) {
-				v8::String::AsciiValue userKeyRootCn(siTmp->ToObject()->Get(String::New("userKeyRootCn")));
-				(*subject_attrs)["user-key-root-cn"]->push_back(*userKeyRootCn);
-				LOGD("Parameter user-key-root-cn : %s", *userKeyRootCn);
-			}
-			if (siTmp->ToObject()->Has(String::New("userKeyRootFingerprint"))) {
-				v8::String::AsciiValue userKeyRootFingerprint(siTmp->ToObject()->Get(String::New("userKeyRootFingerprint")));
-				(*subject_attrs)["user-key-root-fingerprint"]->push_back(*userKeyRootFingerprint);
-				LOGD("Parameter user-key-root-fingerprint : %s", *userKeyRootFingerprint);
+		if (info->Has(String::New("http://webinos.org/subject/id/known"))) {
+			v8::Local<Array> knownList = v8::Local<Array>::Cast(info->Get(String::New("http://webinos.org/subject/id/known")));
+			LOGD("knownList->Length() = %d", knownList->Length());
+			for (unsigned int i = 0; i < knownList->Length(); i++) {
+				v8::String::AsciiValue knownId(knownList->Get(i));
+				(*pip)["http://webinos.org/subject/id/known"]->push_back(*knownId);
+				LOGD("Known[%d]: %s",i, *knownId);
 			}
 		}
+		return pip;
+	}
 
-		if (args[0]->ToObject()->Has(String::New("widgetInfo"))) {
-			v8::Local<Value> wiTmp = args[0]->ToObject()->Get(String::New("widgetInfo"));
-			if (wiTmp->ToObject()->Has(String::New("id"))) {
-				v8::String::AsciiValue id(wiTmp->ToObject()->Get(String::New("id")));
-				(*subject_attrs)["id"]->push_back(*id);
-				LOGD("Parameter id : %s", *id);
-			}
-			if (wiTmp->ToObject()->Has(String::New("distributorKeyCn"))) {
-				v8::String::AsciiValue distributorKeyCn(wiTmp->ToObject()->Get(String::New("distributorKeyCn")));
-				(*subject_attrs)["distributor-key-cn"]->push_back(*distributorKeyCn);
-				LOGD("Parameter distributor-key-cn : %s", *distributorKeyCn);
-			}
-			if (wiTmp->ToObject()->Has(String::New("distributorKeyFingerprint"))) {
-				v8::String::AsciiValue distributorKeyFingerprint(wiTmp->ToObject()->Get(String::New("distributorKeyFingerprint")));
-				(*subject_attrs)["distributor-key-fingerprint"]->push_back(*distributorKeyFingerprint);
-				LOGD("Parameter distributor-key-fingerprint : %s", *distributorKeyFingerprint);
-			}
-			if (wiTmp->ToObject()->Has(String::New("distributorKeyRootCn"))) {
-				v8::String::AsciiValue distributorKeyRootCn(wiTmp->ToObject()->Get(String::New("distributorKeyRootCn")));
-				(*subject_attrs)["distributor-key-root-cn"]->push_back(*distributorKeyRootCn);
-				LOGD("Parameter distributor-key-root-cn : %s", *distributorKeyRootCn);
-			}
-			if (wiTmp->ToObject()->Has(String::New("distributorKeyRootFingerprint"))) {
-				v8::String::AsciiValue distributorKeyRootFingerprint(wiTmp->ToObject()->Get(String::New("distributorKeyRootFingerprint")));
-				(*subject_attrs)["distributor-key-root-fingerprint"]->push_back(*distributorKeyRootFingerprint);
-				LOGD("Parameter distributor-key-root-fingerprint : %s", *distributorKeyRootFingerprint);
-			}
-			if (wiTmp->ToObject()->Has(String::New("authorKeyCn"))) {
-				v8::String::AsciiValue authorKeyCn(wiTmp->ToObject()->Get(String::New("authorKeyCn")));
-				(*subject_attrs)["author-key-cn"]->push_back(*authorKeyCn);
-				LOGD("Parameter author-key-cn : %s", *authorKeyCn);
-			}
-			if (wiTmp->ToObject()->Has(String::New("authorKeyFingerprint"))) {
-				v8::String::AsciiValue authorKeyFingerprint(wiTmp->ToObject()->Get(String::New("authorKeyFingerprint")));
-				(*subject_attrs)["author-key-fingerprint"]->push_back(*authorKeyFingerprint);
-				LOGD("Parameter author-key-fingerprint : %s", *authorKeyFingerprint);
-			}
-			if (wiTmp->ToObject()->Has(String::New("authorKeyRootCn"))) {
-				v8::String::AsciiValue authorKeyRootCn(wiTmp->ToObject()->Get(String::New("authorKeyRootCn")));
-				(*subject_attrs)["author-key-root-cn"]->push_back(*authorKeyRootCn);
-				LOGD("Parameter author-key-root-cn : %s", *authorKeyRootCn);
-			}
-			if (wiTmp->ToObject()->Has(String::New("authorKeyRootFingerprint"))) {
-				v8::String::AsciiValue authorKeyRootFingerprint(wiTmp->ToObject()->Get(String::New("authorKeyRootFingerprint")));
-				(*subject_attrs)["author-key-root-fingerprint"]->push_back(*authorKeyRootFingerprint);
-				LOGD("Parameter author-key-root-fingerprint : %s", *authorKeyRootFingerprint);
-			}
-		}
+	/* Builds the native Request for a JS request object; the caller owns it.
+	 * Only the attributes in refs are read, all of them if refs is NULL.
+	 * Attribute values are read as listed in request_fields, through the
+	 * name handles made by InitNames.
+	 * */
+	static Request* NewRequest(Handle<Object> reqObj, const AttributeReferences* refs = NULL)  {
+		RequestBuilder builder(refs);
+		Local<Object> group;
+		int current = -1;
 
-		if (args[0]->ToObject()->Has(String::New("deviceInfo"))) {
-			v8::Local<Value> diTmp = args[0]->ToObject()->Get(String::New("deviceInfo"));
-			if (diTmp->ToObject()->Has(String::New("targetId"))) {
-				v8::String::AsciiValue targetId(diTmp->ToObject()->Get(String::New("targetId")));
-				(*subject_attrs)["target-id"]->push_back(*targetId);
-				LOGD("Parameter target-id : %s", *targetId);
-			}
-			if (diTmp->ToObject()->Has(String::New("targetDomain"))) {
-				v8::String::AsciiValue targetDomain(diTmp->ToObject()->Get(String::New("targetDomain")));
-				(*subject_attrs)["target-domain"]->push_back(*targetDomain);
-				LOGD("Parameter target-domain : %s", *targetDomain);
-			}
-			if (diTmp->ToObject()->Has(String::New("requestorId"))) {
-				v8::String::AsciiValue requestorId(diTmp->ToObject()->Get(String::New("requestorId")));
-				(*subject_attrs)["requestor-id"]->push_back(*requestorId);
-				LOGD("Parameter requestor-id : %s", *requestorId);
-			}
-			if (diTmp->ToObject()->Has(String::New("requestorDomain"))) {
-				v8::String::AsciiValue requestorDomain(diTmp->ToObject()->Get(String::New("requestorDomain")));
-				(*subject_attrs)["requestor-domain"]->push_back(*requestorDomain);
-				LOGD("Parameter requestor-domain : %s", *requestorDomain);
-			}
-			if (diTmp->ToObject()->Has(String::New("webinosEnabled"))) {
-				v8::String::AsciiValue webinosEnabled(diTmp->ToObject()->Get(String::New("webinosEnabled")));
-				(*subject_attrs)["webinos-enabled"]->push_back(*webinosEnabled);
-				LOGD("Parameter webinos-enabled : %s", *webinosEnabled);
+		for (unsigned int i = 0; i < REQUEST_FIELD_COUNT; i++) {
+			if (!builder.wants(i))
+				continue;
+			if (request_fields[i].group != current) {
+				current = request_fields[i].group;
+				group = reqObj->Has(group_names[current]) ? reqObj->Get(group_names[current])->ToObject() : Local<Object>();
 			}
+			if (group.IsEmpty() || !group->Has(field_names[i]))
+				continue;
+			ReadString(group->Get(field_names[i]), builder, i);
 		}
 
 		vector<bool> purpose;
-		if (args[0]->ToObject()->Has(String::New("purpose"))) {
-			if (args[0]->ToObject()->Get(String::New("purpose"))->IsArray()) {
-				v8::Local<Array> pTmp = v8::Local<Array>::Cast(args[0]->ToObject()->Get(String::New("purpose")));
+		if (reqObj->Has(String::New("purpose"))) {
+			if (reqObj->Get(String::New("purpose"))->IsArray()) {
+				v8::Local<Array> pTmp = v8::Local<Array>::Cast(reqObj->Get(String::New("purpose")));
 				LOGD("DHPref: read %d purposes", pTmp->Length());
 				if (pTmp->Length() == arraysize(ontology_vector)) {
 					for(unsigned int i = 0; i < arraysize(ontology_vector); i++) {
@@ -329,9 +314,9 @@ public:
 		v8::Local<Value> actTmp, triggerTmp;
 		v8::Local<Array> triggersTmp;
 
-		if (args[0]->ToObject()->Has(String::New("obligations"))) {
-			if (args[0]->ToObject()->Get(String::New("obligations"))->IsArray()) {
-				v8::Local<Array> obTmp = v8::Local<Array>::Cast(args[0]->ToObject()->Get(String::New("obligations")));
+		if (reqObj->Has(String::New("obligations"))) {
+			if (reqObj->Get(String::New("obligations"))->IsArray()) {
+				v8::Local<Array> obTmp = v8::Local<Array>::Cast(reqObj->Get(String::New("obligations")));
 				LOGD("DHPref: read %d obligations", obTmp->Length());
 				for (unsigned int i = 0; i < obTmp->Length(); i++) {
 					if (obTmp->Get(i)->ToObject()->Has(String::New("action"))) {
@@ -557,124 +542,317 @@ public:
 			}
 		}
 
-//		string widPath(".");
+		return builder.build(purpose, obs);
+	}
+
+	static Handle<Value> EnforceRequest(const Arguments& args)  {
+		HandleScope scope;
+
+		if (args.Length() < 1) {
+			return ThrowException(Exception::TypeError(String::New("Argument missing")));
+		}
 
-//		string roam("N");
-//		map<string,string>* environment = new map<string,string>();
-//		(*environment)["roaming"] = roam;
+		if (!args[0]->IsObject()) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
 		
-//		Request* myReq = new Request(widPath, *resource_attrs, *environment);
+		PolicyManagerInt* pmtmp = ObjectWrap::Unwrap<PolicyManagerInt>(args.This());
+		pmtmp->m_count++;
 
-		map<string, string> * environment_attrs = new map<string, string>();
+		// reading a JS request may run getters that call back in here, so
+		// only the evaluation uses the shared context
+		bool owned;
+		Request* myReq = PolicyRequestInt::Get(args[0], pmtmp->pminst->getReferences(), owned);
+		Effect myEff = pmtmp->Enforce(myReq, args);
+		if (owned)
+			delete myReq;
 
-		if (args[0]->ToObject()->Has(String::New("environmentInfo"))) {
-			v8::Local<Value> eiTmp = args[0]->ToObject()->Get(String::New("environmentInfo"));
-			/*
-			if (eiTmp->ToObject()->Has(String::New("roaming"))) {
-				v8::String::AsciiValue roaming(eiTmp->ToObject()->Get(String::New("roaming")));
-				(*environment_attrs)["roaming"] = *roaming;
-				LOGD("Parameter roaming : %s", *roaming);
-			}
-			if (eiTmp->ToObject()->Has(String::New("bearerType"))) {
-				v8::String::AsciiValue bearerType(eiTmp->ToObject()->Get(String::New("bearerType")));
-				(*environment_attrs)["bearer-type"] = *bearerType;
-				LOGD("Parameter bearer-type : %s", *bearerType);
-			}
-			*/
-			if (eiTmp->ToObject()->Has(String::New("profile"))) {
-				v8::String::AsciiValue profile(eiTmp->ToObject()->Get(String::New("profile")));
-				(*environment_attrs)["profile"] = *profile;
-				LOGD("Parameter profile : %s", *profile);
-			}
-			if (eiTmp->ToObject()->Has(String::New("timemin"))) {
-				v8::String::AsciiValue timemin(eiTmp->ToObject()->Get(String::New("timemin")));
-				(*environment_attrs)["timemin"] = *timemin;
-				LOGD("Parameter timemin : %s", *timemin);
-			}
-			if (eiTmp->ToObject()->Has(String::New("days-of-week"))) {
-				v8::String::AsciiValue daysofweek(eiTmp->ToObject()->Get(String::New("days-of-week")));
-				(*environment_attrs)["days-of-week"] = *daysofweek;
-				LOGD("Parameter daysofweek : %s", *daysofweek);
-			}
-			if (eiTmp->ToObject()->Has(String::New("days-of-month"))) {
-				v8::String::AsciiValue daysofmonth(eiTmp->ToObject()->Get(String::New("days-of-month")));
-				(*environment_attrs)["days-of-month"] = *daysofmonth;
-				LOGD("Parameter daysofmonth : %s", *daysofmonth);
+		//enum Effect {PERMIT, DENY, PROMPT_ONESHOT, PROMPT_SESSION, PROMPT_BLANKET, UNDETERMINED, INAPPLICABLE};
+
+		Local<Integer> result = Integer::New(myEff);
+
+		return scope.Close(result);
+	}
+
+	/* enforceRequestBuffer(buffer[, pathObj])
+	 * As enforceRequest, for a request encoded by lib/requestEncoder.js.
+	 */
+	static Handle<Value> EnforceRequestBuffer(const Arguments& args)  {
+		HandleScope scope;
+
+		if (args.Length() < 1) {
+			return ThrowException(Exception::TypeError(String::New("Argument missing")));
+		}
+
+		if (!Buffer::HasInstance(args[0])) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+
+		PolicyManagerInt* pmtmp = ObjectWrap::Unwrap<PolicyManagerInt>(args.This());
+
+		EvaluationArena* arena = &pmtmp->context.arena;
+		Request* myReq = DecodeRequest(args[0], pmtmp->pminst->getReferences(), arena);
+		if (myReq == NULL) {
+			arena->reset();
+			return ThrowException(Exception::Error(String::New("Malformed request buffer")));
+		}
+		pmtmp->m_count++;
+
+		Effect myEff = pmtmp->Enforce(myReq, args);
+		RequestBuilder::release(myReq, arena);
+		arena->reset();
+
+		Local<Integer> result = Integer::New(myEff);
+
+		return scope.Close(result);
+	}
+
+	static Request* DecodeRequest(Handle<Value> buffer, const AttributeReferences* refs, EvaluationArena* arena = NULL)  {
+		Local<Object> bufObj = buffer->ToObject();
+		return RequestBuilder::decode((const unsigned char*) Buffer::Data(bufObj), Buffer::Length(bufObj), refs, arena);
+	}
+
+	/* Evaluates a request of enforceRequest or enforceRequestBuffer in the
+	 * context of this object, setting args[1].path if it is an object.
+	 * */
+	Effect Enforce(Request* req, const Arguments& args)  {
+		context.withPath = args.Length()>1 && args[1]->IsObject();
+		context.path.clear();
+		Effect eff = pminst->checkRequest(req, context);
+		if (context.withPath) {
+			LOGD("[pm.cc]PATH: %s", context.path.c_str());
+			args[1]->ToObject()->Set(String::New("path"), String::New(context.path.c_str()));
+		}
+		return eff;
+	}
+
+	/* enforceRequests(requests[, paths])
+	 * Evaluates an array of requests in a single call and returns the effect
+	 * of each one in a Uint8Array; if paths is an array, paths[i] is set to
+	 * the policy path of requests[i]. The batch is spread over the threads
+	 * given to the constructor.
+	 * */
+	static Handle<Value> EnforceRequests(const Arguments& args)  {
+		HandleScope scope;
+
+		if (args.Length() < 1) {
+			return ThrowException(Exception::TypeError(String::New("Argument missing")));
+		}
+
+		if (!args[0]->IsArray()) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+
+		PolicyManagerInt* pmtmp = ObjectWrap::Unwrap<PolicyManagerInt>(args.This());
+		v8::Local<Array> reqArray = v8::Local<Array>::Cast(args[0]);
+		unsigned int count = reqArray->Length();
+		bool withPath = (args.Length() > 1 && args[1]->IsArray());
+		vector<Request*> reqs;
+		vector<Effect> effects;
+		vector<string> paths;
+
+		for (unsigned int i = 0; i < count; i++) {
+			v8::Local<Value> reqTmp = reqArray->Get(i);
+			if (!reqTmp->IsObject() || PolicyRequestInt::IsInstance(reqTmp)) {
+				for (unsigned int j = 0; j < reqs.size(); j++)
+					delete reqs[j];
+				return ThrowException(Exception::TypeError(String::New("Bad type argument")));
 			}
+			reqs.push_back(NewRequest(reqTmp->ToObject(), pmtmp->pminst->getReferences()));
 		}
+		pmtmp->m_count += count;
 
-		if( args.Length()>1 && args[1]->IsObject()){
-				Request* myReq = new Request(*subject_attrs, *resource_attrs, purpose, obs, *environment_attrs);
-				string psd;
-				Effect myEff = pmtmp->pminst->checkRequest(myReq, psd);
-				LOGD("[pm.cc]PATH: %s", psd.c_str());
-				args[1]->ToObject()->Set(String::New("path"), String::New(psd.c_str()));
-				//enum Effect {PERMIT, DENY, PROMPT_ONESHOT, PROMPT_SESSION, PROMPT_BLANKET, UNDETERMINED, INAPPLICABLE};
-	
-				Local<Integer> result = Integer::New(myEff);
-			
-				return scope.Close(result);
+		pmtmp->pminst->checkRequests(reqs, effects, withPath ? &paths : NULL, pmtmp->pool);
+		for (unsigned int i = 0; i < count; i++)
+			delete reqs[i];
+
+		v8::Local<Function> typedArray = v8::Local<Function>::Cast(
+				Context::GetCurrent()->Global()->Get(String::NewSymbol("Uint8Array")));
+		Handle<Value> argv[1];
+		argv[0] = Integer::NewFromUnsigned(count);
+		Local<Object> result = typedArray->NewInstance(1, argv);
+		unsigned char* data = static_cast<unsigned char*>(result->GetIndexedPropertiesExternalArrayData());
+		for (unsigned int i = 0; i < count; i++)
+			data[i] = effects[i];
+
+		if (withPath) {
+			v8::Local<Array> pathArray = v8::Local<Array>::Cast(args[1]);
+			for (unsigned int i = 0; i < count; i++)
+				pathArray->Set(i, String::New(paths[i].c_str()));
 		}
-		else{
-			Request* myReq = new Request(*subject_attrs, *resource_attrs, purpose, obs, *environment_attrs);
-		
-			Effect myEff = pmtmp->pminst->checkRequest(myReq);
 
-			//enum Effect {PERMIT, DENY, PROMPT_ONESHOT, PROMPT_SESSION, PROMPT_BLANKET, UNDETERMINED, INAPPLICABLE};
+		return scope.Close(result);
+	}
+
+	/* enforceRequestAsync(request, cb)
+	 * The request is read on the JS thread, evaluated on the libuv thread
+	 * pool, and cb(effect, path) is called back on the JS thread.
+	 * */
+	static Handle<Value> EnforceRequestAsync(const Arguments& args)  {
+		HandleScope scope;
 
-			Local<Integer> result = Integer::New(myEff);
-		
-			return scope.Close(result);
+		if (args.Length() < 2) {
+			return ThrowException(Exception::TypeError(String::New("Argument missing")));
 		}
+
+		// a PolicyRequest is evaluated in place, so it cannot be handed to a worker
+		if (!args[0]->IsObject() || !args[1]->IsFunction() || PolicyRequestInt::IsInstance(args[0])) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+
+		PolicyManagerInt* pmtmp = ObjectWrap::Unwrap<PolicyManagerInt>(args.This());
+		pmtmp->m_count++;
+
+		AsyncEnforce* job = new AsyncEnforce();
+		job->work.data = job;
+		job->owner = pmtmp;
+		job->pm = pmtmp->acquire();
+		job->request = NewRequest(args[0]->ToObject(), job->pm->getReferences());
+		job->context.withPath = true;
+		job->effect = INAPPLICABLE;
+		job->self = Persistent<Object>::New(args.This());
+		job->callback = Persistent<Function>::New(Local<Function>::Cast(args[1]));
+
+		uv_queue_work(uv_default_loop(), &job->work, EnforceWork, EnforceDone);
+
+		return scope.Close(Undefined());
 	}
 
-	
-	
-	
+	// worker thread: no V8 calls here
+	static void EnforceWork(uv_work_t* work)  {
+		AsyncEnforce* job = static_cast<AsyncEnforce*>(work->data);
+		job->effect = job->pm->checkRequest(job->request, job->context);
+	}
+
+#if NODE_VERSION_AT_LEAST(0, 10, 0)
+	static void EnforceDone(uv_work_t* work, int status)  {
+#else
+	static void EnforceDone(uv_work_t* work)  {
+#endif
+		HandleScope scope;
+		AsyncEnforce* job = static_cast<AsyncEnforce*>(work->data);
+
+		LOGD("[pm.cc]PATH: %s", job->context.path.c_str());
+		Handle<Value> argv[2];
+		argv[0] = Integer::New(job->effect);
+		argv[1] = String::New(job->context.path.c_str());
+
+		job->owner->release(job->pm);
+		delete job->request;
+		MakeCallback(job->self, job->callback, 2, argv);
+
+		job->callback.Dispose();
+		job->self.Dispose();
+		delete job;
+	}
+
+	/* Instances still evaluated by async requests are not deleted by
+	 * reloadPolicy: the last request to complete deletes them.
+	 * */
+	PolicyManager* acquire()  {
+		inflight[pminst]++;
+		return pminst;
+	}
+
+	void release(PolicyManager* pm)  {
+		if (--inflight[pm] == 0) {
+			inflight.erase(pm);
+			if (pm != pminst)
+				delete pm;
+		}
+	}
+
+	void retire(PolicyManager* pm)  {
+		if (inflight.find(pm) == inflight.end())
+			delete pm;
+	}
+
+	/* reloadPolicy(pip[, cb])
+	 * Without cb the new policy is in use when the call returns. With cb
+	 * it is parsed on the libuv thread pool while requests keep being
+	 * evaluated with the current one, then published and cb() called on
+	 * the JS thread. When reloads overlap the latest call wins.
+	 * */
 	static Handle<Value> ReloadPolicy(const Arguments& args)  {
 		HandleScope scope;
 
 		PolicyManagerInt* pmtmp = ObjectWrap::Unwrap<PolicyManagerInt>(args.This());
 
 		LOGD("ReloadPolicy - file is %s", pmtmp->policyFileName.c_str());
-		//TODO: Reload policy file
-		delete pmtmp->pminst;
 
-		map<string, vector<string>*> *pip = new map<string, vector<string>*>();
-		(*pip)["http://webinos.org/subject/id/PZ-Owner"] = new vector<string>();
-		(*pip)["http://webinos.org/subject/id/known"] = new vector<string>();
+		if (args.Length() < 1) {
+			LOGD("Missing argument");
+			return ThrowException(Exception::TypeError(String::New("Missing argument")));
+		}
+		if (!args[0]->IsObject()) {
+			LOGD("Wrong parameter type");
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
 
-		if (args.Length() > 0) {
-			if (!args[0]->IsObject()) {
-				LOGD("Wrong parameter type");
-				return ThrowException(Exception::TypeError(String::New("Bad type argument")));
-			}
-			if (args[0]->ToObject()->Has(String::New("http://webinos.org/subject/id/PZ-Owner"))) {
-				v8::String::AsciiValue ownerId(args[0]->ToObject()->Get(String::New("http://webinos.org/subject/id/PZ-Owner")));
-				(*pip)["http://webinos.org/subject/id/PZ-Owner"]->push_back(*ownerId);
-			}
+		map<string, vector<string>*> *pip = NewPip(args[0]->ToObject());
+		unsigned int sequence = ++pmtmp->reloads;
 
-			if (args[0]->ToObject()->Has(String::New("http://webinos.org/subject/id/known"))) {
-				v8::Local<Array> knownList = v8::Local<Array>::Cast(args[0]->ToObject()->Get(String::New("http://webinos.org/subject/id/known")));
-				unsigned int i = 0;
-				for (i=0; i < knownList->Length(); i++);
-				{
-					v8::String::AsciiValue knownId(knownList->Get(i)->ToString());
-					(*pip)["http://webinos.org/subject/id/known"]->push_back(*knownId);
-				}
-			}
+		if (args.Length() > 1 && args[1]->IsFunction()) {
+			AsyncReload* job = new AsyncReload();
+			job->work.data = job;
+			job->owner = pmtmp;
+			job->fileName = pmtmp->policyFileName;
+			job->pip = pip;
+			job->pm = NULL;
+			job->sequence = sequence;
+			job->self = Persistent<Object>::New(args.This());
+			job->callback = Persistent<Function>::New(Local<Function>::Cast(args[1]));
 
-			pmtmp->pminst = new PolicyManager(pmtmp->policyFileName, pip);
+			uv_queue_work(uv_default_loop(), &job->work, ReloadWork, ReloadDone);
 		}
 		else {
-			LOGD("Missing argument");
-			return ThrowException(Exception::TypeError(String::New("Missing argument")));
+			pmtmp->publish(new PolicyManager(pmtmp->policyFileName, pip), sequence);
 		}
 
 		Local<Integer> result = Integer::New(0);
 		
 		return scope.Close(result);
 	}
+
+	// worker thread: no V8 calls here
+	static void ReloadWork(uv_work_t* work)  {
+		AsyncReload* job = static_cast<AsyncReload*>(work->data);
+		job->pm = new PolicyManager(job->fileName, job->pip);
+	}
+
+#if NODE_VERSION_AT_LEAST(0, 10, 0)
+	static void ReloadDone(uv_work_t* work, int status)  {
+#else
+	static void ReloadDone(uv_work_t* work)  {
+#endif
+		HandleScope scope;
+		AsyncReload* job = static_cast<AsyncReload*>(work->data);
+
+		job->owner->publish(job->pm, job->sequence);
+		MakeCallback(job->self, job->callback, 0, NULL);
+
+		job->callback.Dispose();
+		job->self.Dispose();
+		delete job;
+	}
+
+	/* Replace the policy in use, unless a later reload already did.
+	 * pminst is only read and written on the JS thread, and evaluations
+	 * running elsewhere hold the instance they started with (see
+	 * acquire), so the previous one is deleted once they are all done.
+	 * A reloaded policy keeps the evaluation mode of the constructor.
+	 * */
+	void publish(PolicyManager* pm, unsigned int sequence)  {
+		if (sequence < published) {
+			delete pm;
+			return;
+		}
+		pm->setEvaluationMode(mode);
+		PolicyManager* previous = pminst;
+		pminst = pm;
+		published = sequence;
+		retire(previous);
+	}
 	
 	
 	static Handle<Value> GetPolicyFilename(const Arguments& args)  {
@@ -686,15 +864,350 @@ public:
 		
 		return scope.Close(result);
 	}
+
+	/* getStatistics()
+	 * {cacheHits, cacheMisses, arenaPeak} of the loaded policy, arenaPeak
+	 * being the most bytes an evaluation arena held.
+	 * */
+	static Handle<Value> GetStatistics(const Arguments& args)  {
+		HandleScope scope;
+
+		PolicyManagerInt* pmtmp = ObjectWrap::Unwrap<PolicyManagerInt>(args.This());
+		PolicyStatistics stats = pmtmp->pminst->getStatistics();
+
+		Local<Object> result = Object::New();
+		result->Set(String::New("cacheHits"), Number::New(stats.cacheHits));
+		result->Set(String::New("cacheMisses"), Number::New(stats.cacheMisses));
+		result->Set(String::New("arenaPeak"), Number::New(stats.arenaPeak));
+		return scope.Close(result);
+	}
+
+	/* getReferencedAttributes()
+	 * Names of the request attributes the loaded policy can look at
+	 * (e.g. "user-id", "timemin"); api-feature is always there. null if
+	 * the policy did not load, when nothing can be left out. Requests are
+	 * only read for these attributes, so callers can skip computing the
+	 * others.
+	 * */
+	static Handle<Value> GetReferencedAttributes(const Arguments& args)  {
+		HandleScope scope;
+
+		PolicyManagerInt* pmtmp = ObjectWrap::Unwrap<PolicyManagerInt>(args.This());
+		const AttributeReferences* refs = pmtmp->pminst->getReferences();
+		if (refs == NULL)
+			return scope.Close(Null());
+
+		Local<Array> result = Array::New();
+		unsigned int n = 0;
+		for (int i = 0; i < ATTR_COUNT; i++) {
+			if (attribute_referenced(refs, i))
+				result->Set(n++, String::New(attribute2string((AttributeId) i)));
+		}
+		for (unsigned int i = 0; i < refs->otherSubjects.size(); i++)
+			result->Set(n++, String::New(refs->otherSubjects[i].c_str()));
+
+		return scope.Close(result);
+	}
+
+	/* getMatchErrors()
+	 * "value: reason" for each regexp or glob value of the loaded policy
+	 * that did not compile and so matches no request.
+	 * */
+	static Handle<Value> GetMatchErrors(const Arguments& args)  {
+		HandleScope scope;
+
+		PolicyManagerInt* pmtmp = ObjectWrap::Unwrap<PolicyManagerInt>(args.This());
+		vector<string> errors = pmtmp->pminst->getMatchErrors();
+
+		Local<Array> result = Array::New(errors.size());
+		for (unsigned int i = 0; i < errors.size(); i++)
+			result->Set(i, String::New(errors[i].c_str()));
+
+		return scope.Close(result);
+	}
 	
 	
 };
 
 Persistent<FunctionTemplate> PolicyManagerInt::s_ct;
 
+
+// new PolicyRequest(request)
+Handle<Value> PolicyRequestInt::New(const Arguments& args)  {
+	HandleScope scope;
+
+	if (args.Length() < 1) {
+		return ThrowException(Exception::TypeError(String::New("Argument missing")));
+	}
+
+	if (!args[0]->IsObject() || IsInstance(args[0])) {
+		return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+	}
+
+	PolicyRequestInt* reqtmp = new PolicyRequestInt();
+	reqtmp->request = PolicyManagerInt::NewRequest(args[0]->ToObject());
+	reqtmp->Wrap(args.This());
+	return args.This();
+}
+
+/* Native request for an enforceRequest argument: the one held by a
+ * PolicyRequest, or a new one with the attributes in refs that the caller
+ * deletes (owned).
+ * */
+Request* PolicyRequestInt::Get(Handle<Value> value, const AttributeReferences* refs, bool& owned)  {
+	owned = !IsInstance(value);
+	if (owned)
+		return PolicyManagerInt::NewRequest(value->ToObject(), refs);
+	return ObjectWrap::Unwrap<PolicyRequestInt>(value->ToObject())->request;
+}
+
+
+/* Root policy (rootPolicy.xml) with the policy files it includes, so that
+ * lib/rootPm.js gets a whole decision from a single enforceRequest call.
+ * The included files are evaluated by the PolicyManagerInt instances
+ * rootPm.js loaded and schema-checked, set with setPolicyManager and
+ * setAppPolicyManager: each file is parsed and cached once.
+ * */
+class RootPolicyManagerInt: ObjectWrap{
+
+private:
+	map<string, Persistent<Object> > included;	// PolicyManagerInt set, kept alive
+
+public:
+	RootPolicyManager* rootinst;
+	string rootPolicyFileName;
+	static Persistent<FunctionTemplate> s_ct;
+
+	static void Init(Handle<Object> target)  {
+		HandleScope scope;
+
+		Local<FunctionTemplate> t = FunctionTemplate::New(New);
+		s_ct = Persistent<FunctionTemplate>::New(t);
+		s_ct->InstanceTemplate()->SetInternalFieldCount(1);
+		s_ct->SetClassName(String::NewSymbol("RootPolicyManagerInt"));
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "enforceRequest", EnforceRequest);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "enforceRequestBuffer", EnforceRequestBuffer);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "enforceRequests", EnforceRequests);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "setPolicyManager", SetPolicyManager);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "setAppPolicyManager", SetAppPolicyManager);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "isValid", IsValid);
+		NODE_SET_PROTOTYPE_METHOD(s_ct, "getPolicyFilename", GetPolicyFilename);
+		target->Set(String::NewSymbol("RootPolicyManagerInt"),
+		s_ct->GetFunction());
+	}
+
+	RootPolicyManagerInt() :    rootinst(NULL)  {
+	}
+
+	~RootPolicyManagerInt()  {
+		delete rootinst;
+		for (map<string, Persistent<Object> >::iterator it = included.begin(); it != included.end(); it++)
+			it->second.Dispose();
+	}
+
+	// new RootPolicyManagerInt(rootPolicyFile)
+	static Handle<Value> New(const Arguments& args)  {
+		HandleScope scope;
+
+		if (args.Length() < 1) {
+			LOGD("Missing parameter");
+			return ThrowException(Exception::TypeError(String::New("Missing argument")));
+		}
+		if (!args[0]->IsString()) {
+			LOGD("Wrong parameter type");
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+
+		RootPolicyManagerInt* rpmtmp = new RootPolicyManagerInt();
+		v8::String::AsciiValue tmpFileName(args[0]->ToString());
+		LOGD("Root policy file: %s", *tmpFileName);
+		rpmtmp->rootPolicyFileName = *tmpFileName;
+		rpmtmp->rootinst = new RootPolicyManager(rpmtmp->rootPolicyFileName);
+		rpmtmp->Wrap(args.This());
+		return args.This();
+	}
+
+	/* Keeps pm alive under key and returns the slot of its policy in use,
+	 * NULL if pm is not a PolicyManagerInt.
+	 * */
+	PolicyManager* const* Include(const string& key, Handle<Value> pm)  {
+		if (!pm->IsObject() || !PolicyManagerInt::s_ct->HasInstance(pm))
+			return NULL;
+		map<string, Persistent<Object> >::iterator it = included.find(key);
+		if (it != included.end())
+			it->second.Dispose();
+		included[key] = Persistent<Object>::New(pm->ToObject());
+		return &ObjectWrap::Unwrap<PolicyManagerInt>(pm->ToObject())->pminst;
+	}
+
+	// setPolicyManager(entity, policyManagerInt), for the files other than "app"
+	static Handle<Value> SetPolicyManager(const Arguments& args)  {
+		HandleScope scope;
+
+		if (args.Length() < 2) {
+			return ThrowException(Exception::TypeError(String::New("Argument missing")));
+		}
+
+		if (!args[0]->IsString()) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+
+		RootPolicyManagerInt* rpmtmp = ObjectWrap::Unwrap<RootPolicyManagerInt>(args.This());
+		v8::String::Utf8Value name(args[0]->ToString());
+		PolicyManager* const* pm = rpmtmp->Include(string("file:") + *name, args[1]);
+		if (pm == NULL) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+		rpmtmp->rootinst->setManager(*name, pm);
+
+		return scope.Close(Undefined());
+	}
+
+	// setAppPolicyManager(appId, policyManagerInt), for the "app" file of appId
+	static Handle<Value> SetAppPolicyManager(const Arguments& args)  {
+		HandleScope scope;
+
+		if (args.Length() < 2) {
+			return ThrowException(Exception::TypeError(String::New("Argument missing")));
+		}
+
+		if (!args[0]->IsString()) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+
+		RootPolicyManagerInt* rpmtmp = ObjectWrap::Unwrap<RootPolicyManagerInt>(args.This());
+		v8::String::Utf8Value appId(args[0]->ToString());
+		PolicyManager* const* pm = rpmtmp->Include(string("app:") + *appId, args[1]);
+		if (pm == NULL) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+		rpmtmp->rootinst->setAppManager(*appId, pm);
+
+		return scope.Close(Undefined());
+	}
+
+	static Handle<Value> EnforceRequest(const Arguments& args)  {
+		HandleScope scope;
+
+		if (args.Length() < 1) {
+			return ThrowException(Exception::TypeError(String::New("Argument missing")));
+		}
+
+		if (!args[0]->IsObject()) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+
+		RootPolicyManagerInt* rpmtmp = ObjectWrap::Unwrap<RootPolicyManagerInt>(args.This());
+
+		bool owned;
+		// application policies are only known once loaded: read everything
+		Request* myReq = PolicyRequestInt::Get(args[0], NULL, owned);
+		Effect myEff = rpmtmp->rootinst->checkRequest(myReq);
+		if (owned)
+			delete myReq;
+
+		LOGD("Root effect: %d", myEff);
+		Local<Integer> result = Integer::New(myEff);
+		return scope.Close(result);
+	}
+
+	// enforceRequestBuffer(buffer), buffer from lib/requestEncoder.js
+	static Handle<Value> EnforceRequestBuffer(const Arguments& args)  {
+		HandleScope scope;
+
+		if (args.Length() < 1) {
+			return ThrowException(Exception::TypeError(String::New("Argument missing")));
+		}
+
+		if (!Buffer::HasInstance(args[0])) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+
+		RootPolicyManagerInt* rpmtmp = ObjectWrap::Unwrap<RootPolicyManagerInt>(args.This());
+
+		Request* myReq = PolicyManagerInt::DecodeRequest(args[0], NULL);
+		if (myReq == NULL) {
+			return ThrowException(Exception::Error(String::New("Malformed request buffer")));
+		}
+		Effect myEff = rpmtmp->rootinst->checkRequest(myReq);
+		delete myReq;
+
+		LOGD("Root effect: %d", myEff);
+		Local<Integer> result = Integer::New(myEff);
+		return scope.Close(result);
+	}
+
+	/* enforceRequests(requests)
+	 * Evaluates an array of requests (objects or PolicyRequest instances)
+	 * in a single call and returns the effect of each one in a Uint8Array.
+	 * */
+	static Handle<Value> EnforceRequests(const Arguments& args)  {
+		HandleScope scope;
+
+		if (args.Length() < 1) {
+			return ThrowException(Exception::TypeError(String::New("Argument missing")));
+		}
+
+		if (!args[0]->IsArray()) {
+			return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+		}
+
+		RootPolicyManagerInt* rpmtmp = ObjectWrap::Unwrap<RootPolicyManagerInt>(args.This());
+		v8::Local<Array> reqArray = v8::Local<Array>::Cast(args[0]);
+		unsigned int count = reqArray->Length();
+
+		for (unsigned int i = 0; i < count; i++) {
+			if (!reqArray->Get(i)->IsObject()) {
+				return ThrowException(Exception::TypeError(String::New("Bad type argument")));
+			}
+		}
+
+		v8::Local<Function> typedArray = v8::Local<Function>::Cast(
+				Context::GetCurrent()->Global()->Get(String::NewSymbol("Uint8Array")));
+		Handle<Value> argv[1];
+		argv[0] = Integer::NewFromUnsigned(count);
+		Local<Object> result = typedArray->NewInstance(1, argv);
+		unsigned char* data = static_cast<unsigned char*>(result->GetIndexedPropertiesExternalArrayData());
+
+		for (unsigned int i = 0; i < count; i++) {
+			bool owned;
+			// application policies are only known once loaded: read everything
+			Request* myReq = PolicyRequestInt::Get(reqArray->Get(i), NULL, owned);
+			data[i] = rpmtmp->rootinst->checkRequest(myReq);
+			if (owned)
+				delete myReq;
+		}
+
+		return scope.Close(result);
+	}
+
+	static Handle<Value> IsValid(const Arguments& args)  {
+		HandleScope scope;
+
+		RootPolicyManagerInt* rpmtmp = ObjectWrap::Unwrap<RootPolicyManagerInt>(args.This());
+
+		return scope.Close(Boolean::New(rpmtmp->rootinst->isValid()));
+	}
+
+	static Handle<Value> GetPolicyFilename(const Arguments& args)  {
+		HandleScope scope;
+
+		RootPolicyManagerInt* rpmtmp = ObjectWrap::Unwrap<RootPolicyManagerInt>(args.This());
+
+		Local<String> result = String::New(rpmtmp->rootPolicyFileName.c_str());
+		
+		return scope.Close(result);
+	}
+};
+
+Persistent<FunctionTemplate> RootPolicyManagerInt::s_ct;
+
 extern "C" {
 	static void init (Handle<Object> target)  {
+		InitNames();
+		PolicyRequestInt::Init(target);
 		PolicyManagerInt::Init(target);  
+		RootPolicyManagerInt::Init(target);
 	}
 	NODE_MODULE(pm, init);
 } 
@@ -0,0 +1,399 @@
+/*******************************************************************************
+*  Code contributed to the webinos project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright 2013 Telecom Italia SpA
+*******************************************************************************/
+
+// Entry points of the native module other than enforceRequest, each
+// checked against enforceRequest of a separate instance on the policies
+// of this directory.
+
+var path = require("path");
+var encoder = require("../../lib/requestEncoder.js");
+var pmNative;
+try {
+	pmNative = require("pm");
+} catch (err) {
+	pmNative = require(path.join(__dirname, "../../build/Release/pm.node"));
+}
+
+var policyList = [
+	"policy-allow-all.xml",
+	"policy-deny-1.xml",
+	"policy-deny-prompt.xml",
+	"policy-first-1.xml",
+	"policy-first-2.xml",
+	"policy-logic-1.xml",
+	"policy-logic-3.xml",
+	"policy-logic-5.xml",
+	"policy-logic-7.xml",
+	"policy-logic-9.xml",
+	"policy-manufacturer-1.xml",
+	"policy-permit-1.xml",
+	"policy-permit-prompt.xml"
+	];
+
+var pip = {
+	"http://webinos.org/subject/id/PZ-Owner": "user1",
+	"http://webinos.org/subject/id/known": ["user2", "user3"]
+	};
+
+function ownerPip(owner) {
+	return {
+		"http://webinos.org/subject/id/PZ-Owner": owner,
+		"http://webinos.org/subject/id/known": []
+		};
+}
+
+var requests = [];
+["user1", "user2", "user3", "user4"].forEach(function(userId) {
+	["cert1", "cert2"].forEach(function(certCn) {
+		["http://webinos.org/api/w3c/geolocation", "http://webinos.org/api/messaging.send",
+				"http://mega.org/api/secret1", "http://mega.org/api/open1"].forEach(function(feature) {
+			["device1", "device2", "device3"].forEach(function(deviceId) {
+				requests.push({
+					subjectInfo: { userId: userId },
+					widgetInfo: { distributorKeyCn: certCn },
+					deviceInfo: { requestorId: deviceId },
+					resourceInfo: { apiFeature: feature }
+				});
+			});
+		});
+	});
+});
+
+function policyFile(name) {
+	return path.join(__dirname, name);
+}
+
+// effects enforceRequest gives for requests, on an instance of its own
+function expectedEffects(name, info) {
+	var pm = new pmNative.PolicyManagerInt(policyFile(name), info || pip);
+	return requests.map(function(req) { return pm.enforceRequest(req); });
+}
+
+// what fn throws, null if nothing
+function thrown(fn) {
+	try {
+		fn();
+	} catch (err) {
+		return err;
+	}
+	return null;
+}
+
+// policy granting the PZ owner, to tell which pip a reload used
+var ownerPolicy = "native-owner.xml";
+var ownerRequest = {
+	subjectInfo: { userId: "user2" },
+	deviceInfo: { requestorId: "device1" },
+	resourceInfo: { apiFeature: "http://webinos.org/api/w3c/geolocation" }
+	};
+
+function ownerEffect(owner) {
+	return new pmNative.PolicyManagerInt(policyFile(ownerPolicy), ownerPip(owner)).enforceRequest(ownerRequest);
+}
+
+describe("Native.PolicyManagerInt", function() {
+
+	policyList.forEach(function(name) {
+
+		it("enforceRequests matches enforceRequest on " + name, function() {
+			var expected = expectedEffects(name);
+			var pm = new pmNative.PolicyManagerInt(policyFile(name), pip);
+			var paths = [];
+			var effects = pm.enforceRequests(requests, paths);
+			expect(effects.length).toEqual(requests.length);
+			expect(paths.length).toEqual(requests.length);
+			for (var i = 0; i < requests.length; i++) {
+				expect(effects[i]).toEqual(expected[i]);
+				var pathObj = {};
+				pm.enforceRequest(requests[i], pathObj);
+				expect(paths[i]).toEqual(pathObj.path);
+			}
+		});
+
+		it("enforceRequests on threads matches enforceRequest on " + name, function() {
+			var expected = expectedEffects(name);
+			var pm = new pmNative.PolicyManagerInt(policyFile(name), pip, { threads: 4 });
+			var effects = pm.enforceRequests(requests.concat(requests));
+			for (var i = 0; i < 2 * requests.length; i++)
+				expect(effects[i]).toEqual(expected[i % requests.length]);
+		});
+
+		it("vector mode matches enforceRequest on " + name, function() {
+			var expected = expectedEffects(name);
+			var pm = new pmNative.PolicyManagerInt(policyFile(name), pip, { mode: "vector" });
+			for (var i = 0; i < requests.length; i++)
+				expect(pm.enforceRequest(requests[i])).toEqual(expected[i]);
+			// a reloaded policy keeps the mode
+			pm.reloadPolicy(pip);
+			expect(pm.enforceRequests(requests)).toEqual(expected);
+		});
+
+		it("enforceRequestBuffer matches enforceRequest on " + name, function() {
+			var expected = expectedEffects(name);
+			var pm = new pmNative.PolicyManagerInt(policyFile(name), pip);
+			for (var i = 0; i < requests.length; i++)
+				expect(pm.enforceRequestBuffer(encoder.encode(requests[i]))).toEqual(expected[i]);
+		});
+
+		it("PolicyRequest matches enforceRequest on " + name, function() {
+			var expected = expectedEffects(name);
+			var pm = new pmNative.PolicyManagerInt(policyFile(name), pip);
+			var other = new pmNative.PolicyManagerInt(policyFile(name), pip);
+			for (var i = 0; i < requests.length; i++) {
+				var nativeRequest = new pmNative.PolicyRequest(requests[i]);
+				expect(pm.enforceRequest(nativeRequest)).toEqual(expected[i]);
+				expect(other.enforceRequest(nativeRequest)).toEqual(expected[i]);
+			}
+		});
+
+		it("enforceRequestAsync matches enforceRequest on " + name, function() {
+			var expected = expectedEffects(name);
+			var pm = new pmNative.PolicyManagerInt(policyFile(name), pip);
+			var effects = [];
+			var done = 0;
+			runs(function() {
+				requests.forEach(function(req, i) {
+					pm.enforceRequestAsync(req, function(effect, policyPath) {
+						effects[i] = effect;
+						expect(typeof policyPath).toEqual("string");
+						done++;
+					});
+				});
+			});
+			waitsFor(function() { return done == requests.length; }, "async requests", 5000);
+			runs(function() {
+				for (var i = 0; i < requests.length; i++)
+					expect(effects[i]).toEqual(expected[i]);
+			});
+		});
+	});
+
+	it("rejects a PolicyRequest in enforceRequests and enforceRequestAsync", function() {
+		var pm = new pmNative.PolicyManagerInt(policyFile("policy-allow-all.xml"), pip);
+		var nativeRequest = new pmNative.PolicyRequest(requests[0]);
+		expect(thrown(function() { pm.enforceRequests([requests[0], nativeRequest]); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { pm.enforceRequestAsync(nativeRequest, function() {}); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { pm.enforceRequests(requests[0]); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { pm.enforceRequestAsync(requests[0]); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { new pmNative.PolicyRequest(nativeRequest); }) instanceof TypeError).toBe(true);
+		// the batch still works after a rejected one
+		expect(pm.enforceRequests([requests[0]])[0]).toEqual(pm.enforceRequest(requests[0]));
+	});
+
+	it("rejects a number of threads that is not a positive integer", function() {
+		var bad = [0, -2, 1.5, "4", null];
+		for (var i = 0; i < bad.length; i++) {
+			expect(thrown(function() {
+				new pmNative.PolicyManagerInt(policyFile("policy-allow-all.xml"), pip, { threads: bad[i] });
+			}) instanceof TypeError).toBe(true);
+		}
+		// more threads than processors are capped, not refused
+		var pm = new pmNative.PolicyManagerInt(policyFile("policy-allow-all.xml"), pip, { threads: 1024 });
+		expect(pm.enforceRequests(requests)).toEqual(expectedEffects("policy-allow-all.xml"));
+	});
+
+	it("rejects an unknown evaluation mode", function() {
+		expect(thrown(function() {
+			new pmNative.PolicyManagerInt(policyFile("policy-allow-all.xml"), pip, { mode: "eager" });
+		}) instanceof TypeError).toBe(true);
+		var pm = new pmNative.PolicyManagerInt(policyFile("policy-allow-all.xml"), pip, { mode: "lazy" });
+		expect(pm.enforceRequest(requests[0])).toEqual(expectedEffects("policy-allow-all.xml")[0]);
+	});
+
+	it("rejects malformed request buffers", function() {
+		var pm = new pmNative.PolicyManagerInt(policyFile("policy-allow-all.xml"), pip);
+		var good = encoder.encode(requests[0]);
+		var truncated = good.slice(0, good.length - 1);
+		var badVersion = new Buffer(good.length);
+		good.copy(badVersion);
+		badVersion[0] = 0;
+
+		expect(thrown(function() { pm.enforceRequestBuffer(requests[0]); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { pm.enforceRequestBuffer(new Buffer(0)); }) instanceof Error).toBe(true);
+		expect(thrown(function() { pm.enforceRequestBuffer(truncated); }) instanceof Error).toBe(true);
+		expect(thrown(function() { pm.enforceRequestBuffer(badVersion); }) instanceof Error).toBe(true);
+		expect(encoder.encode({ obligations: [] })).toBeNull();
+		expect(pm.enforceRequestBuffer(good)).toEqual(pm.enforceRequest(requests[0]));
+	});
+
+	it("counts cache hits and misses in getStatistics", function() {
+		var pm = new pmNative.PolicyManagerInt(policyFile("policy-logic-1.xml"), pip);
+		var stats = pm.getStatistics();
+		expect(stats.cacheHits).toEqual(0);
+		expect(stats.cacheMisses).toEqual(0);
+		pm.enforceRequest(requests[0]);
+		pm.enforceRequest(requests[0]);
+		pm.enforceRequest(requests[1]);
+		stats = pm.getStatistics();
+		expect(stats.cacheHits).toEqual(1);
+		expect(stats.cacheMisses).toEqual(2);
+		pm.enforceRequest(requests[2], {});
+		expect(pm.getStatistics().arenaPeak).toBeGreaterThan(0);
+	});
+
+	it("lists the attributes a policy reads in getReferencedAttributes", function() {
+		var pm = new pmNative.PolicyManagerInt(policyFile("policy-first-1.xml"), pip);
+		expect(pm.getReferencedAttributes().sort()).toEqual(["api-feature", "requestor-id"]);
+		pm = new pmNative.PolicyManagerInt(policyFile("policy-manufacturer-1.xml"), pip);
+		expect(pm.getReferencedAttributes().sort()).toEqual(["api-feature", "distributor-key-cn", "requestor-id", "user-id"]);
+		pm = new pmNative.PolicyManagerInt(policyFile("no-such-policy.xml"), pip);
+		expect(pm.getReferencedAttributes()).toBeNull();
+	});
+
+	it("lists no match errors for well formed policies", function() {
+		policyList.forEach(function(name) {
+			expect(new pmNative.PolicyManagerInt(policyFile(name), pip).getMatchErrors()).toEqual([]);
+		});
+	});
+
+	it("keeps the latest of overlapping asynchronous reloads", function() {
+		var pm = new pmNative.PolicyManagerInt(policyFile(ownerPolicy), ownerPip("user1"));
+		var calls = [];
+		runs(function() {
+			expect(ownerEffect("user2")).not.toEqual(ownerEffect("user3"));
+			pm.reloadPolicy(ownerPip("user2"), function() { calls.push(2); });
+			pm.reloadPolicy(ownerPip("user3"), function() { calls.push(3); });
+			// the policy in use only changes on the JS thread
+			expect(pm.enforceRequest(ownerRequest)).toEqual(ownerEffect("user1"));
+		});
+		waitsFor(function() { return calls.length == 2; }, "reloads", 5000);
+		runs(function() {
+			expect(pm.enforceRequest(ownerRequest)).toEqual(ownerEffect("user3"));
+		});
+	});
+
+	it("keeps a synchronous reload made after an asynchronous one", function() {
+		var pm = new pmNative.PolicyManagerInt(policyFile(ownerPolicy), ownerPip("user1"));
+		var done = false;
+		runs(function() {
+			pm.reloadPolicy(ownerPip("user2"), function() { done = true; });
+			pm.reloadPolicy(ownerPip("user3"));
+			expect(pm.enforceRequest(ownerRequest)).toEqual(ownerEffect("user3"));
+		});
+		waitsFor(function() { return done; }, "reload", 5000);
+		runs(function() {
+			expect(pm.enforceRequest(ownerRequest)).toEqual(ownerEffect("user3"));
+		});
+	});
+
+	it("evaluates async requests started before a reload with the previous policy", function() {
+		var pm = new pmNative.PolicyManagerInt(policyFile(ownerPolicy), ownerPip("user2"));
+		var effect = -1;
+		var reloaded = false;
+		runs(function() {
+			pm.enforceRequestAsync(ownerRequest, function(eff) { effect = eff; });
+			pm.reloadPolicy(ownerPip("user3"), function() { reloaded = true; });
+		});
+		waitsFor(function() { return effect >= 0 && reloaded; }, "request and reload", 5000);
+		runs(function() {
+			expect(effect).toEqual(ownerEffect("user2"));
+			expect(pm.enforceRequest(ownerRequest)).toEqual(ownerEffect("user3"));
+		});
+	});
+});
+
+// combination of lib/rootPm.js for rootPolicy.xml of this directory:
+// Deny-overrides of the included files inside Deny-unless-permit-or-prompt
+var LUT_do = [
+	[0, 1, 2, 3, 4, 5, 0],
+	[1, 1, 1, 1, 1, 1, 1],
+	[2, 1, 2, 2, 2, 5, 2],
+	[3, 1, 2, 3, 3, 5, 3],
+	[4, 1, 2, 3, 4, 5, 4],
+	[5, 5, 5, 5, 5, 5, 5],
+	[0, 1, 2, 3, 4, 5, 6]
+	];
+
+function rootEffect(effects) {
+	var res = effects.reduce(function(res, effect) { return LUT_do[res][effect]; }, 6);
+	return (res > 4) ? 1 : res;
+}
+
+describe("Native.RootPolicyManagerInt", function() {
+
+	var rootFile = policyFile("rootPolicy.xml");
+	var appRequests = requests.map(function(req) {
+		return {
+			subjectInfo: req.subjectInfo,
+			widgetInfo: { id: "app1", distributorKeyCn: req.widgetInfo.distributorKeyCn },
+			deviceInfo: req.deviceInfo,
+			resourceInfo: req.resourceInfo
+		};
+	});
+
+	it("evaluates the included files with the policy managers set", function() {
+		var root = new pmNative.RootPolicyManagerInt(rootFile);
+		var manufacturer = new pmNative.PolicyManagerInt(policyFile("policy-manufacturer-1.xml"), pip);
+		var user = new pmNative.PolicyManagerInt(policyFile("policy-logic-1.xml"), pip);
+		var app = new pmNative.PolicyManagerInt(policyFile("policy-deny-prompt.xml"), pip);
+		expect(root.isValid()).toBe(true);
+
+		// nothing set: every file is inapplicable
+		expect(root.enforceRequest(appRequests[0])).toEqual(1);
+
+		root.setPolicyManager("manufacturer", manufacturer);
+		root.setPolicyManager("user", user);
+		appRequests.forEach(function(req) {
+			expect(root.enforceRequest(req)).toEqual(rootEffect([manufacturer.enforceRequest(req), user.enforceRequest(req)]));
+		});
+
+		// app policies only count for the application they are set for
+		root.setAppPolicyManager("app1", app);
+		appRequests.forEach(function(req, i) {
+			expect(root.enforceRequest(req)).toEqual(rootEffect([manufacturer.enforceRequest(req),
+					user.enforceRequest(req), app.enforceRequest(req)]));
+			expect(root.enforceRequest(requests[i])).toEqual(rootEffect([manufacturer.enforceRequest(requests[i]),
+					user.enforceRequest(requests[i])]));
+		});
+	});
+
+	it("enforceRequests matches enforceRequest", function() {
+		var root = new pmNative.RootPolicyManagerInt(rootFile);
+		root.setPolicyManager("manufacturer", new pmNative.PolicyManagerInt(policyFile("policy-manufacturer-1.xml"), pip));
+		root.setPolicyManager("user", new pmNative.PolicyManagerInt(policyFile("policy-logic-1.xml"), pip));
+		root.setAppPolicyManager("app1", new pmNative.PolicyManagerInt(policyFile("policy-deny-prompt.xml"), pip));
+		var batch = appRequests.concat(requests, [new pmNative.PolicyRequest(appRequests[0])]);
+		var effects = root.enforceRequests(batch);
+		expect(effects.length).toEqual(batch.length);
+		for (var i = 0; i < batch.length; i++)
+			expect(effects[i]).toEqual(root.enforceRequest(batch[i]));
+		expect(root.enforceRequests([]).length).toEqual(0);
+		expect(thrown(function() { root.enforceRequests(requests[0]); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { root.enforceRequests([requests[0], 1]); }) instanceof TypeError).toBe(true);
+	});
+
+	it("follows a reload of a policy manager it was set", function() {
+		var root = new pmNative.RootPolicyManagerInt(rootFile);
+		var user = new pmNative.PolicyManagerInt(policyFile(ownerPolicy), ownerPip("user2"));
+		root.setPolicyManager("user", user);
+		expect(root.enforceRequest(ownerRequest)).toEqual(rootEffect([ownerEffect("user2")]));
+		user.reloadPolicy(ownerPip("user3"));
+		expect(root.enforceRequest(ownerRequest)).toEqual(rootEffect([ownerEffect("user3")]));
+	});
+
+	it("only takes PolicyManagerInt instances", function() {
+		var root = new pmNative.RootPolicyManagerInt(rootFile);
+		var user = new pmNative.PolicyManagerInt(policyFile("policy-allow-all.xml"), pip);
+		expect(thrown(function() { root.setPolicyManager("user", {}); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { root.setPolicyManager("user", new pmNative.PolicyRequest(requests[0])); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { root.setAppPolicyManager("app1"); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { root.setAppPolicyManager(1, user); }) instanceof TypeError).toBe(true);
+		expect(thrown(function() { new pmNative.RootPolicyManagerInt(); }) instanceof TypeError).toBe(true);
+		expect(new pmNative.RootPolicyManagerInt(policyFile("no-such-policy.xml")).isValid()).toBe(false);
+	});
+});
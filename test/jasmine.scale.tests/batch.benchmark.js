@@ -0,0 +1,102 @@
+/*******************************************************************************
+*  Code contributed to the webinos project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright 2013 Telecom Italia SpA
+*******************************************************************************/
+
+// Throughput of enforceRequests versus threads on the scale test policies.
+// Not a jasmine spec, run it with: node batch.benchmark.js [rounds]
+//
+// Each batch is an application install check: 60 features for each of
+// 20 known devices. The policy is reloaded before every round so that the
+// decision cache starts empty and every request is really evaluated.
+
+var os = require("os");
+var path = require("path");
+var pmNative;
+try {
+	pmNative = require("pm");
+} catch (err) {
+	pmNative = require(path.join(__dirname, "../../build/Release/pm.node"));
+}
+
+var rounds = parseInt(process.argv[2], 10) || 5;
+
+var policyList = [
+	"policy-scale-6.xml",
+	"policy-scale-10a.xml",
+	"policy-scale-12a.xml",
+	"policy-scale-17a.xml",
+	"policy-scale-first-6.xml"
+	];
+
+var pip = {
+	"http://webinos.org/subject/id/PZ-Owner": "user1",
+	"http://webinos.org/subject/id/known": ["user2", "user3"]
+	};
+
+function installBatch(userId, certCn) {
+	var batch = [];
+	for (var d = 1; d <= 20; d++) {
+		for (var f = 1; f <= 60; f++) {
+			var feature = (f % 3 == 0) ? "http://webinos.org/api/w3c/geolocation"
+				: "http://mega.org/api/secret" + f;
+			batch.push({
+				subjectInfo: { userId: userId },
+				widgetInfo: { distributorKeyCn: certCn },
+				deviceInfo: { requestorId: "device" + d },
+				resourceInfo: { apiFeature: feature }
+			});
+		}
+	}
+	return batch;
+}
+
+function elapsedMs(start) {
+	var diff = process.hrtime(start);
+	return diff[0] * 1000 + diff[1] / 1000000;
+}
+
+var threadCounts = [];
+for (var t = 1; t <= os.cpus().length; t *= 2)
+	threadCounts.push(t);
+if (threadCounts[threadCounts.length - 1] != os.cpus().length)
+	threadCounts.push(os.cpus().length);
+
+var batches = [installBatch("user1", "cert1"), installBatch("user2", "cert2"), installBatch("user3", "cert3")];
+
+console.log("policy\tthreads\trequests/s\tspeedup");
+for (var p = 0; p < policyList.length; p++) {
+	var base = 0;
+	for (var i = 0; i < threadCounts.length; i++) {
+		var pm = new pmNative.PolicyManagerInt(path.join(__dirname, policyList[p]), pip,
+			{ threads: threadCounts[i] });
+		var requests = 0, ms = 0;
+		for (var r = 0; r < rounds; r++) {
+			pm.reloadPolicy(pip);
+			var start = process.hrtime();
+			for (var b = 0; b < batches.length; b++) {
+				pm.enforceRequests(batches[b]);
+				requests += batches[b].length;
+			}
+			ms += elapsedMs(start);
+		}
+		var throughput = requests * 1000 / ms;
+		if (i == 0)
+			base = throughput;
+		console.log(policyList[p] + "\t" + threadCounts[i] + "\t" + Math.round(throughput) +
+			"\t" + (throughput / base).toFixed(2));
+	}
+}
@@ -0,0 +1,94 @@
+/*******************************************************************************
+*  Code contributed to the webinos project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright 2013 Telecom Italia SpA
+*******************************************************************************/
+
+// Cost of handing a request to enforceRequest as an object versus as a
+// Buffer from lib/requestEncoder.js, encoded on every call or once.
+// Not a jasmine spec, run it with: node buffer.benchmark.js [rounds]
+
+var path = require("path");
+var encoder = require("../../lib/requestEncoder.js");
+var pmNative;
+try {
+	pmNative = require("pm");
+} catch (err) {
+	pmNative = require(path.join(__dirname, "../../build/Release/pm.node"));
+}
+
+var rounds = parseInt(process.argv[2], 10) || 5;
+
+var policyList = [
+	"policy-scale-6.xml",
+	"policy-scale-12a.xml",
+	"policy-scale-first-6.xml"
+	];
+
+var pip = {
+	"http://webinos.org/subject/id/PZ-Owner": "user1",
+	"http://webinos.org/subject/id/known": ["user2", "user3"]
+	};
+
+var requests = [];
+for (var d = 1; d <= 20; d++) {
+	for (var f = 1; f <= 60; f++) {
+		var feature = (f % 3 == 0) ? "http://webinos.org/api/w3c/geolocation"
+			: "http://mega.org/api/secret" + f;
+		requests.push({
+			subjectInfo: { userId: "user" + (1 + d % 3) },
+			widgetInfo: { distributorKeyCn: "cert" + (1 + d % 3) },
+			deviceInfo: { requestorId: "device" + d },
+			resourceInfo: { apiFeature: feature },
+			environmentInfo: { timemin: String(d * 60) }
+		});
+	}
+}
+var encoded = requests.map(encoder.encode);
+
+function elapsedMs(start) {
+	var diff = process.hrtime(start);
+	return diff[0] * 1000 + diff[1] / 1000000;
+}
+
+var modes = {
+	"object": function(pm, i) { return pm.enforceRequest(requests[i]); },
+	"encode+buffer": function(pm, i) { return pm.enforceRequestBuffer(encoder.encode(requests[i])); },
+	"buffer": function(pm, i) { return pm.enforceRequestBuffer(encoded[i]); }
+	};
+
+console.log("policy\tmode\trequests/s\tspeedup");
+for (var p = 0; p < policyList.length; p++) {
+	var pm = new pmNative.PolicyManagerInt(path.join(__dirname, policyList[p]), pip);
+	for (var i = 0; i < requests.length; i++) {
+		if (pm.enforceRequestBuffer(encoded[i]) != pm.enforceRequest(requests[i]))
+			console.log(policyList[p] + ": different effect for request " + i);
+	}
+	var base = 0;
+	for (var mode in modes) {
+		var ms = 0;
+		for (var r = 0; r < rounds; r++) {
+			var start = process.hrtime();
+			for (var i = 0; i < requests.length; i++)
+				modes[mode](pm, i);
+			ms += elapsedMs(start);
+		}
+		var throughput = requests.length * rounds * 1000 / ms;
+		if (base == 0)
+			base = throughput;
+		console.log(policyList[p] + "\t" + mode + "\t" + Math.round(throughput) +
+			"\t" + (throughput / base).toFixed(2));
+	}
+}
@@ -0,0 +1,116 @@
+/*******************************************************************************
+*  Code contributed to the webinos project
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* Copyright 2013 Telecom Italia SpA
+*******************************************************************************/
+
+// Throughput of the "lazy" and "vector" evaluation modes versus the
+// number of rules of the policy.
+// Not a jasmine spec, run it with: node vector.benchmark.js [rounds]
+//
+// The policies are generated in the temporary directory: one
+// first-applicable policy of N rules, rule k permitting feature k, then
+// a deny rule. A batch asks for each of the N features, which the lazy
+// mode finds at every depth of the policy, and for N features outside
+// it, which only the final deny decides. Decisions are cached per
+// request, so each round starts from a fresh reload: otherwise the
+// second round would time cache lookups, not the evaluation modes.
+
+var fs = require("fs");
+var os = require("os");
+var path = require("path");
+var pmNative;
+try {
+	pmNative = require("pm");
+} catch (err) {
+	pmNative = require(path.join(__dirname, "../../build/Release/pm.node"));
+}
+
+var rounds = parseInt(process.argv[2], 10) || 20;
+
+var ruleCounts = [4, 16, 64, 256, 1024];
+var modes = ["lazy", "vector"];
+
+var pip = {
+	"http://webinos.org/subject/id/PZ-Owner": "user1",
+	"http://webinos.org/subject/id/known": ["user2", "user3"]
+	};
+
+function feature(k) {
+	return "http://mega.org/api/feature" + k + ".open";
+}
+
+function writePolicy(rules) {
+	var xml = '<policy-set combine="first-matching-target" description="vector benchmark">\n' +
+		'\t<policy combine="first-applicable" description="' + rules + ' rules">\n';
+	for (var k = 0; k < rules; k++) {
+		xml += '\t\t<rule effect="permit">\n' +
+			'\t\t\t<condition combine="or">\n' +
+			'\t\t\t\t<resource-match attr="api-feature" match="' + feature(k) + '"/>\n' +
+			'\t\t\t</condition>\n' +
+			'\t\t</rule>\n';
+	}
+	xml += '\t\t<rule effect="deny"></rule>\n\t</policy>\n</policy-set>\n';
+	var fileName = path.join(os.tmpdir(), "policy-vector-" + rules + ".xml");
+	fs.writeFileSync(fileName, xml);
+	return fileName;
+}
+
+function requestBatch(rules) {
+	var batch = [];
+	for (var k = 0; k < 2 * rules; k++) {
+		batch.push({
+			subjectInfo: { userId: "user1" },
+			deviceInfo: { requestorId: "device1" },
+			resourceInfo: { apiFeature: feature(k) }
+		});
+	}
+	return batch;
+}
+
+function elapsedMs(start) {
+	var diff = process.hrtime(start);
+	return diff[0] * 1000 + diff[1] / 1000000;
+}
+
+console.log("rules\tmode\trequests/s\tspeedup");
+for (var n = 0; n < ruleCounts.length; n++) {
+	var fileName = writePolicy(ruleCounts[n]);
+	var batch = requestBatch(ruleCounts[n]);
+	var base = 0;
+	var expected = null;
+	for (var m = 0; m < modes.length; m++) {
+		var pm = new pmNative.PolicyManagerInt(fileName, pip, { mode: modes[m] });
+		var requests = 0, ms = 0, effects;
+		for (var r = 0; r < rounds; r++) {
+			pm.reloadPolicy(pip);
+			var start = process.hrtime();
+			effects = pm.enforceRequests(batch);
+			ms += elapsedMs(start);
+			requests += batch.length;
+		}
+		// both modes must give the same decisions
+		if (expected === null)
+			expected = effects;
+		else if (effects.join() != expected.join())
+			console.log("Warning! " + modes[m] + " decisions differ on " + ruleCounts[n] + " rules");
+		var throughput = requests * 1000 / ms;
+		if (m == 0)
+			base = throughput;
+		console.log(ruleCounts[n] + "\t" + modes[m] + "\t" + Math.round(throughput) +
+			"\t" + (throughput / base).toFixed(2));
+	}
+	fs.unlinkSync(fileName);
+}
@@ -0,0 +1,168 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "PolicyManager.h"
+#include "RequestBuilder.h"
+
+/* Every operator new of the process is counted while "counting" is set:
+ * once a request is built, PolicyManager::checkRequest must not allocate
+ * with a context that already served a request like it. That covers the
+ * policy program, the decision cache, the data handling preferences and
+ * the path. */
+static bool counting = false;
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) {
+	if (counting)
+		allocations++;
+	void* p = malloc(size ? size : 1);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) {
+	free(p);
+}
+
+void operator delete[](void* p) {
+	free(p);
+}
+
+static const char* features[] = {
+	"http://webinos.org/api/discovery",
+	"http://webinos.org/api/w3c/geolocation",
+	"http://webinos.org/api/messaging.send",
+	"http://webinos.org/api/nfc.read",
+	"http://cdi-api.org/test",
+};
+static const char* users[] = {"user1", "user2", "user3"};
+static const char* devices[] = {"device1", "device2", "device3"};
+static const char* companies[] = {"Company1", "Company2"};
+
+#define COUNT(a) (sizeof(a) / sizeof(a[0]))
+
+/* The request grid, with empty obligations: decisions are cached. With
+ * timed, the requests also take a TriggerAtTime obligation, whose decision
+ * depends on the clock and is never cached, so that every checkRequest
+ * evaluates the policy and its data handling preferences. */
+static void buildRequests(const AttributeReferences* refs, bool timed, vector<Request*>& reqs) {
+	for (unsigned int f = 0; f < COUNT(features); f++)
+	for (unsigned int u = 0; u < COUNT(users); u++)
+	for (unsigned int d = 0; d < COUNT(devices); d++) {
+		RequestBuilder builder(refs);
+		builder.add("resourceInfo", "apiFeature", features[f]);
+		builder.add("resourceInfo", "serviceId", "service1");
+		builder.add("subjectInfo", "userId", users[u]);
+		builder.add("deviceInfo", "requestorId", devices[d]);
+		builder.add("widgetInfo", "id", "app1");
+		builder.add("widgetInfo", "distributorKeyCn", companies[(f + u) % COUNT(companies)]);
+		builder.add("environmentInfo", "timemin", (d == 0) ? "480" : "1320");
+		builder.add("environmentInfo", "days-of-week", "2");
+		builder.add("environmentInfo", "days-of-month", "16");
+		vector<bool> purpose(arraysize(ontology_vector), true);
+		obligations obl;
+		if (timed) {
+			obligation o;
+			o.action["actionID"] = (u == 0) ? "ActionDeletePersonalData" : "ActionLog";
+			map<string, string> trigger;
+			trigger["triggerID"] = "TriggerAtTime";
+			trigger["StartTime"] = "StartNow";
+			trigger["MaxDelay"] = "P0Y0M5DT0H0M0S";
+			o.triggers.push_back(trigger);
+			obl.push_back(o);
+		}
+		reqs.push_back(builder.build(purpose, obl));
+	}
+}
+
+/* Allocations of the second round of checkRequest calls on file, the first
+ * one having warmed the context and the decision cache; -1 if the file is
+ * not a policy. */
+static long countAllocations(const char* file, int mode, bool withPath, bool timed) {
+	TiXmlDocument doc(file);
+	if (!doc.LoadFile())
+		return -1;
+	// root policies include the other files, see RootPolicyManager
+	TiXmlElement* element = doc.RootElement();
+	if (element == NULL || (element->ValueStr() != "policy" && element->ValueStr() != "policy-set"))
+		return -1;
+
+	map<string, vector<string>*> pip;
+	pip["http://webinos.org/subject/id/PZ-Owner"] = new vector<string>(1, "user1");
+	pip["http://webinos.org/subject/id/known"] = new vector<string>(1, "user2");
+	PolicyManager* pm = new PolicyManager(file, &pip);
+	pm->setEvaluationMode(mode);
+
+	vector<Request*> reqs;
+	buildRequests(pm->getReferences(), timed, reqs);
+
+	EvaluationContext context;
+	context.withPath = withPath;
+	for (unsigned int i = 0; i < reqs.size(); i++)
+		pm->checkRequest(reqs[i], context);
+
+	allocations = 0;
+	counting = true;
+	for (unsigned int i = 0; i < reqs.size(); i++)
+		pm->checkRequest(reqs[i], context);
+	counting = false;
+
+	for (unsigned int i = 0; i < reqs.size(); i++)
+		delete reqs[i];
+	delete pm;
+	delete pip["http://webinos.org/subject/id/PZ-Owner"];
+	delete pip["http://webinos.org/subject/id/known"];
+	return allocations;
+}
+
+int main(int argc, char** argv) {
+	int failures = 0, checked = 0;
+
+	for (int i = 1; i < argc; i++) {
+		for (int run = 0; run < 8; run++) {
+			int mode = (run & 1) ? EVALUATION_VECTOR : EVALUATION_LAZY;
+			bool withPath = (run & 2) != 0;
+			bool timed = (run & 4) != 0;
+			long count = countAllocations(argv[i], mode, withPath, timed);
+			if (count < 0)
+				break;
+			checked++;
+			if (count > 0) {
+				printf("FAIL %s (%s%s%s): %ld allocations\n", argv[i],
+						(mode == EVALUATION_LAZY) ? "lazy" : "vector",
+						withPath ? ", path" : "", timed ? ", uncached" : "", count);
+				failures++;
+			}
+		}
+	}
+	if (failures > 0 || checked == 0) {
+		printf("allocation: %d failures out of %d\n", failures, checked);
+		return 1;
+	}
+	printf("allocation: ok, %d runs\n", checked);
+	return 0;
+}
@@ -0,0 +1,174 @@
+/*******************************************************************************
+ *  Code contributed to the webinos project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright 2013 Telecom Italia SpA
+ *
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include "matcher.h"
+#include "PolicyManager.h"
+
+static int failures = 0;
+
+static void expect(const string& pattern, const char* target, bool expected) {
+	Matcher re;
+
+	if (!re.compile(pattern)) {
+		printf("FAIL /%s/ does not compile: %s\n", pattern.c_str(), re.getError().c_str());
+		failures++;
+		return;
+	}
+	if (re.match(target, strlen(target)) != expected) {
+		printf("FAIL /%s/ on \"%s\": expected %s\n", pattern.c_str(), target, expected ? "match" : "no match");
+		failures++;
+	}
+}
+
+static void expectError(const string& pattern) {
+	Matcher re;
+
+	if (re.compile(pattern) || re.isValid() || re.getError().empty()) {
+		printf("FAIL /%s/ compiles\n", pattern.c_str());
+		failures++;
+	}
+	else if (re.match("anything", 8)) {
+		printf("FAIL /%s/ does not compile but matches\n", pattern.c_str());
+		failures++;
+	}
+}
+
+static void anchoring() {
+	expect("foo", "a foo b", true);
+	expect("^foo", "foo b", true);
+	expect("^foo", "a foo", false);
+	expect("foo$", "a foo", true);
+	expect("foo$", "foo b", false);
+	expect("^foo$", "foo", true);
+	expect("^foo$", "foofoo", false);
+	expect("^http://www\\.example\\.com/.*$", "http://www.example.com/a/b", true);
+	expect("^http://www\\.example\\.com/.*$", "xhttp://www.example.com/", false);
+	expect("a|^b", "cb", false);
+	expect("a|^b", "bc", true);
+}
+
+// as with slre, an empty target only matches an anchored pattern
+static void emptyTarget() {
+	expect("^", "", true);
+	expect("^$", "", true);
+	expect("^.*", "", true);
+	expect(".*", "", false);
+	expect("a*", "", false);
+	expect("$", "", false);
+	expect("^a", "", false);
+}
+
+static void classes() {
+	expect("^[abc]+$", "abcba", true);
+	expect("^[abc]+$", "abd", false);
+	expect("^[^abc]+$", "xyz", true);
+	expect("^[^abc]+$", "xaz", false);
+	expect("^[a-f0-9]+$", "deadbeef42", true);
+	expect("^[a-f0-9]+$", "deadbeeg", false);
+	expect("^[a-]$", "-", true);
+	expect("^[\\d]+$", "2013", true);
+	expect("^\\d+$", "20x3", false);
+	expect("^\\w+$", "user_id9", true);
+	expect("^\\W$", "_", false);
+	expect("^\\s\\S$", " x", true);
+	expect("^[\\x41-\\x43]+$", "ABC", true);
+	expect("^[a-\\d]+$", "a-1", true);
+	expect("^a.c$", "a\nc", true);
+}
+
+// a trailing backslash and a range out of order are read as slre did
+static void slreLeniency() {
+	expect("a\\", "xa\\", true);
+	expect("a\\", "a", false);
+	expect("^b[a-\\\\]$", "ba", true);
+	expect("^b[a-\\\\]$", "b-", true);
+	expect("^b[a-\\\\]$", "b\\", true);
+	expect("^b[a-\\\\]$", "bb", false);
+	expect("^[z-a]$", "-", true);
+	expect("^[z-a]$", "m", false);
+	expectError("[.\\");
+	expectError("[abc");
+	expectError("(abc");
+	expectError("abc)");
+}
+
+static void alternation() {
+	expect("^(foo|bar)+baz$", "foobarfoobaz", true);
+	expect("^(?:foo|bar)baz$", "quxbaz", false);
+	expect("^a?b*c+$", "bbbc", true);
+	expect("^a?b*c+$", "aab", false);
+	expect("*foo", "a*foo", true);
+	expect("*foo", "foo", false);
+}
+
+/* Patterns over 64 * MATCHER_STACK_WORDS consuming states use heap state
+ * sets; matching must be the same either side of the limit. */
+static void largeStateSets() {
+	unsigned int sizes[] = {64 * MATCHER_STACK_WORDS - 1, 64 * MATCHER_STACK_WORDS,
+			64 * MATCHER_STACK_WORDS + 1, 2000};
+
+	for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		string literal;
+		for (unsigned int c = 0; c < sizes[i]; c++)
+			literal += (char) ('a' + c % 26);
+		string near = literal;
+		near[near.size() - 1] = '#';
+
+		expect("^" + literal + "$", literal.c_str(), true);
+		expect("^" + literal + "$", near.c_str(), false);
+		expect(literal, ("xx" + literal + "yy").c_str(), true);
+		// every state of the literal can be active at once
+		string alt = "^(?:" + literal + "|[a-z])*#$";
+		expect(alt, (literal + "#").c_str(), true);
+		expect(alt, (literal + "!").c_str(), false);
+	}
+}
+
+// values that do not compile are listed when the policy loads
+static void matchErrors() {
+	map<string, vector<string>*> pip;
+	PolicyManager pm("policy-match-errors.xml", &pip);
+	vector<string> errors = pm.getMatchErrors();
+
+	if (errors.size() != 2 || errors[0].find("[user: ") != 0 || errors[1].find("http://webinos.org/api/(: ") != 0) {
+		printf("FAIL getMatchErrors:");
+		for (unsigned int i = 0; i < errors.size(); i++)
+			printf(" \"%s\"", errors[i].c_str());
+		printf("\n");
+		failures++;
+	}
+}
+
+int main() {
+	anchoring();
+	emptyTarget();
+	classes();
+	slreLeniency();
+	alternation();
+	largeStateSets();
+	matchErrors();
+	if (failures > 0) {
+		printf("matcher: %d failures\n", failures);
+		return 1;
+	}
+	printf("matcher: ok\n");
+	return 0;
+}
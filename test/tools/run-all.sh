@@ -20,6 +20,9 @@
 # Fail if anything fails
 set -e
 
+# Run the native checks of the core
+make -C ./test/native check
+
 # Run the old tests
 cd ./test/jasmine
 jasmine-node .
@@ -123,26 +123,35 @@ function getPolicyTable() {
 	//console.log("getPolicyTable");
 	var policyTable = {};
 	var users = new Array();
+	// requests[i] asks for features[i], a cell of the table
+	var batch = { requests: new Array(), features: new Array() };
 
 	pm.reloadPolicy();
 
 	for(var i=0; i<subjectList.subjects.length; i++) {
-		var userTmp = getUserTable(subjectList.subjects[i].userid, subjectList.subjects[i].apps);
+		var userTmp = getUserTable(subjectList.subjects[i].userid, subjectList.subjects[i].apps, batch);
 		users.push(userTmp);
 	}
 
+	// every feature of the table is checked with a single call
+	pm.enforceRequests(batch.requests, function(effects) {
+		for(var i=0; i<effects.length; i++) {
+			batch.features[i].res = ruleEffectDescription(effects[i]);
+		}
+	});
+
 	policyTable.users = users;
 	return JSON.stringify(policyTable);
 }
 
 
-function getUserTable(userId, apps) {
+function getUserTable(userId, apps, batch) {
 	//console.log("getUserTable - "+userId);
 	var userData = {};
 	userData.id = userId;
 	var userApps = new Array();
 	for(var i=0; i<apps.length; i++) {
-		var appTmp = getAppTable(userId, apps[i].id);
+		var appTmp = getAppTable(userId, apps[i].id, batch);
 		userApps.push(appTmp);
 	}
 	userData.apps = userApps;
@@ -150,7 +159,8 @@ function getUserTable(userId, apps) {
 }
 
 
-function getAppTable(userId, app) {
+// the features of app, their res is set once the batch is enforced
+function getAppTable(userId, app, batch) {
 	//console.log("getAppTable - "+app);
 	var userApp = {};
 	userApp.id = app;
@@ -158,7 +168,8 @@ function getAppTable(userId, app) {
 	for(var i=0; i<featureList.features.length; i++) {
 		var featTmp = {};
 		featTmp.name = featureList.features[i].name;
-		featTmp.res = checkFeature(featureList.features[i].name, userId, app);
+		batch.requests.push(featureRequest(featTmp.name, userId, app));
+		batch.features.push(featTmp);
 		appFeatures.push(featTmp);
 	}
 	userApp.features = appFeatures;
@@ -166,8 +177,7 @@ function getAppTable(userId, app) {
 }
 
 
-function checkFeature(featureName, userId, appId) {
-	var res;
+function featureRequest(featureName, userId, appId) {
 	var req = {};
 	req.subjectInfo = {};
 	req.widgetInfo = {};
@@ -175,9 +185,7 @@ function checkFeature(featureName, userId, appId) {
 	req.subjectInfo.userId = userId;
 	req.widgetInfo.id = appId;
 	req.resourceInfo.apiFeature = featureName;
-	res = pm.enforceRequest(req, "testSession", true);
-	return(ruleEffectDescription(res));
-	//return(res);
+	return req;
 }
 
 function ruleEffectDescription(num) {